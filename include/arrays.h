@@ -0,0 +1,120 @@
+#ifndef ARRAYS_H
+#define ARRAYS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "interner.h"
+#include "token.h"
+
+// Array values. Every script value is still one double: an array is a quiet
+// NaN whose payload tags it and holds the array's index and generation in an
+// ArrayHeap. No arithmetic produces these bit patterns (the backends check for
+// them before computing), so a value is an array exactly when the heap made it.
+// Arrays are immutable, so functions share them: passing one copies the handle.
+
+constexpr uint64_t ARRAY_TAG_MASK = 0xFFFF000000000000ULL;
+constexpr uint64_t ARRAY_TAG = 0x7FFA000000000000ULL;
+
+inline bool isArrayValue(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & ARRAY_TAG_MASK) == ARRAY_TAG;
+}
+
+// Contiguous, cache-line aligned storage for the arrays of one backend.
+//
+// Handles are plain doubles the heap cannot see being copied, so arrays are
+// reclaimed by mark and sweep: once enough has been allocated the owner marks
+// every value it can still reach and sweeps the rest. A handle to a swept array
+// is detected by its generation and reported instead of read.
+class ArrayHeap {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    // Bytes allocated since the last sweep before the owner is asked to collect
+    static constexpr size_t MIN_COLLECTION_BYTES = 1 << 20;
+
+    struct View {
+        const double* data;
+        size_t length;
+    };
+
+    ArrayHeap() = default;
+    ArrayHeap(const ArrayHeap&) = delete;
+    ArrayHeap& operator=(const ArrayHeap&) = delete;
+    ~ArrayHeap();
+
+    // A new array of length elements for the caller to fill in
+    double allocate(size_t length, double*& data);
+    double make(const double* values, size_t length);
+
+    // Throws "Not an array" for other values and "Stale array" for swept ones
+    View view(double handle) const;
+
+    bool wantsCollection() const { return allocatedSinceSweep >= collectionThreshold; }
+    void mark(double value);
+    // Frees every array not marked since the previous sweep
+    void sweep();
+
+    size_t liveCount() const { return entries.size() - freeList.size(); }
+    size_t liveBytes() const { return bytesLive; }
+
+private:
+    struct Entry {
+        double* data = nullptr;
+        size_t length = 0;
+        uint16_t generation = 0;
+        bool live = false;
+        bool marked = false;
+    };
+
+    // Storage of swept arrays kept for reuse, so a loop of element-wise
+    // operations does not map and fault in fresh pages for every result
+    static constexpr size_t MAX_SPARE_BLOCKS = 8;
+    struct Block {
+        double* data;
+        size_t bytes;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeList;
+    std::vector<Block> spareBlocks;
+    size_t bytesLive = 0;
+    size_t allocatedSinceSweep = 0;
+    size_t collectionThreshold = MIN_COLLECTION_BYTES;
+
+    const Entry* find(double handle) const;
+    double* allocateStorage(size_t bytes);
+    void releaseStorage(double* data, size_t bytes);
+};
+
+// Element-wise + - * / % ^ on two arrays of the same length, or on an array
+// and a number. Each runs as one vectorized kernel over the whole array.
+// Division by a zero element throws "Division by zero", as for numbers.
+double arrayArithmetic(ArrayHeap& heap, TokenType op, double left, double right);
+double arrayNegate(ArrayHeap& heap, double array);
+
+// Reductions. sum and dot add in interleaved partial sums, so they can differ
+// from a left-to-right loop in the last bits.
+double arraySum(const ArrayHeap& heap, double array);
+double arrayMin(const ArrayHeap& heap, double array);
+double arrayMax(const ArrayHeap& heap, double array);
+double arrayDot(const ArrayHeap& heap, double left, double right);
+
+// Functions on arrays every program can call. A function the program defines
+// with the same name takes their place.
+enum class ArrayBuiltin : uint8_t {
+    NONE,
+    LEN,
+    SUM,
+    MIN,
+    MAX,
+    DOT,
+};
+
+ArrayBuiltin findArrayBuiltin(Symbol symbol);
+// Checks the argument count as for a user function
+double callArrayBuiltin(const ArrayHeap& heap, ArrayBuiltin builtin, Symbol symbol, const double* args, size_t argc);
+
+#endif // ARRAYS_H
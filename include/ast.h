@@ -1,20 +1,105 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstddef>
+#include <cstdint>
+#include <new>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "token.h"
 
 // Forward declarations
 class AST;
-using ASTPtr = std::unique_ptr<AST>;
+class ASTArena;
+
+// Deleter for AST links. Nodes built by the Parser live in an ASTArena: child
+// links only borrow them, and the root link owns the arena, so a whole tree is
+// released in one step without recursing through its depth. Nodes created with
+// std::make_unique are still deleted individually.
+struct ASTDeleter {
+    ASTArena* ownedArena = nullptr;
+    bool borrowed = false;
+
+    ASTDeleter() noexcept = default;
+    template <typename T>
+    ASTDeleter(const std::default_delete<T>&) noexcept {}
+
+    static ASTDeleter borrowing() noexcept;
+    static ASTDeleter owning(ASTArena* arena) noexcept;
+
+    void operator()(AST* node) const;
+};
+
+using ASTPtr = std::unique_ptr<AST, ASTDeleter>;
+
+// Node kind tag, so passes can dispatch with a switch instead of dynamic_cast
+enum class NodeType {
+    BIN_OP,
+    NUM,
+    UNARY_OP,
+    COMPOUND,
+    ASSIGN,
+    VAR,
+    NO_OP,
+    FUNCTION_DEF,
+    FUNCTION_CALL,
+    CLASS_DEF,
+    RETURN,
+    IF_STATEMENT,
+    WHILE_STATEMENT,
+    ARRAY_LITERAL,
+    INDEX,
+};
 
 class AST {
 public:
+    const NodeType type;
+
+    explicit AST(NodeType type) noexcept : type(type) {}
     virtual ~AST() = default;
 };
 
+// Bump allocator for AST nodes. Nodes are carved out of large contiguous
+// blocks in creation order and destroyed together when the arena goes away.
+class ASTArena {
+public:
+    ASTArena() = default;
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+    ~ASTArena();
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* node = new (memory) T(std::forward<Args>(args)...);
+        nodes.push_back(node);
+        return node;
+    }
+
+    // Wraps a new arena node in a link that borrows it
+    template <typename T, typename... Args>
+    ASTPtr makePtr(Args&&... args) {
+        return ASTPtr(make<T>(std::forward<Args>(args)...), ASTDeleter::borrowing());
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+    size_t bytesAllocated() const { return blockBytes; }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t blockBytes = 0;
+    std::vector<AST*> nodes;
+
+    void* allocate(size_t size, size_t alignment);
+};
+
 class BinOp : public AST {
 public:
     ASTPtr left;
@@ -26,10 +111,10 @@ public:
 
 class Num : public AST {
 public:
-    Token token;
     double value;
 
-    Num(Token token);
+    Num(const Token& token);
+    explicit Num(double value) noexcept;
 };
 
 class UnaryOp : public AST {
@@ -59,10 +144,13 @@ public:
 
 class Var : public AST {
 public:
-    Token token;
-    std::string value;
+    Symbol symbol;
+    std::string_view value; // Interned name
+    // Filled in by the Resolver: SymbolTable depth and slot of the variable
+    int depth = -1;
+    int slot = -1;
 
-    Var(Token token);
+    Var(const Token& token);
 };
 
 class NoOp : public AST {
@@ -73,27 +161,46 @@ public:
 // New AST Nodes
 class FunctionDef : public AST {
 public:
-    std::string name;
-    std::vector<std::string> params;
+    Symbol symbol;
+    std::string_view name; // Interned name
+    std::vector<Symbol> params;
     ASTPtr body;
+    int numLocals = 0; // Frame size (parameters first), filled in by the Resolver
 
-    FunctionDef(const std::string& name, const std::vector<std::string>& params, ASTPtr body);
+    FunctionDef(Symbol symbol, std::vector<Symbol> params, ASTPtr body);
 };
 
+// The current definition of each function name. Keyed by symbol rather than
+// indexed by it: symbols are process-wide and keep growing, a program's
+// functions are few.
+using FunctionTable = std::unordered_map<Symbol, FunctionDef*>;
+
+inline FunctionDef* findDefinition(const FunctionTable& functions, Symbol symbol) {
+    auto found = functions.find(symbol);
+    return found == functions.end() ? nullptr : found->second;
+}
+
 class FunctionCall : public AST {
 public:
-    std::string name;
+    Symbol symbol;
+    std::string_view name; // Interned name
     std::vector<ASTPtr> args;
+    // Inline cache filled in by the Interpreter: the callee this site resolved
+    // to, already checked against the argument count, and the version of the
+    // function table it was resolved in
+    FunctionDef* cachedCallee = nullptr;
+    uint64_t cachedVersion = 0;
 
-    FunctionCall(const std::string& name, std::vector<ASTPtr> args);
+    FunctionCall(Symbol symbol, std::vector<ASTPtr> args);
 };
 
 class ClassDef : public AST {
 public:
-    std::string name;
+    Symbol symbol;
+    std::string_view name; // Interned name
     std::vector<ASTPtr> methods;
 
-    ClassDef(const std::string& name, std::vector<ASTPtr> methods);
+    ClassDef(Symbol symbol, std::vector<ASTPtr> methods);
 };
 
 class Return : public AST {
@@ -112,5 +219,33 @@ public:
     IfStatement(ASTPtr condition, ASTPtr thenBranch, ASTPtr elseBranch = nullptr);
 };
 
+// Runs the body in the enclosing frame for as long as the condition holds.
+// A loop is a statement: its value is 0, unless a return inside it completes
+// the enclosing function or program. The Parser also lowers for loops to it.
+class WhileStatement : public AST {
+public:
+    ASTPtr condition;
+    ASTPtr body;
+
+    WhileStatement(ASTPtr condition, ASTPtr body);
+};
+
+// [e1, e2, ...]: a new array of the values of its elements, which must be numbers
+class ArrayLiteral : public AST {
+public:
+    std::vector<ASTPtr> elements;
+
+    explicit ArrayLiteral(std::vector<ASTPtr> elements);
+};
+
+// array[index], with a zero-based integral index
+class Index : public AST {
+public:
+    ASTPtr array;
+    ASTPtr index;
+
+    Index(ASTPtr array, ASTPtr index);
+};
+
 
 #endif // AST_H
@@ -0,0 +1,88 @@
+#ifndef BATCHEVALUATOR_H
+#define BATCHEVALUATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ast.h"
+#include "symboltable.h"
+
+// Runs one function over whole columns of arguments at once.
+//
+// The body is compiled to a flat list of column operations evaluated over
+// blocks of rows, each a vectorized kernel (AVX2 or SSE where the CPU has it).
+// Control flow becomes lane masks: both branches of an if run, each under its
+// own mask, assignments and results are blended in with masked selects, and a
+// return retires its lanes. Only functions whose bodies do arithmetic,
+// comparisons, ifs, returns, assignments to locals and reads of locals they
+// have certainly assigned or of globals are supported; anything else, calls,
+// loops and arrays included, is left to per-row evaluation by the Interpreter.
+class BatchEvaluator {
+public:
+    static constexpr size_t BLOCK_SIZE = 512;
+
+    explicit BatchEvaluator(FunctionDef* function);
+
+    bool isSupported() const { return supported; }
+
+    // columns holds one array of rows values per parameter. Returns false
+    // without writing anything if a global the body reads is unassigned or an
+    // array; throws
+    // "Division by zero" if any row divides by zero, leaving out unspecified.
+    bool run(const std::vector<const double*>& columns, size_t rows, double* out, const SymbolTable& symbolTable);
+
+private:
+    enum class OpKind {
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        MODULUS,
+        POWER,
+        NEGATE,
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        TRUTH,    // mask dst = value a != 0
+        AND,      // mask dst = mask a & mask b
+        AND_NOT,  // mask dst = mask a & ~mask b
+        OR,       // mask dst = mask a | mask b
+        SELECT,   // dst = mask ? a : b
+        STORE,    // dst = mask ? a : dst
+        RETURN,   // returned values = mask ? a : returned values; clears mask
+    };
+
+    // Operands index the value columns, or the mask columns where noted above
+    struct Op {
+        OpKind kind;
+        int dst;
+        int a;
+        int b;
+        int mask;
+    };
+
+    FunctionDef* function;
+    bool supported;
+    std::vector<Op> ops;
+
+    // Value columns: the function's locals first, then constants, globals and temporaries
+    int valueColumns;
+    int maskColumns;
+    std::vector<std::pair<int, double>> constants;  // column, value
+    std::vector<std::pair<int, int>> globals;       // column, global slot
+    int returnColumn;
+    int bodyColumn = -1;
+    std::vector<bool> assigned;                     // locals certainly assigned at this point
+
+    int newValue() { return valueColumns++; }
+    int newMask() { return maskColumns++; }
+    int constant(double value);
+
+    // Each returns the column holding the node's value, or -1 if unsupported
+    int compile(AST* node, int mask);
+    int compileBinOp(BinOp* node, int mask);
+    int compileIf(IfStatement* node, int mask);
+};
+
+#endif // BATCHEVALUATOR_H
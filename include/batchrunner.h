@@ -0,0 +1,50 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Outcome of one script: its final value, or the message of the error that stopped it
+struct BatchResult {
+    std::string script;
+    double value = 0.0;
+    std::string error;
+
+    bool succeeded() const { return error.empty(); }
+};
+
+// Runs many independent scripts on a pool of worker threads.
+//
+// Every script is lexed, parsed, optimized and run on the worker that picked it,
+// with a fresh Interpreter (and so SymbolTable) of its own; the only state the
+// workers share is the thread-safe global Interner. Results come back in input
+// order whatever order the scripts finished in.
+class BatchRunner {
+public:
+    // workers == 0 uses one worker per hardware thread
+    explicit BatchRunner(unsigned workers = 0);
+
+    unsigned getWorkerCount() const { return workers; }
+
+    // Scripts are read from disk by the worker that runs them
+    std::vector<BatchResult> runFiles(const std::vector<std::string>& paths) const;
+    // Named in-memory sources: {name, source} pairs
+    std::vector<BatchResult> runSources(const std::vector<std::pair<std::string, std::string>>& sources) const;
+
+    // A directory lists its regular files in name order; any other path is a
+    // manifest naming one script per line, relative to the manifest's directory.
+    // Throws std::runtime_error if the path cannot be read.
+    static std::vector<std::string> listScripts(const std::string& path);
+
+    // One tab-separated line per result: script, final value, error
+    static void writeResults(std::ostream& out, const std::vector<BatchResult>& results);
+
+private:
+    unsigned workers;
+
+    std::vector<BatchResult> runAll(size_t count, const std::function<BatchResult(size_t)>& runOne) const;
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,81 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "interner.h"
+#include "symboltable.h"
+
+// Instruction set of the stack-based virtual machine.
+// Operands follow the opcode byte inline, little-endian.
+enum class OpCode : uint8_t {
+    CONSTANT,        // f64 value
+    LOAD_LOCAL,      // u16 slot
+    STORE_LOCAL,     // u16 slot (leaves the value on the stack)
+    LOAD_GLOBAL,     // u32 global slot
+    STORE_GLOBAL,    // u32 global slot (leaves the value on the stack)
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    MODULUS,
+    POWER,
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    NEGATE,
+    POP,
+    JUMP,            // u32 absolute target
+    JUMP_IF_FALSE,   // u32 absolute target, pops the condition
+    CALL,            // u32 function slot, u8 argument count
+    TAIL_CALL,       // u32 function slot, u8 argument count; replaces the current frame
+    RETURN,
+    DEFINE_FUNCTION, // u32 function index, u32 function slot
+    DEFINE_CLASS,    // u32 symbol
+};
+
+// Dense slots for the names a machine's code refers to, numbered in the order
+// the BytecodeCompiler meets them. Symbols are process-wide, so a table indexed
+// by them would grow with every name any program interned.
+class SymbolSlots {
+public:
+    uint32_t slotFor(Symbol name) {
+        auto [it, inserted] = slots.try_emplace(name, static_cast<uint32_t>(names.size()));
+        if (inserted) {
+            names.push_back(name);
+        }
+        return it->second;
+    }
+    int find(Symbol name) const {
+        auto found = slots.find(name);
+        return found == slots.end() ? -1 : static_cast<int>(found->second);
+    }
+    Symbol name(uint32_t slot) const { return names[slot]; }
+    size_t size() const { return names.size(); }
+
+private:
+    std::unordered_map<Symbol, uint32_t> slots;
+    std::vector<Symbol> names; // symbol of each slot
+};
+
+// A compiled function, or the top-level script when arity is zero and it has no locals
+struct FunctionProto {
+    Symbol nameId = NO_SYMBOL;
+    std::string name;
+    uint16_t arity = 0;
+    uint16_t numLocals = 0;           // parameters first, then assigned locals
+    uint32_t maxStack = 0;            // operand stack high-water mark
+    std::vector<Symbol> localNames;   // name of each slot
+    std::vector<uint8_t> code;
+};
+
+// Human-readable listing of a function's code, for debugging the compiler
+std::string disassemble(const FunctionProto& proto);
+
+#endif // BYTECODE_H
@@ -0,0 +1,61 @@
+#ifndef BYTECODE_COMPILER_H
+#define BYTECODE_COMPILER_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "bytecode.h"
+
+// Lowers an AST produced by Parser::parse() to bytecode for the VirtualMachine.
+// Every statement leaves a value on the stack, mirroring what the Interpreter's
+// visit methods return, so both backends compute the same program result.
+class BytecodeCompiler {
+public:
+    // Globals and functions are referred to by the slots the two maps give their
+    // names, adding slots for names the maps have not met yet
+    BytecodeCompiler(std::vector<std::unique_ptr<FunctionProto>>& functions, SymbolSlots& globalSlots,
+                     SymbolSlots& functionSlots);
+
+    // Compiles the top-level program. Function definitions found anywhere in the
+    // tree are appended to the function list and referenced by index.
+    std::unique_ptr<FunctionProto> compile(AST* tree);
+
+private:
+    struct FunctionState {
+        FunctionProto* proto;
+        bool isScript;
+        std::unordered_map<Symbol, uint16_t> slots;
+        uint32_t stackDepth = 0;
+
+        FunctionState(FunctionProto* proto, bool isScript) : proto(proto), isScript(isScript) {}
+    };
+
+    std::vector<std::unique_ptr<FunctionProto>>& functions;
+    SymbolSlots& globalSlots;
+    SymbolSlots& functionSlots;
+    FunctionState* current = nullptr;
+
+    uint32_t compileFunction(FunctionDef* node);
+    void collectLocals(AST* node);
+    uint16_t addLocal(Symbol name);
+
+    void compileNode(AST* node);
+    void compileBinOp(BinOp* node);
+    void compileUnaryOp(UnaryOp* node);
+    void compileCompound(Compound* node);
+    void compileAssign(Assign* node);
+    void compileVar(Var* node);
+    void compileFunctionCall(FunctionCall* node, OpCode op = OpCode::CALL);
+    void compileIfStatement(IfStatement* node);
+    void compileWhileStatement(WhileStatement* node);
+
+    void emit(OpCode op, int stackEffect);
+    void emitConstant(double value);
+    template <typename T>
+    void emitOperand(T value);
+    size_t emitJump(OpCode op);
+    void patchJump(size_t operandOffset);
+};
+
+#endif // BYTECODE_COMPILER_H
@@ -0,0 +1,150 @@
+#ifndef CLOSURECOMPILER_H
+#define CLOSURECOMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast.h"
+#include "symboltable.h"
+#include "resolver.h"
+
+// Bump allocator for the closures of one compiled program. Closures are
+// destroyed together when the arena goes away.
+class ClosureArena {
+public:
+    ClosureArena() = default;
+    ClosureArena(const ClosureArena&) = delete;
+    ClosureArena& operator=(const ClosureArena&) = delete;
+    ~ClosureArena();
+
+    template <typename T>
+    T* make(T value) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = new (memory) T(std::move(value));
+        if (!std::is_trivially_destructible<T>::value) {
+            destructors.emplace_back(object, [](void* p) { static_cast<T*>(p)->~T(); });
+        }
+        return object;
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    std::vector<std::pair<void*, void (*)(void*)>> destructors;
+
+    void* allocate(size_t size, size_t alignment);
+};
+
+// A compiled node: a function pointer and the state it was specialized with
+template <typename Result>
+struct CompiledNode {
+    Result (*invoke)(const void* state);
+    const void* state;
+
+    Result operator()() const { return invoke(state); }
+
+    // Moves a callable into the arena
+    template <typename F>
+    static CompiledNode make(ClosureArena& arena, F function) {
+        const F* stored = arena.make<F>(std::move(function));
+        return {[](const void* state) -> Result { return (*static_cast<const F*>(state))(); }, stored};
+    }
+};
+
+using Closure = CompiledNode<double>;
+using Condition = CompiledNode<bool>;
+
+// Backend that compiles the tree once into nested closures and then runs them,
+// with the same observable behaviour as the Interpreter.
+//
+// Each closure is specialized for its node when it is built: operators,
+// constant operands, local or global variables, comparisons used as conditions
+// and calls in tail position each get their own closure, so nothing is
+// dispatched on node or token types while the program runs. The closures of a
+// program live in an arena that is kept for as long as the backend when the
+// program defined functions, and freed after the run otherwise; they keep no
+// pointers into the tree.
+class ClosureCompiler {
+public:
+    ClosureCompiler();
+    double interpret(ASTPtr& tree);
+    // True when the last run ended at a top-level return
+    bool returned() const { return topLevelReturn; }
+
+    double getVariableValue(const std::string& name) const;
+
+private:
+    struct CompiledFunction {
+        std::string_view name; // Interned name
+        size_t arity;
+        int numLocals;
+        Closure body;
+    };
+
+    // A call site's callee, cached until the function table changes
+    struct CallSite {
+        Symbol symbol;
+        std::string_view name;
+        size_t argCount;
+        CompiledFunction* callee = nullptr;
+        uint64_t version = 0;
+    };
+
+    // As in the Interpreter: a return stops the enclosing compounds, and a
+    // tail call leaves its callee and arguments for the receiving call
+    enum class Completion {
+        NORMAL,
+        RETURN,
+        TAIL_CALL,
+    };
+
+    // Arguments of calls with at most this many are evaluated on the C++ stack
+    static constexpr size_t INLINE_ARGS = 4;
+
+    SymbolTable symbolTable;
+    Resolver resolver;
+    std::vector<std::unique_ptr<CompiledFunction>> compiledFunctions; // every definition compiled so far
+    std::unordered_map<Symbol, CompiledFunction*> functions;          // by the name they are defined as
+    std::vector<std::unique_ptr<ClosureArena>> definitionArenas;      // arenas holding function bodies
+    ClosureArena* arena;                                              // arena of the program being compiled
+    uint64_t functionsVersion;
+
+    Completion completion;
+    bool topLevelReturn;
+    CompiledFunction* tailCallee;
+    std::vector<double> tailArgs;
+
+    int recursionDepth;
+    const int MAX_RECURSION_DEPTH = 1000;
+
+    Closure compile(AST* node);
+    Closure compileBinOp(BinOp* node);
+    Condition compileCondition(AST* node);
+    Closure compileVar(Var* node);
+    Closure compileAssign(Assign* node);
+    Closure compileCompound(Compound* node);
+    Closure compileFunctionDef(FunctionDef* node);
+    Closure compileCall(FunctionCall* node, bool isReturned);
+    Closure compileIf(IfStatement* node);
+    Closure compileWhile(WhileStatement* node);
+
+    template <typename F>
+    Closure make(F function) {
+        return Closure::make(*arena, std::move(function));
+    }
+
+    CompiledFunction* resolveCall(CallSite& site);
+    double callFunction(CompiledFunction* function, const double* args);
+};
+
+#endif // CLOSURECOMPILER_H
@@ -0,0 +1,42 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Small integer id of an interned identifier
+using Symbol = uint32_t;
+constexpr Symbol NO_SYMBOL = std::numeric_limits<Symbol>::max();
+
+// Process-wide identifier table shared by every Lexer, so names are hashed once
+// at lex time and compared, stored and looked up as dense Symbol ids afterwards.
+// Interned text is never freed, so views returned by name() stay valid for the
+// lifetime of the process. Safe to use from several threads.
+class Interner {
+public:
+    static Interner& global();
+
+    Symbol intern(std::string_view text);
+    // NO_SYMBOL if the text has never been interned
+    Symbol find(std::string_view text) const;
+    std::string_view name(Symbol symbol) const;
+    size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> storage; // a deque never moves its elements
+    std::unordered_map<std::string_view, Symbol> symbols; // keys view storage
+};
+
+// Shorthands for the global table. Each thread keeps a cache of the symbols and
+// names it has already looked up, so hot lexing and error paths on worker
+// threads take no lock.
+Symbol intern(std::string_view text);
+std::string_view symbolName(Symbol symbol);
+
+#endif // INTERNER_H
@@ -1,33 +1,127 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "arrays.h"
 #include "ast.h"
 #include "symboltable.h"
-#include <unordered_map>
+#include "resolver.h"
+#include "memoizer.h"
+#include "jit.h"
+#include "profiler.h"
+#include <memory>
+#include <optional>
 #include <string>
-
-// Custom exception for return statements
-class ReturnException : public std::exception {
-public:
-    double value;
-    ReturnException(double val) : value(val) {}
-};
+#include <unordered_map>
+#include <vector>
 
 class Interpreter {
 public:
     Interpreter();
     double interpret(ASTPtr& tree);
+    // Runs one top-level statement from Parser::parseStatement and frees its
+    // tree, unless running it defined a function or class that still points into it
+    double interpretStatement(ASTPtr statement);
+    // True when the last run ended at a top-level return, so a caller running
+    // a program statement by statement stops there
+    bool returned() const { return topLevelReturn; }
 
     double getVariableValue(const std::string& name) const;
 
+    // Arrays to and from the host. A global set here is an array like one
+    // built by a literal; arrayElements copies out any array value, such as
+    // the result of interpret(), which stays valid until the next run starts.
+    void setArray(const std::string& name, const std::vector<double>& values);
+    std::vector<double> getArrayValue(const std::string& name) const;
+    std::vector<double> arrayElements(double value) const;
+    size_t getArrayCount() const { return arrays.liveCount(); }
+
+    // Calls a function defined by an earlier run with the given arguments
+    double call(const std::string& function, const std::vector<double>& args);
+    // Calls a function once per row, columns holding one array of rows values
+    // per parameter, and writes the results to out. Runs the rows through a
+    // BatchEvaluator when the function's body allows it and profiling is off,
+    // and one call at a time otherwise; returns true if the rows were evaluated as columns.
+    bool evaluateBatch(const std::string& function, const std::vector<const double*>& columns, size_t rows,
+                       double* out);
+
+    // Opt-in: serve calls to pure functions from per-function result caches.
+    // A cached call takes no stack frame, so it cannot hit the recursion limit.
+    void enableMemoization(size_t maxEntriesPerFunction = Memoizer::DEFAULT_MAX_ENTRIES);
+    MemoStats getMemoStats() const;
+
+    // Opt-in: compile functions to native code once they have been called
+    // hotThreshold times. Ignored while memoization or profiling is enabled.
+    void enableJit(unsigned hotThreshold = Jit::DEFAULT_HOT_THRESHOLD);
+    size_t getJitCompiledCount() const;
+
+    // Opt-in: record call counts and times per function and execution counts
+    // per node. Null until enabled.
+    void enableProfiling();
+    const Profiler* getProfiler() const { return profiler.get(); }
+
 private:
     SymbolTable symbolTable;
-    std::unordered_map<std::string, FunctionDef*> functions;
-    std::unordered_map<std::string, ClassDef*> classes;
+    Resolver resolver;
+    FunctionTable functions;
+    // Changes whenever a function is defined. Versions are unique across
+    // interpreters, so a call site cached by one never validates in another.
+    uint64_t functionsVersion;
+    std::unordered_map<Symbol, ClassDef*> classes;
+    // Statement trees kept alive for the definitions they made
+    std::vector<ASTPtr> definitionTrees;
+    size_t definitionsRun;
+
+    // How the statement that just finished completed. A return stops the
+    // enclosing compounds and is cleared by the function call that receives it.
+    // A tail call unwinds the same way, leaving the callee and its arguments in
+    // tailCallee/tailArgs for the receiving call to run in the frame it owns.
+    enum class Completion {
+        NORMAL,
+        RETURN,
+        TAIL_CALL,
+    };
+    Completion completion;
+    bool topLevelReturn;
+    FunctionDef* tailCallee;
+    std::vector<double> tailArgs;
+
+    // Arrays the program created. Collected at safe points, the start of a
+    // run, loop back edges and function entries, from the slots of the SymbolTable, the arguments
+    // of a pending tail call and the pinned values: arrays held in C++ locals
+    // while other code runs, such as the left operand of a binary operation.
+    ArrayHeap arrays;
+    std::vector<double> pinned;
+
+    std::optional<Memoizer> memoizer;
+    // Reads that fell back from an unassigned local to a global; a call that
+    // made any is not cached, since its result depended on global state
+    size_t globalFallbacks;
+
+    std::unique_ptr<Jit> jit;
+    std::unique_ptr<Profiler> profiler;
 
     int recursionDepth;
     const int MAX_RECURSION_DEPTH = 1000;
 
+    void resetRun();
+    std::vector<double> evaluateArgs(FunctionCall* node);
+    // Null when the call goes to an array builtin
+    FunctionDef* resolveCall(FunctionCall* node);
+    FunctionDef* findFunction(const std::string& name) const;
+    void checkArity(FunctionDef* funcDef, size_t argCount) const;
+    // The caller has checked the arity
+    double callFunction(FunctionDef* funcDef, const std::vector<double>& argValues);
+    double runNative(NativeFunction entry, FunctionDef* funcDef, const std::vector<double>& argValues);
+    double callBuiltin(Symbol symbol, const std::vector<double>& argValues) const;
+    void collectArraysIfDue() {
+        if (arrays.wantsCollection()) {
+            collectArrays();
+        }
+    }
+    void collectArrays();
+    // Entry-table fallback: runs a call made by native code in the interpreter
+    static double callFromNative(JitContext* context, const double* args, Symbol symbol, uint32_t argc);
+
     // Visit methods
     double visit(AST* node);
     double visitBinOp(BinOp* node);
@@ -42,6 +136,9 @@ private:
     double visitClassDef(ClassDef* node);
     double visitReturn(Return* node);
     double visitIfStatement(IfStatement* node);
+    double visitWhileStatement(WhileStatement* node);
+    double visitArrayLiteral(ArrayLiteral* node);
+    double visitIndex(Index* node);
 };
 
 #endif // INTERPRETER_H
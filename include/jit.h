@@ -0,0 +1,113 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast.h"
+
+class Interpreter;
+
+// Why native code returned early. Native frames have no unwind information, so
+// errors travel back to the C++ caller as a status and are thrown from there.
+enum class JitError : int32_t {
+    NONE,
+    RECURSION_DEPTH,
+    ARGUMENT_COUNT,
+    DIVISION_BY_ZERO,
+    EXCEPTION, // thrown by interpreted code called from native code; see Jit::takePendingException()
+    ARRAY_VALUE, // interpreted code returned an array, which native code cannot hold
+};
+
+struct JitContext;
+
+// Calling convention of every entry in the native call table: compiled
+// functions and the interpreter fallback alike
+using NativeFunction = double (*)(JitContext* context, const double* args, Symbol symbol, uint32_t argc);
+
+// State shared by native code and the Interpreter. Generated code addresses the
+// fields by offset, so this must stay standard-layout.
+struct JitContext {
+    int* recursionDepth;
+    int32_t maxRecursionDepth;
+    JitError error;
+    Symbol errorSymbol;
+    const NativeFunction* entries; // indexed by Jit::slotFor()
+    Interpreter* interpreter;
+};
+
+// Compiles hot user functions to x86-64 SSE2 code in executable mmap'd memory.
+//
+// A function is compiled once it has been called hotThreshold times, if its
+// body only does double arithmetic, comparisons, ifs, assignments and calls on
+// its own frame, never reads a local before assigning it, and makes no tail
+// calls other than to itself. Anything else stays interpreted. Native code
+// computes exactly what the Interpreter would: the same SSE2 operations and the
+// same fmod/pow, with the recursion limit, argument count and division-by-zero
+// checks done in the same order.
+//
+// Calls from native code go through an entry table with a slot per function
+// name, straight to the callee's native code when it has some, otherwise to the
+// fallback that runs it in the Interpreter. Slots are handed out as functions
+// are called or compiled, so the table grows with the program's functions
+// rather than with every symbol the process has interned. Self tail calls
+// become jumps.
+//
+// Native code only holds numbers. Calls with array arguments stay interpreted,
+// and a function whose interpreted callee returns an array is excluded and the
+// call rerun in the Interpreter.
+class Jit {
+public:
+    static constexpr unsigned DEFAULT_HOT_THRESHOLD = 2;
+
+    Jit(unsigned hotThreshold, NativeFunction fallback);
+    ~Jit();
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // False on targets without a code generator; every function then stays interpreted
+    static bool isSupported();
+
+    // Counts a call and returns the function's native code, compiling it when hot; null to interpret
+    NativeFunction entryFor(FunctionDef* function);
+
+    // The entry table slot of a function name, added on first use. The table
+    // may move then; native code reloads it from the context for every call.
+    uint32_t slotFor(Symbol symbol);
+    // Drops every compiled function, e.g. after a redefinition. Code already
+    // running stays mapped until the Jit is destroyed.
+    void invalidate();
+    // Keeps a function interpreted from now on, e.g. once native code met an array in it
+    void exclude(FunctionDef* function);
+
+    JitContext& getContext() { return context; }
+    size_t getCompiledCount() const { return compiledCount; }
+
+    void setPendingException(std::exception_ptr exception) { pendingException = std::move(exception); }
+    std::exception_ptr takePendingException() { return std::exchange(pendingException, nullptr); }
+
+private:
+    struct FunctionState {
+        FunctionDef* definition = nullptr;
+        unsigned calls = 0;
+        NativeFunction entry = nullptr;
+        bool unsupported = false;
+    };
+
+    unsigned hotThreshold;
+    NativeFunction fallback;
+    std::unordered_map<Symbol, uint32_t> slots;
+    std::vector<NativeFunction> entries;  // indexed by slot
+    std::vector<FunctionState> functions; // indexed by slot
+    std::vector<std::pair<void*, size_t>> regions;
+    JitContext context;
+    std::exception_ptr pendingException;
+    size_t compiledCount;
+
+    NativeFunction compile(FunctionDef* function);
+};
+
+#endif // JIT_H
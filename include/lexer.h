@@ -1,23 +1,47 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <istream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "token.h"
-#include <unordered_map>
 
+// Tokenizes a borrowed buffer without copying it; the caller keeps the text
+// alive for as long as the lexer and its tokens are in use.
+//
+// A lexer over a stream instead reads it chunkSize bytes at a time and drops
+// text it has already tokenized, so it holds at most one chunk plus the token
+// being scanned. Tokens own nothing, so they stay usable after their text is
+// dropped; only the spelling of a number is lost, and tokenText() then
+// formats the value instead.
 class Lexer {
 public:
-    Lexer(const std::string& text);
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    Lexer(std::string_view text);
+    Lexer(std::istream& in, size_t chunkSize = DEFAULT_CHUNK_SIZE);
     Token getNextToken();
 
+    // Spelling of a token from this lexer: the interned name of an identifier,
+    // the fixed text of a keyword or operator, and the source text of a number
+    std::string tokenText(const Token& token) const;
+
 private:
-    std::string text;
+    std::string_view text;
     size_t pos;
     char currentChar;
 
-    std::unordered_map<std::string, TokenType> keywords;
+    // Streaming input only
+    std::istream* in = nullptr;
+    size_t chunkSize = 0;
+    std::string buffer;
+    size_t tokenStart = 0; // Text from here on is kept by the next refill
+    size_t dropped = 0;    // Stream bytes before the start of the buffer
 
+    bool refill();
+    Token make(TokenType type) const;
+    Token numberToken(TokenType type) const;
     void advance();
     void skipWhitespace();
     Token integer();
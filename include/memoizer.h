@@ -0,0 +1,78 @@
+#ifndef MEMOIZER_H
+#define MEMOIZER_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arrays.h"
+#include "ast.h"
+#include "symboltable.h"
+
+// Hit/miss counters and current footprint of the memo caches
+struct MemoStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    double hitRate() const {
+        size_t calls = hits + misses;
+        return calls == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(calls);
+    }
+};
+
+// Result caches for pure user functions, used by the Interpreter when
+// memoization is enabled.
+//
+// A function is pure when its body only reads its own frame (parameters and
+// locals, as annotated by the Resolver), defines nothing, and calls only pure
+// functions. Results are keyed on the exact bits of the arguments. Every
+// function definition invalidates all caches and purity verdicts, since a pure
+// caller may reach the redefined function.
+class Memoizer {
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 4096;
+
+    explicit Memoizer(size_t maxEntriesPerFunction = DEFAULT_MAX_ENTRIES);
+
+    // functions is the Interpreter's function table
+    bool isPure(FunctionDef* function, const FunctionTable& functions);
+
+    // Null on a miss
+    const double* lookup(FunctionDef* function, const std::vector<double>& args);
+    void store(FunctionDef* function, const std::vector<double>& args, double result);
+
+    void invalidate();
+
+    const MemoStats& getStats() const { return stats; }
+
+private:
+    enum class Purity {
+        UNKNOWN,
+        IN_PROGRESS, // being analysed, or provisionally pure; recursive calls are assumed pure
+        PURE,
+        IMPURE,
+    };
+
+    struct FunctionMemo {
+        FunctionDef* definition = nullptr;
+        Purity purity = Purity::UNKNOWN;
+        std::unordered_map<std::string, double> results; // keyed on argument bytes
+    };
+
+    size_t maxEntries;
+    std::unordered_map<Symbol, FunctionMemo> memos;
+    MemoStats stats;
+    // Nesting of isPure() calls, and the functions found pure while an
+    // enclosing analysis was still in progress
+    int analysisDepth = 0;
+    std::vector<Symbol> provisional;
+
+    FunctionMemo& memoFor(FunctionDef* function);
+    bool bodyIsPure(AST* node, const FunctionTable& functions);
+    static std::string makeKey(const std::vector<double>& args);
+    static size_t entryBytes(const std::string& key);
+};
+
+#endif // MEMOIZER_H
@@ -0,0 +1,34 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+
+// Constant folding and algebraic simplification over a parsed tree.
+//
+// Constant BinOp/UnaryOp subtrees (arithmetic and comparisons) become Num nodes
+// computed exactly as the Interpreter would, and identities that hold for every
+// IEEE double are removed: x * 1, 1 * x, x / 1, x - 0, x + (-0), +x and -(-x).
+// x + 0 is kept because it turns -0 into +0. Division by a constant zero is never
+// folded, so the "Division by zero" error still happens when the code runs.
+class Optimizer {
+public:
+    Optimizer();
+
+    // Rewrites the tree in place; new nodes go into the tree's arena when it has one
+    void optimize(ASTPtr& tree);
+
+    size_t getFoldedCount() const { return foldedCount; }
+
+private:
+    ASTArena* arena;
+    size_t foldedCount;
+
+    void optimizeChildren(AST* node);
+    void optimizeNode(ASTPtr& node);
+    void foldBinOp(ASTPtr& node);
+    void foldUnaryOp(ASTPtr& node);
+    ASTPtr makeNum(double value);
+    void replace(ASTPtr& node, ASTPtr replacement);
+};
+
+#endif // OPTIMIZER_H
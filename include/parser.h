@@ -8,17 +8,28 @@ class Parser {
 public:
     Parser(Lexer& lexer);
     ASTPtr parse(); // Parses the entire input as a program (compound statements)
+    // Parses the next top-level statement into a tree that owns its own arena;
+    // null at the end of input
+    ASTPtr parseStatement();
 
 private:
     Lexer& lexer;
     Token currentToken;
     Token nextToken; // Lookahead token
+    ASTArena* arena = nullptr; // Arena of the tree being built
+
+    template <typename T, typename... Args>
+    ASTPtr make(Args&&... args) {
+        return arena->makePtr<T>(std::forward<Args>(args)...);
+    }
 
     void eat(TokenType type);
     ASTPtr factor();
+    ASTPtr indexes(ASTPtr node);
     ASTPtr term();
     ASTPtr expr();
     ASTPtr statement();
+    ASTPtr simpleStatement();
     ASTPtr assignmentStatement();
     ASTPtr variable();
     ASTPtr program();  // Method for parsing multiple statements
@@ -29,6 +40,8 @@ private:
     ASTPtr expressionList();
     ASTPtr condition();
     ASTPtr ifStatement();
+    ASTPtr whileStatement();
+    ASTPtr forStatement();
 };
 
 #endif // PARSER_H
@@ -0,0 +1,117 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast.h"
+
+// Totals for one function, or for top-level code under Profiler::TOP_LEVEL.
+// Inclusive time counts a recursive function's outermost activation only.
+struct FunctionProfile {
+    std::string name;
+    uint64_t calls = 0;
+    double inclusiveSeconds = 0.0;
+    double exclusiveSeconds = 0.0;
+};
+
+struct NodeProfile {
+    std::string description; // node kind and operator or name, e.g. "BinOp *"
+    std::string function;    // where the node first ran
+    uint64_t count = 0;
+};
+
+// Call counts and wall time per function and execution counts per AST node,
+// recorded by the Interpreter when profiling is enabled.
+//
+// Time is attributed to call stacks as well as functions, so the profile can
+// be written in the folded-stack format flamegraph tools read: one line per
+// stack, frames joined by ';', followed by its exclusive time in microseconds.
+// Functions are identified by name, so all definitions of a name share totals.
+class Profiler {
+public:
+    static constexpr const char* TOP_LEVEL = "<top level>";
+
+    // NO_SYMBOL enters top-level code
+    void enter(Symbol function);
+    void leave();
+    void countNode(const AST* node);
+    // Counts are kept per node address, so they must be moved out of the way
+    // before a tree that ran is freed and a later one reuses its addresses.
+    // Released counts are added up by function and description.
+    void releaseTree(const AST* tree);
+
+    // Sorted by exclusive time, longest first
+    std::vector<FunctionProfile> getFunctionProfiles() const;
+    // Sorted by count, most executed first
+    std::vector<NodeProfile> getNodeProfiles() const;
+
+    void writeReport(std::ostream& out, size_t maxNodes = 20) const;
+    void writeFoldedStacks(std::ostream& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // A distinct call stack: the stack of its parent plus one function
+    struct Stack {
+        Symbol function;
+        int parent;
+        double exclusiveSeconds = 0.0;
+        std::unordered_map<Symbol, int> children;
+
+        Stack(Symbol function, int parent) : function(function), parent(parent) {}
+    };
+
+    struct Frame {
+        Symbol function;
+        int stack;
+        Clock::time_point start;
+        double childSeconds;
+    };
+
+    struct Totals {
+        uint64_t calls = 0;
+        double inclusiveSeconds = 0.0;
+        double exclusiveSeconds = 0.0;
+        int active = 0; // activations on the stack
+    };
+
+    std::vector<Stack> stacks;
+    std::vector<Frame> frames;
+    std::unordered_map<Symbol, Totals> totals;
+    std::unordered_map<const AST*, NodeProfile> nodes;
+    std::map<std::pair<std::string, std::string>, uint64_t> releasedNodes; // by function and description
+
+    static std::string functionName(Symbol function);
+    static std::string describe(const AST* node);
+    void releaseNode(const AST* node);
+    std::string stackPath(int stack) const;
+};
+
+// Enters a function for the lifetime of the scope, unwinding included;
+// does nothing without a profiler
+class ProfileScope {
+public:
+    ProfileScope(Profiler* profiler, Symbol function) : profiler(profiler) {
+        if (profiler) {
+            profiler->enter(function);
+        }
+    }
+    ~ProfileScope() {
+        if (profiler) {
+            profiler->leave();
+        }
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* profiler;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,56 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bytecode.h"
+#include "vm.h"
+
+// A program compiled once for embedding: parsed, optimized and compiled to
+// bytecode, with its top-level code run once to define its functions and
+// globals. It owns its code and keeps nothing of the source or the tree, and it
+// never changes after compile(), so one Program can be shared between threads.
+// Calls are made through an ExecutionContext.
+class Program {
+public:
+    // Throws std::runtime_error on syntax errors and on errors in the
+    // top-level code
+    static std::shared_ptr<const Program> compile(std::string_view source, bool optimize = true);
+
+    bool hasFunction(const std::string& name) const;
+    // Value the top-level code left in a global
+    double getVariableValue(const std::string& name) const;
+
+private:
+    friend class VirtualMachine;
+
+    Program() = default;
+
+    std::vector<std::unique_ptr<FunctionProto>> functionProtos;
+    MachineBindings bindings;
+};
+
+// State for calling into a shared Program from one thread: a value stack, and
+// the classes and functions its calls define, for this context only. It reads
+// everything else from the Program, so creating one copies none of the
+// Program's tables. Reusable for any number of calls, but not itself
+// thread-safe.
+class ExecutionContext {
+public:
+    explicit ExecutionContext(std::shared_ptr<const Program> program);
+
+    // Throws "Undefined function" and "Incorrect number of arguments" like a
+    // call in the program would, and any error the call raises
+    double call(const std::string& function, const double* args, size_t argCount);
+    double call(const std::string& function, const std::vector<double>& args) {
+        return call(function, args.data(), args.size());
+    }
+
+private:
+    std::shared_ptr<const Program> program;
+    VirtualMachine vm;
+};
+
+#endif // PROGRAM_H
@@ -0,0 +1,48 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "ast.h"
+
+// Parsed programs saved next to their source so later runs skip the Lexer and
+// Parser.
+//
+// A cache file holds a versioned header, the identifier names the tree uses
+// and the tree itself in preorder. The header records a hash and the size of
+// the source text and whether the tree was optimized; a file whose header does
+// not match the current source, format or optimization setting is stale, and
+// one whose contents fail their checksum or do not decode is corrupt. Either
+// way the program is parsed again and the file rewritten. Names are interned
+// on load, so a cache file is independent of the process that wrote it.
+class ProgramCache {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    enum class Status {
+        HIT,
+        MISSING,
+        STALE,
+        CORRUPT,
+    };
+
+    // <source>.mcache
+    static std::string cachePathFor(const std::string& sourcePath);
+
+    // Returns the program parsed from source (and optimized when asked), read
+    // from the cache file of sourcePath when that is current and written to it
+    // otherwise. Failing to write the cache is not an error.
+    static ASTPtr load(const std::string& sourcePath, std::string_view source, bool optimize,
+                       Status* status = nullptr);
+
+    static std::string serialize(const AST* tree, std::string_view source, bool optimized);
+    // Throws std::runtime_error if bytes are not a current cache for source
+    static ASTPtr deserialize(std::string_view bytes, std::string_view source, bool optimized,
+                              Status* status = nullptr);
+
+    // 64-bit FNV-1a
+    static uint64_t hash(std::string_view bytes);
+};
+
+#endif // PROGRAMCACHE_H
@@ -0,0 +1,56 @@
+#ifndef REPL_H
+#define REPL_H
+
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "interpreter.h"
+#include "optimizer.h"
+
+// Interactive session over one Interpreter that lives as long as the session.
+//
+// Input is collected line by line until it holds complete statements, then
+// parsed one top-level statement at a time and run with
+// Interpreter::interpretStatement. The interpreter keeps the trees of
+// statements that defined functions or classes, since its function table points
+// into them, and each other tree is freed once it has run. So the work for a
+// snippet depends on the snippet alone, not on how long the session has been
+// running: nothing earlier is parsed or run again.
+class Repl {
+public:
+    static constexpr const char* PROMPT = "> ";
+    static constexpr const char* CONTINUATION_PROMPT = "... ";
+
+    explicit Repl(Interpreter& interpreter, bool optimize = true);
+
+    // True once text ends a snippet: every bracket it opens is closed and its
+    // last token is ; or }. Text the Lexer rejects is complete, so the error
+    // is reported instead of waiting for more input.
+    static bool isComplete(std::string_view text);
+    // True when complete text ends with the block of an if that has no else,
+    // so the next line may still go on with one
+    static bool awaitsElse(std::string_view text);
+
+    // Parses and runs each statement of a snippet in turn. Returns the value of
+    // the last one, or nothing when it is a definition or an assignment.
+    // Statements before an error stay in effect, and a top-level return
+    // ends the snippet with its value.
+    std::optional<double> run(std::string_view snippet);
+
+    // The value as the session prints it: numbers in their shortest exact
+    // form, arrays as [a, b, ...]
+    std::string format(double value) const;
+
+    // Prompts on out, prints the value of each snippet to out and its error,
+    // if any, to err, and returns at the end of the input. A snippet that
+    // awaitsElse runs once the next line does not start with else.
+    void loop(std::istream& in, std::ostream& out, std::ostream& err);
+
+private:
+    Interpreter& interpreter;
+    Optimizer optimizer;
+    bool optimize;
+};
+
+#endif // REPL_H
@@ -0,0 +1,38 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <unordered_map>
+#include "ast.h"
+#include "symboltable.h"
+
+// Name resolution pass run between the Parser and the Interpreter.
+//
+// Scoping is lexical with two levels: parameters and every name assigned inside
+// a function body are locals of that function's frame, everything else is a
+// global. Each Var is annotated with the SymbolTable depth and slot it lives
+// in, and each FunctionDef with the size of its frame.
+class Resolver {
+public:
+    explicit Resolver(SymbolTable& symbolTable);
+
+    // Never fails on a name: reads of names nothing has assigned report
+    // "Undefined variable" when they run
+    void resolve(AST* tree);
+
+private:
+    struct FunctionScope {
+        std::unordered_map<Symbol, int> slots;
+        int slotCount = 0;
+    };
+
+    SymbolTable& symbolTable;
+    FunctionScope* function = nullptr; // Innermost enclosing function, null at top level
+
+    void declareGlobals(AST* node);
+    void collectLocals(AST* node, FunctionScope& scope);
+    void resolveNode(AST* node);
+    void resolveFunction(FunctionDef* node);
+    void resolveVar(Var* node);
+};
+
+#endif // RESOLVER_H
@@ -0,0 +1,37 @@
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <istream>
+#include <string>
+#include <string_view>
+
+// Program text handed to the Lexer. Files are memory-mapped read-only, so the
+// lexer's tokens view the page cache directly and nothing is copied; streams
+// such as stdin are read into an owned buffer instead.
+class SourceFile {
+public:
+    // Throws std::runtime_error if the file cannot be opened
+    static SourceFile map(const std::string& path);
+    static SourceFile read(std::istream& in);
+
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    ~SourceFile();
+
+    std::string_view text() const { return view; }
+    bool isMapped() const { return mapping != nullptr; }
+
+private:
+    SourceFile() = default;
+
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::string buffer;
+    std::string_view view;
+
+    void release() noexcept;
+};
+
+#endif // SOURCEFILE_H
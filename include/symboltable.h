@@ -1,23 +1,120 @@
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
 #include <unordered_map>
-#include <string>
 #include <vector>
 #include <stdexcept>
+#include "interner.h"
 
+// Bit pattern of a slot that has not been assigned yet (a signalling NaN
+// no arithmetic can produce)
+constexpr uint64_t UNDEFINED_SLOT_BITS = 0x7ff4dead0000beefULL;
+
+inline double undefinedSlot() {
+    double value;
+    std::memcpy(&value, &UNDEFINED_SLOT_BITS, sizeof(value));
+    return value;
+}
+
+inline bool isUndefinedSlot(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits == UNDEFINED_SLOT_BITS;
+}
+
+// Variable storage addressed by the (depth, slot) pairs the Resolver assigns:
+// depth 0 is the frame of the executing function, depth 1 the global frame.
+//
+// Function frames are consecutive ranges of one stack of slots that is kept
+// between calls, so entering a frame bumps the top of the stack and leaving it
+// drops it back; calls only allocate when the stack first grows deeper. At the
+// top level the local frame is the global one.
 class SymbolTable {
 public:
+    static constexpr int LOCAL_DEPTH = 0;
+    static constexpr int GLOBAL_DEPTH = 1;
+
     SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
 
-    void set(const std::string& name, double value);
-    double get(const std::string& name) const;
+    // Global variables by interned name
+    void set(Symbol name, double value);
+    double get(Symbol name) const;
+    int declareGlobal(Symbol name);
+    int findGlobal(Symbol name) const {
+        auto found = globalSlots.find(name);
+        return found == globalSlots.end() ? -1 : found->second;
+    }
+    std::string_view globalName(int slot) const { return symbolName(globalSymbols[slot]); }
 
-    void enterScope();
-    void leaveScope();
+    // Slot access for resolved variables; unassigned slots read as undefinedSlot()
+    double get(int depth, int slot) const {
+        return depth == LOCAL_DEPTH ? locals[slot] : globals[slot];
+    }
+    void set(int depth, int slot, double value) {
+        (depth == LOCAL_DEPTH ? locals : globals.data())[slot] = value;
+    }
+    // The same with the depth fixed, for callers that resolved it ahead of time
+    double getLocal(int slot) const { return locals[slot]; }
+    double getGlobal(int slot) const { return globals[slot]; }
+    void setLocal(int slot, double value) { locals[slot] = value; }
+    void setGlobal(int slot, double value) { globals[slot] = value; }
+
+    void enterScope(size_t slotCount) {
+        size_t base = top;
+        reserveSlots(base + slotCount);
+        frameBases.push_back(base);
+        top = base + slotCount;
+        locals = stack.data() + base;
+        std::fill(locals, locals + slotCount, undefinedSlot());
+    }
+    // Clears the innermost function frame and resizes it, for a tail call
+    void reuseScope(size_t slotCount);
+    void leaveScope() {
+        if (frameBases.empty()) {
+            throw std::runtime_error("Cannot leave global scope");
+        }
+        top = frameBases.back();
+        frameBases.pop_back();
+        locals = frameBases.empty() ? globals.data() : stack.data() + frameBases.back();
+    }
+    void resetScopes();
+
+    // Calls visit with the value of every global and every slot of the live
+    // function frames, e.g. to find the arrays a program can still reach
+    template <typename F>
+    void forEachValue(F&& visit) const {
+        for (double value : globals) {
+            visit(value);
+        }
+        for (size_t i = 0; i < top; ++i) {
+            visit(stack[i]);
+        }
+    }
 
 private:
-    std::vector<std::unordered_map<std::string, double>> scopes;
+    std::vector<double> globals;       // the global frame
+    std::vector<double> stack;         // function frames, innermost last
+    std::vector<size_t> frameBases;    // start of each function frame in the stack
+    size_t top = 0;                    // end of the innermost function frame
+    double* locals;                    // the innermost frame, function or global
+    std::vector<Symbol> globalSymbols; // name of each global slot
+    // Global slot of each symbol that has one. Symbols are process-wide, so a
+    // table indexed by them would grow with every name any program interned.
+    std::unordered_map<Symbol, int> globalSlots;
+
+    // Grows the stack to at least slotCount slots, moving the frames
+    void reserveSlots(size_t slotCount) {
+        if (slotCount > stack.size()) {
+            growStack(slotCount);
+        }
+    }
+    void growStack(size_t slotCount);
 };
 
 #endif // SYMBOLTABLE_H
@@ -1,9 +1,10 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <string>
+#include <cstdint>
+#include "interner.h"
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     END_OF_FILE,    // 0
     INTEGER,        // 1
     FLOAT,          // 2
@@ -35,13 +36,41 @@ enum class TokenType {
     GREATER_THAN,  // >
     LESS_EQUAL,    // <=
     GREATER_EQUAL, // >=
+    WHILE,
+    FOR,
+    LEFT_BRACKET,  // [
+    RIGHT_BRACKET, // ]
 };
 
+// A token is 16 bytes and owns nothing. It records where its text starts in
+// the Lexer's input (counted from the start of a stream) and how long it is;
+// Lexer::tokenText recovers the spelling. Numbers carry the value the Lexer parsed
+// and identifiers their interned Symbol; other tokens have NO_SYMBOL.
 struct Token {
+    union {
+        double number;
+        Symbol symbol;
+    };
+    uint32_t offset;
+    uint16_t length;
     TokenType type;
-    std::string value;
 
-    Token(TokenType type, const std::string& value) : type(type), value(value) {}
+    explicit Token(TokenType type, uint32_t offset = 0, uint16_t length = 0) noexcept
+        : symbol(NO_SYMBOL), offset(offset), length(length), type(type) {}
+
+    static Token identifier(Symbol symbol, uint32_t offset = 0, uint16_t length = 0) noexcept {
+        Token token(TokenType::IDENTIFIER, offset, length);
+        token.symbol = symbol;
+        return token;
+    }
+
+    static Token numeric(TokenType type, double number, uint32_t offset = 0, uint16_t length = 0) noexcept {
+        Token token(type, offset, length);
+        token.number = number;
+        return token;
+    }
 };
 
+static_assert(sizeof(Token) == 16, "Token should stay two words");
+
 #endif // TOKEN_H
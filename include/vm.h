@@ -0,0 +1,76 @@
+#ifndef VM_H
+#define VM_H
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "bytecode.h"
+
+class Program;
+
+// What a machine's code refers to by slot: its globals and functions, numbered
+// by the BytecodeCompiler as it meets their names, and the classes it defined
+struct MachineBindings {
+    SymbolSlots globalSlots;
+    SymbolSlots functionSlots;
+    std::vector<const FunctionProto*> functions; // indexed by function slot
+    std::vector<double> globals;                 // indexed by global slot
+    std::unordered_set<Symbol> classes;
+};
+
+// Stack-based bytecode virtual machine, an alternative backend to the
+// tree-walking Interpreter with the same observable behaviour.
+class VirtualMachine {
+public:
+    VirtualMachine();
+    // Starts from the functions and globals a Program's top-level code left,
+    // running the Program's code and reading its tables in place. Such a
+    // machine only makes calls; interpret() throws.
+    explicit VirtualMachine(const Program& program);
+    VirtualMachine(const VirtualMachine&) = delete;
+    VirtualMachine& operator=(const VirtualMachine&) = delete;
+
+    double interpret(ASTPtr& tree);
+    // True when the last run ended at a top-level return
+    bool returned() const { return topLevelReturn; }
+    // Calls a function defined by code this machine has run (or its Program ran)
+    double call(Symbol function, const double* args, size_t argCount);
+
+    double getVariableValue(const std::string& name) const;
+
+private:
+    friend class Program;
+
+    struct CallFrame {
+        const FunctionProto* proto;
+        const uint8_t* ip;
+        size_t base; // index of slot 0 in the value stack
+    };
+
+    std::vector<std::unique_ptr<FunctionProto>> functionProtos;
+    // The list DEFINE_FUNCTION indexes: functionProtos, or the Program's
+    const std::vector<std::unique_ptr<FunctionProto>>* protos;
+    // The machine's own bindings. A machine running a Program's code reads the
+    // Program's instead, and only keeps here the classes its calls define and,
+    // once a call defines a function, its own copy of the function table.
+    MachineBindings own;
+    const MachineBindings* bindings;                     // own, or the Program's
+    const std::vector<const FunctionProto*>* functions; // the function table calls look in
+
+    std::vector<double> stack; // locals and operands of every active frame
+    std::vector<CallFrame> frames;
+    bool topLevelReturn = false;
+
+    const int MAX_RECURSION_DEPTH = 1000;
+
+    double run(const FunctionProto* script);
+    // Runs from the innermost frame until the outermost returns
+    double execute(size_t stackUsed);
+    double loadGlobal(uint32_t slot) const;
+    double loadUnassignedLocal(Symbol name) const;
+    void ensureStack(size_t used, size_t needed);
+};
+
+#endif // VM_H
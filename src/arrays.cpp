@@ -0,0 +1,444 @@
+#include "arrays.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+// One clone of every kernel per instruction set, chosen when the program loads
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define ARRAY_KERNEL __attribute__((target_clones("avx2", "sse4.1", "default")))
+#else
+#define ARRAY_KERNEL
+#endif
+
+namespace {
+
+constexpr uint64_t INDEX_MASK = 0xFFFFFFFFULL;
+constexpr int GENERATION_SHIFT = 32;
+// Partial results kept by the reductions, enough to fill two AVX registers
+constexpr size_t LANES = 8;
+
+double encode(uint32_t index, uint16_t generation) {
+    uint64_t bits = ARRAY_TAG | (static_cast<uint64_t>(generation) << GENERATION_SHIFT) | index;
+    double handle;
+    std::memcpy(&handle, &bits, sizeof(handle));
+    return handle;
+}
+
+size_t storageBytes(size_t length) {
+    return (length * sizeof(double) + ArrayHeap::ALIGNMENT - 1) / ArrayHeap::ALIGNMENT * ArrayHeap::ALIGNMENT;
+}
+
+uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Element-wise kernels: array with array, array with number and number with
+// array. Plain loops over restrict pointers, which the compiler vectorizes.
+#define ELEMENTWISE_KERNELS(name, op)                                                                                \
+    ARRAY_KERNEL void name##Arrays(const double* __restrict a, const double* __restrict b, double* __restrict out, \
+                                   size_t n) {                                                                     \
+        for (size_t i = 0; i < n; ++i) {                                                                           \
+            out[i] = a[i] op b[i];                                                                                 \
+        }                                                                                                          \
+    }                                                                                                              \
+    ARRAY_KERNEL void name##ArrayNumber(const double* __restrict a, double b, double* __restrict out, size_t n) {   \
+        for (size_t i = 0; i < n; ++i) {                                                                           \
+            out[i] = a[i] op b;                                                                                    \
+        }                                                                                                          \
+    }                                                                                                              \
+    ARRAY_KERNEL void name##NumberArray(double a, const double* __restrict b, double* __restrict out, size_t n) {   \
+        for (size_t i = 0; i < n; ++i) {                                                                           \
+            out[i] = a op b[i];                                                                                    \
+        }                                                                                                          \
+    }
+
+ELEMENTWISE_KERNELS(add, +)
+ELEMENTWISE_KERNELS(subtract, -)
+ELEMENTWISE_KERNELS(multiply, *)
+ELEMENTWISE_KERNELS(divide, /)
+
+#undef ELEMENTWISE_KERNELS
+
+ARRAY_KERNEL void negateKernel(const double* __restrict a, double* __restrict out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = -a[i];
+    }
+}
+
+ARRAY_KERNEL bool containsZero(const double* __restrict a, size_t n) {
+    size_t zeros = 0;
+    for (size_t i = 0; i < n; ++i) {
+        zeros += a[i] == 0.0;
+    }
+    return zeros != 0;
+}
+
+ARRAY_KERNEL double sumKernel(const double* __restrict a, size_t n) {
+    double partial[LANES] = {};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            partial[lane] += a[i + lane];
+        }
+    }
+    double total = 0.0;
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        total += partial[lane];
+    }
+    for (; i < n; ++i) {
+        total += a[i];
+    }
+    return total;
+}
+
+ARRAY_KERNEL double dotKernel(const double* __restrict a, const double* __restrict b, size_t n) {
+    double partial[LANES] = {};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            partial[lane] += a[i + lane] * b[i + lane];
+        }
+    }
+    double total = 0.0;
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        total += partial[lane];
+    }
+    for (; i < n; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+// min and max of a non-empty array, compared with < and > as std::min and
+// std::max do, so a NaN element is only returned when it comes first
+ARRAY_KERNEL double minKernel(const double* __restrict a, size_t n) {
+    double partial[LANES];
+    std::fill(partial, partial + LANES, a[0]);
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            partial[lane] = a[i + lane] < partial[lane] ? a[i + lane] : partial[lane];
+        }
+    }
+    double result = partial[0];
+    for (size_t lane = 1; lane < LANES; ++lane) {
+        result = partial[lane] < result ? partial[lane] : result;
+    }
+    for (; i < n; ++i) {
+        result = a[i] < result ? a[i] : result;
+    }
+    return result;
+}
+
+ARRAY_KERNEL double maxKernel(const double* __restrict a, size_t n) {
+    double partial[LANES];
+    std::fill(partial, partial + LANES, a[0]);
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            partial[lane] = a[i + lane] > partial[lane] ? a[i + lane] : partial[lane];
+        }
+    }
+    double result = partial[0];
+    for (size_t lane = 1; lane < LANES; ++lane) {
+        result = partial[lane] > result ? partial[lane] : result;
+    }
+    for (; i < n; ++i) {
+        result = a[i] > result ? a[i] : result;
+    }
+    return result;
+}
+
+// % and ^ go through libm one element at a time
+void modulusKernel(const double* a, size_t aStride, const double* b, size_t bStride, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::fmod(a[i * aStride], b[i * bStride]);
+    }
+}
+
+void powerKernel(const double* a, size_t aStride, const double* b, size_t bStride, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::pow(a[i * aStride], b[i * bStride]);
+    }
+}
+
+} // namespace
+
+ArrayHeap::~ArrayHeap() {
+    for (Entry& entry : entries) {
+        std::free(entry.data);
+    }
+    for (Block& block : spareBlocks) {
+        std::free(block.data);
+    }
+}
+
+double* ArrayHeap::allocateStorage(size_t bytes) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < spareBlocks.size(); ++i) {
+        if (spareBlocks[i].bytes == bytes) {
+            double* data = spareBlocks[i].data;
+            spareBlocks[i] = spareBlocks.back();
+            spareBlocks.pop_back();
+            return data;
+        }
+    }
+    auto data = static_cast<double*>(std::aligned_alloc(ALIGNMENT, bytes));
+    if (!data) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+void ArrayHeap::releaseStorage(double* data, size_t bytes) {
+    if (!data) {
+        return;
+    }
+    if (spareBlocks.size() < MAX_SPARE_BLOCKS) {
+        spareBlocks.push_back({data, bytes});
+    } else {
+        std::free(data);
+    }
+}
+
+double ArrayHeap::allocate(size_t length, double*& data) {
+    size_t bytes = storageBytes(length);
+    data = allocateStorage(bytes);
+    uint32_t index;
+    if (!freeList.empty()) {
+        index = freeList.back();
+        freeList.pop_back();
+    } else {
+        if (entries.size() > INDEX_MASK) {
+            releaseStorage(data, bytes);
+            throw std::runtime_error("Too many arrays");
+        }
+        index = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+    Entry& entry = entries[index];
+    entry.data = data;
+    entry.length = length;
+    entry.live = true;
+    entry.marked = false;
+    bytesLive += bytes;
+    allocatedSinceSweep += bytes + sizeof(Entry);
+    return encode(index, entry.generation);
+}
+
+double ArrayHeap::make(const double* values, size_t length) {
+    double* data;
+    double handle = allocate(length, data);
+    std::copy(values, values + length, data);
+    return handle;
+}
+
+const ArrayHeap::Entry* ArrayHeap::find(double handle) const {
+    uint64_t bits = bitsOf(handle);
+    uint64_t index = bits & INDEX_MASK;
+    if (index >= entries.size()) {
+        return nullptr;
+    }
+    const Entry& entry = entries[index];
+    uint16_t generation = static_cast<uint16_t>(bits >> GENERATION_SHIFT);
+    return entry.live && entry.generation == generation ? &entry : nullptr;
+}
+
+ArrayHeap::View ArrayHeap::view(double handle) const {
+    if (!isArrayValue(handle)) {
+        throw std::runtime_error("Not an array");
+    }
+    const Entry* entry = find(handle);
+    if (!entry) {
+        throw std::runtime_error("Stale array");
+    }
+    return {entry->data, entry->length};
+}
+
+void ArrayHeap::mark(double value) {
+    if (isArrayValue(value)) {
+        if (const Entry* entry = find(value)) {
+            const_cast<Entry*>(entry)->marked = true;
+        }
+    }
+}
+
+void ArrayHeap::sweep() {
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if (!entry.live) {
+            continue;
+        }
+        if (entry.marked) {
+            entry.marked = false;
+            continue;
+        }
+        size_t bytes = storageBytes(entry.length);
+        bytesLive -= bytes;
+        releaseStorage(entry.data, bytes);
+        entry = Entry{nullptr, 0, static_cast<uint16_t>(entry.generation + 1), false, false};
+        freeList.push_back(static_cast<uint32_t>(i));
+    }
+    allocatedSinceSweep = 0;
+    // Collect again once the heap has grown by as much as survived
+    collectionThreshold = std::max(MIN_COLLECTION_BYTES, bytesLive);
+}
+
+double arrayArithmetic(ArrayHeap& heap, TokenType op, double left, double right) {
+    bool leftArray = isArrayValue(left);
+    bool rightArray = isArrayValue(right);
+    ArrayHeap::View a = leftArray ? heap.view(left) : ArrayHeap::View{&left, 0};
+    ArrayHeap::View b = rightArray ? heap.view(right) : ArrayHeap::View{&right, 0};
+    if (leftArray && rightArray && a.length != b.length) {
+        throw std::runtime_error("Array lengths differ");
+    }
+    switch (op) {
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+        case TokenType::MULTIPLY:
+        case TokenType::DIVIDE:
+        case TokenType::MODULUS:
+        case TokenType::POWER:
+            break;
+        default:
+            throw std::runtime_error("Operator not supported on arrays");
+    }
+    size_t n = leftArray ? a.length : b.length;
+    if (op == TokenType::DIVIDE && (rightArray ? containsZero(b.data, n) : right == 0)) {
+        throw std::runtime_error("Division by zero");
+    }
+
+    double* out;
+    double result = heap.allocate(n, out);
+    switch (op) {
+        case TokenType::PLUS:
+            if (leftArray && rightArray) {
+                addArrays(a.data, b.data, out, n);
+            } else if (leftArray) {
+                addArrayNumber(a.data, right, out, n);
+            } else {
+                addNumberArray(left, b.data, out, n);
+            }
+            break;
+        case TokenType::MINUS:
+            if (leftArray && rightArray) {
+                subtractArrays(a.data, b.data, out, n);
+            } else if (leftArray) {
+                subtractArrayNumber(a.data, right, out, n);
+            } else {
+                subtractNumberArray(left, b.data, out, n);
+            }
+            break;
+        case TokenType::MULTIPLY:
+            if (leftArray && rightArray) {
+                multiplyArrays(a.data, b.data, out, n);
+            } else if (leftArray) {
+                multiplyArrayNumber(a.data, right, out, n);
+            } else {
+                multiplyNumberArray(left, b.data, out, n);
+            }
+            break;
+        case TokenType::DIVIDE:
+            if (leftArray && rightArray) {
+                divideArrays(a.data, b.data, out, n);
+            } else if (leftArray) {
+                divideArrayNumber(a.data, right, out, n);
+            } else {
+                divideNumberArray(left, b.data, out, n);
+            }
+            break;
+        case TokenType::MODULUS:
+            modulusKernel(a.data, leftArray, b.data, rightArray, out, n);
+            break;
+        default:
+            powerKernel(a.data, leftArray, b.data, rightArray, out, n);
+            break;
+    }
+    return result;
+}
+
+double arrayNegate(ArrayHeap& heap, double array) {
+    ArrayHeap::View a = heap.view(array);
+    double* out;
+    double result = heap.allocate(a.length, out);
+    negateKernel(a.data, out, a.length);
+    return result;
+}
+
+double arraySum(const ArrayHeap& heap, double array) {
+    ArrayHeap::View a = heap.view(array);
+    return sumKernel(a.data, a.length);
+}
+
+double arrayMin(const ArrayHeap& heap, double array) {
+    ArrayHeap::View a = heap.view(array);
+    if (a.length == 0) {
+        throw std::runtime_error("min of an empty array");
+    }
+    return minKernel(a.data, a.length);
+}
+
+double arrayMax(const ArrayHeap& heap, double array) {
+    ArrayHeap::View a = heap.view(array);
+    if (a.length == 0) {
+        throw std::runtime_error("max of an empty array");
+    }
+    return maxKernel(a.data, a.length);
+}
+
+double arrayDot(const ArrayHeap& heap, double left, double right) {
+    ArrayHeap::View a = heap.view(left);
+    ArrayHeap::View b = heap.view(right);
+    if (a.length != b.length) {
+        throw std::runtime_error("Array lengths differ");
+    }
+    return dotKernel(a.data, b.data, a.length);
+}
+
+ArrayBuiltin findArrayBuiltin(Symbol symbol) {
+    static const Symbol len = intern("len");
+    static const Symbol sum = intern("sum");
+    static const Symbol min = intern("min");
+    static const Symbol max = intern("max");
+    static const Symbol dot = intern("dot");
+    if (symbol == len) {
+        return ArrayBuiltin::LEN;
+    } else if (symbol == sum) {
+        return ArrayBuiltin::SUM;
+    } else if (symbol == min) {
+        return ArrayBuiltin::MIN;
+    } else if (symbol == max) {
+        return ArrayBuiltin::MAX;
+    } else if (symbol == dot) {
+        return ArrayBuiltin::DOT;
+    }
+    return ArrayBuiltin::NONE;
+}
+
+double callArrayBuiltin(const ArrayHeap& heap, ArrayBuiltin builtin, Symbol symbol, const double* args, size_t argc) {
+    if (argc != (builtin == ArrayBuiltin::DOT ? 2u : 1u)) {
+        throw std::runtime_error("Incorrect number of arguments in function call: " + std::string(symbolName(symbol)));
+    }
+    switch (builtin) {
+        case ArrayBuiltin::LEN:
+            return static_cast<double>(heap.view(args[0]).length);
+        case ArrayBuiltin::SUM:
+            return arraySum(heap, args[0]);
+        case ArrayBuiltin::MIN:
+            return arrayMin(heap, args[0]);
+        case ArrayBuiltin::MAX:
+            return arrayMax(heap, args[0]);
+        case ArrayBuiltin::DOT:
+            return arrayDot(heap, args[0], args[1]);
+        case ArrayBuiltin::NONE:
+            break;
+    }
+    throw std::runtime_error("Undefined function: " + std::string(symbolName(symbol)));
+}
@@ -1,18 +1,68 @@
 #include "ast.h"
+#include <algorithm>
+#include <cstdint>
+
+// ASTDeleter Implementation
+ASTDeleter ASTDeleter::borrowing() noexcept {
+    ASTDeleter deleter;
+    deleter.borrowed = true;
+    return deleter;
+}
+
+ASTDeleter ASTDeleter::owning(ASTArena* arena) noexcept {
+    ASTDeleter deleter;
+    deleter.ownedArena = arena;
+    return deleter;
+}
+
+void ASTDeleter::operator()(AST* node) const {
+    if (borrowed) {
+        return;
+    }
+    if (ownedArena) {
+        delete ownedArena;
+    } else {
+        delete node;
+    }
+}
+
+// ASTArena Implementation
+ASTArena::~ASTArena() {
+    // Child links inside the arena only borrow, so each destructor is shallow
+    for (AST* node : nodes) {
+        node->~AST();
+    }
+}
+
+void* ASTArena::allocate(size_t size, size_t alignment) {
+    uintptr_t address = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+    if (!cursor || address + size > reinterpret_cast<uintptr_t>(limit)) {
+        size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+        blocks.emplace_back(new char[blockSize]);
+        blockBytes += blockSize;
+        cursor = blocks.back().get();
+        limit = cursor + blockSize;
+        address = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+    }
+    cursor = reinterpret_cast<char*>(address + size);
+    return reinterpret_cast<void*>(address);
+}
 
 // BinOp Implementation
 BinOp::BinOp(ASTPtr left, Token op, ASTPtr right)
-    : left(std::move(left)), op(op), right(std::move(right)) {}
+    : AST(NodeType::BIN_OP), left(std::move(left)), op(op), right(std::move(right)) {}
 
 // Num Implementation
-Num::Num(Token token) : token(token), value(std::stod(token.value)) {}
+Num::Num(const Token& token) : AST(NodeType::NUM), value(token.number) {}
+
+Num::Num(double value) noexcept : AST(NodeType::NUM), value(value) {}
 
 // UnaryOp Implementation
 UnaryOp::UnaryOp(Token op, ASTPtr expr)
-    : op(op), expr(std::move(expr)) {}
+    : AST(NodeType::UNARY_OP), op(op), expr(std::move(expr)) {}
 
 // Compound Implementation
-Compound::Compound() noexcept {}
+Compound::Compound() noexcept : AST(NodeType::COMPOUND) {}
 
 void Compound::addChild(ASTPtr child) {
     children.push_back(std::move(child));
@@ -20,29 +70,38 @@ void Compound::addChild(ASTPtr child) {
 
 // Assign Implementation
 Assign::Assign(ASTPtr left, Token op, ASTPtr right)
-    : left(std::move(left)), op(op), right(std::move(right)) {}
+    : AST(NodeType::ASSIGN), left(std::move(left)), op(op), right(std::move(right)) {}
 
 // Var Implementation
-Var::Var(Token token) : token(token), value(token.value) {}
+Var::Var(const Token& token) : AST(NodeType::VAR), symbol(token.symbol), value(symbolName(token.symbol)) {}
 
 // NoOp Implementation
-NoOp::NoOp() noexcept {}
+NoOp::NoOp() noexcept : AST(NodeType::NO_OP) {}
 
 // FunctionDef Implementation
-FunctionDef::FunctionDef(const std::string& name, const std::vector<std::string>& params, ASTPtr body)
-    : name(name), params(params), body(std::move(body)) {}
+FunctionDef::FunctionDef(Symbol symbol, std::vector<Symbol> params, ASTPtr body)
+    : AST(NodeType::FUNCTION_DEF), symbol(symbol), name(symbolName(symbol)), params(std::move(params)),
+      body(std::move(body)) {}
 
 // FunctionCall Implementation
-FunctionCall::FunctionCall(const std::string& name, std::vector<ASTPtr> args)
-    : name(name), args(std::move(args)) {}
+FunctionCall::FunctionCall(Symbol symbol, std::vector<ASTPtr> args)
+    : AST(NodeType::FUNCTION_CALL), symbol(symbol), name(symbolName(symbol)), args(std::move(args)) {}
 
 // ClassDef Implementation
-ClassDef::ClassDef(const std::string& name, std::vector<ASTPtr> methods)
-    : name(name), methods(std::move(methods)) {}
+ClassDef::ClassDef(Symbol symbol, std::vector<ASTPtr> methods)
+    : AST(NodeType::CLASS_DEF), symbol(symbol), name(symbolName(symbol)), methods(std::move(methods)) {}
 
 // Return Implementation
-Return::Return(ASTPtr expr) : expr(std::move(expr)) {}
+Return::Return(ASTPtr expr) : AST(NodeType::RETURN), expr(std::move(expr)) {}
 
 IfStatement::IfStatement(ASTPtr condition, ASTPtr thenBranch, ASTPtr elseBranch)
-    : condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {}
+    : AST(NodeType::IF_STATEMENT), condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {}
+
+WhileStatement::WhileStatement(ASTPtr condition, ASTPtr body)
+    : AST(NodeType::WHILE_STATEMENT), condition(std::move(condition)), body(std::move(body)) {}
+
+ArrayLiteral::ArrayLiteral(std::vector<ASTPtr> elements)
+    : AST(NodeType::ARRAY_LITERAL), elements(std::move(elements)) {}
 
+Index::Index(ASTPtr array, ASTPtr index)
+    : AST(NodeType::INDEX), array(std::move(array)), index(std::move(index)) {}
@@ -0,0 +1,354 @@
+#include "batchevaluator.h"
+#include "arrays.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// One clone of every kernel per instruction set, chosen when the program loads
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define BATCH_KERNEL __attribute__((target_clones("avx2", "sse4.1", "default")))
+#else
+#define BATCH_KERNEL
+#endif
+
+namespace {
+
+constexpr uint64_t ALL_LANES = ~uint64_t(0);
+
+// Plain loops the compiler vectorizes; they compute exactly what the scalar
+// Interpreter computes, lane by lane
+
+BATCH_KERNEL void addKernel(const double* __restrict a, const double* __restrict b, double* __restrict out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+BATCH_KERNEL void subtractKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                                 size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+BATCH_KERNEL void multiplyKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                                 size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+BATCH_KERNEL void divideKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                               size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] / b[i];
+    }
+}
+
+// True if an active lane divides by zero
+BATCH_KERNEL bool divisionByZeroKernel(const uint64_t* __restrict mask, const double* __restrict b, size_t n) {
+    uint64_t hits = 0;
+    for (size_t i = 0; i < n; ++i) {
+        hits |= mask[i] & (b[i] == 0.0 ? ALL_LANES : 0);
+    }
+    return hits != 0;
+}
+
+BATCH_KERNEL void negateKernel(const double* __restrict a, double* __restrict out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = -a[i];
+    }
+}
+
+BATCH_KERNEL void equalKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                              size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] == b[i] ? 1.0 : 0.0;
+    }
+}
+
+BATCH_KERNEL void notEqualKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                                 size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] != b[i] ? 1.0 : 0.0;
+    }
+}
+
+BATCH_KERNEL void lessKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                             size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] < b[i] ? 1.0 : 0.0;
+    }
+}
+
+BATCH_KERNEL void lessEqualKernel(const double* __restrict a, const double* __restrict b, double* __restrict out,
+                                  size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] <= b[i] ? 1.0 : 0.0;
+    }
+}
+
+// Same test as the Interpreter's condition != 0.0, so NaN counts as true
+BATCH_KERNEL void truthKernel(const double* __restrict a, uint64_t* __restrict out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] != 0.0 ? ALL_LANES : 0;
+    }
+}
+
+BATCH_KERNEL void andKernel(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] & b[i];
+    }
+}
+
+BATCH_KERNEL void andNotKernel(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] & ~b[i];
+    }
+}
+
+BATCH_KERNEL void orKernel(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] | b[i];
+    }
+}
+
+// Operands may alias the output: a store selects into the local it updates
+BATCH_KERNEL void selectKernel(const uint64_t* __restrict mask, const double* a, const double* b, double* out,
+                               size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = mask[i] ? a[i] : b[i];
+    }
+}
+
+} // namespace
+
+BatchEvaluator::BatchEvaluator(FunctionDef* function)
+    : function(function), supported(false), valueColumns(function->numLocals), maskColumns(0) {
+    newMask(); // mask 0: lanes still running
+    assigned.assign(function->numLocals, false);
+    for (size_t i = 0; i < function->params.size(); ++i) {
+        assigned[i] = true;
+    }
+    returnColumn = newValue();
+    bodyColumn = compile(function->body.get(), 0);
+    supported = bodyColumn >= 0;
+}
+
+int BatchEvaluator::constant(double value) {
+    int column = newValue();
+    constants.emplace_back(column, value);
+    return column;
+}
+
+int BatchEvaluator::compile(AST* node, int mask) {
+    switch (node->type) {
+        case NodeType::NUM:
+            return constant(static_cast<Num*>(node)->value);
+        case NodeType::VAR: {
+            auto var = static_cast<Var*>(node);
+            if (var->depth == SymbolTable::LOCAL_DEPTH) {
+                // A maybe-unassigned local may fall back to a global on some rows
+                return assigned[var->slot] ? var->slot : -1;
+            }
+            int column = newValue();
+            globals.emplace_back(column, var->slot);
+            return column;
+        }
+        case NodeType::UNARY_OP: {
+            auto unaryOp = static_cast<UnaryOp*>(node);
+            int value = compile(unaryOp->expr.get(), mask);
+            if (value < 0 || unaryOp->op.type == TokenType::PLUS) {
+                return value;
+            }
+            if (unaryOp->op.type != TokenType::MINUS) {
+                return -1;
+            }
+            int dst = newValue();
+            ops.push_back({OpKind::NEGATE, dst, value, -1, -1});
+            return dst;
+        }
+        case NodeType::BIN_OP:
+            return compileBinOp(static_cast<BinOp*>(node), mask);
+        case NodeType::COMPOUND: {
+            auto compound = static_cast<Compound*>(node);
+            int result = compound->children.empty() ? constant(0.0) : -1;
+            for (auto& child : compound->children) {
+                result = compile(child.get(), mask);
+                if (result < 0) {
+                    return -1;
+                }
+            }
+            return result;
+        }
+        case NodeType::ASSIGN: {
+            auto assign = static_cast<Assign*>(node);
+            if (assign->left->type != NodeType::VAR) {
+                return -1;
+            }
+            auto var = static_cast<Var*>(assign->left.get());
+            int value = compile(assign->right.get(), mask);
+            if (value < 0 || var->depth != SymbolTable::LOCAL_DEPTH) {
+                return -1;
+            }
+            ops.push_back({OpKind::STORE, var->slot, value, -1, mask});
+            assigned[var->slot] = true;
+            return value;
+        }
+        case NodeType::NO_OP:
+            return constant(0.0);
+        case NodeType::RETURN: {
+            int value = compile(static_cast<Return*>(node)->expr.get(), mask);
+            if (value < 0) {
+                return -1;
+            }
+            ops.push_back({OpKind::RETURN, returnColumn, value, -1, mask});
+            // Code after a return runs on no lanes
+            assigned.assign(assigned.size(), true);
+            return value;
+        }
+        case NodeType::IF_STATEMENT:
+            return compileIf(static_cast<IfStatement*>(node), mask);
+        case NodeType::WHILE_STATEMENT:
+        case NodeType::ARRAY_LITERAL:
+        case NodeType::INDEX:
+        case NodeType::FUNCTION_CALL:
+        case NodeType::FUNCTION_DEF:
+        case NodeType::CLASS_DEF:
+            return -1;
+    }
+    return -1;
+}
+
+int BatchEvaluator::compileBinOp(BinOp* node, int mask) {
+    int left = compile(node->left.get(), mask);
+    int right = left < 0 ? -1 : compile(node->right.get(), mask);
+    if (right < 0) {
+        return -1;
+    }
+    int dst = newValue();
+    switch (node->op.type) {
+        case TokenType::PLUS: ops.push_back({OpKind::ADD, dst, left, right, -1}); break;
+        case TokenType::MINUS: ops.push_back({OpKind::SUBTRACT, dst, left, right, -1}); break;
+        case TokenType::MULTIPLY: ops.push_back({OpKind::MULTIPLY, dst, left, right, -1}); break;
+        case TokenType::DIVIDE: ops.push_back({OpKind::DIVIDE, dst, left, right, mask}); break;
+        case TokenType::MODULUS: ops.push_back({OpKind::MODULUS, dst, left, right, -1}); break;
+        case TokenType::POWER: ops.push_back({OpKind::POWER, dst, left, right, -1}); break;
+        case TokenType::EQUALS: ops.push_back({OpKind::EQUAL, dst, left, right, -1}); break;
+        case TokenType::NOT_EQUALS: ops.push_back({OpKind::NOT_EQUAL, dst, left, right, -1}); break;
+        case TokenType::LESS_THAN: ops.push_back({OpKind::LESS, dst, left, right, -1}); break;
+        case TokenType::LESS_EQUAL: ops.push_back({OpKind::LESS_EQUAL, dst, left, right, -1}); break;
+        case TokenType::GREATER_THAN: ops.push_back({OpKind::LESS, dst, right, left, -1}); break;
+        case TokenType::GREATER_EQUAL: ops.push_back({OpKind::LESS_EQUAL, dst, right, left, -1}); break;
+        default:
+            return -1;
+    }
+    return dst;
+}
+
+// Both branches run, each on the lanes that take it; the statement's value is
+// blended from the two and the enclosing mask keeps the lanes that did not return
+int BatchEvaluator::compileIf(IfStatement* node, int mask) {
+    int condition = compile(node->condition.get(), mask);
+    if (condition < 0) {
+        return -1;
+    }
+    int taken = newMask();
+    int thenMask = newMask();
+    int elseMask = newMask();
+    ops.push_back({OpKind::TRUTH, taken, condition, -1, -1});
+    ops.push_back({OpKind::AND, thenMask, mask, taken, -1});
+    ops.push_back({OpKind::AND_NOT, elseMask, mask, taken, -1});
+
+    std::vector<bool> before = assigned;
+    int thenValue = compile(node->thenBranch.get(), thenMask);
+    if (thenValue < 0) {
+        return -1;
+    }
+    std::vector<bool> afterThen = assigned;
+    assigned = before;
+    int elseValue = node->elseBranch ? compile(node->elseBranch.get(), elseMask) : constant(0.0);
+    if (elseValue < 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < assigned.size(); ++i) {
+        assigned[i] = assigned[i] && afterThen[i];
+    }
+
+    int dst = newValue();
+    ops.push_back({OpKind::SELECT, dst, thenValue, elseValue, taken});
+    ops.push_back({OpKind::OR, mask, thenMask, elseMask, -1});
+    return dst;
+}
+
+bool BatchEvaluator::run(const std::vector<const double*>& columns, size_t rows, double* out,
+                         const SymbolTable& symbolTable) {
+    std::vector<double> values(static_cast<size_t>(valueColumns) * BLOCK_SIZE, 0.0);
+    std::vector<uint64_t> masks(static_cast<size_t>(maskColumns) * BLOCK_SIZE, 0);
+    auto value = [&values](int column) { return values.data() + static_cast<size_t>(column) * BLOCK_SIZE; };
+    auto mask = [&masks](int column) { return masks.data() + static_cast<size_t>(column) * BLOCK_SIZE; };
+
+    // Constants and globals do not change while the batch runs
+    for (const auto& [column, constantValue] : constants) {
+        std::fill_n(value(column), BLOCK_SIZE, constantValue);
+    }
+    for (const auto& [column, slot] : globals) {
+        double globalValue = symbolTable.get(SymbolTable::GLOBAL_DEPTH, slot);
+        if (isUndefinedSlot(globalValue) || isArrayValue(globalValue)) {
+            return false;
+        }
+        std::fill_n(value(column), BLOCK_SIZE, globalValue);
+    }
+
+    for (size_t start = 0; start < rows; start += BLOCK_SIZE) {
+        size_t n = std::min(BLOCK_SIZE, rows - start);
+        std::fill_n(mask(0), n, ALL_LANES);
+        for (size_t param = 0; param < columns.size(); ++param) {
+            std::memcpy(value(static_cast<int>(param)), columns[param] + start, n * sizeof(double));
+        }
+
+        for (const Op& op : ops) {
+            switch (op.kind) {
+                case OpKind::ADD: addKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::SUBTRACT: subtractKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::MULTIPLY: multiplyKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::DIVIDE:
+                    if (divisionByZeroKernel(mask(op.mask), value(op.b), n)) {
+                        throw std::runtime_error("Division by zero");
+                    }
+                    divideKernel(value(op.a), value(op.b), value(op.dst), n);
+                    break;
+                case OpKind::MODULUS:
+                    for (size_t i = 0; i < n; ++i) {
+                        value(op.dst)[i] = std::fmod(value(op.a)[i], value(op.b)[i]);
+                    }
+                    break;
+                case OpKind::POWER:
+                    for (size_t i = 0; i < n; ++i) {
+                        value(op.dst)[i] = std::pow(value(op.a)[i], value(op.b)[i]);
+                    }
+                    break;
+                case OpKind::NEGATE: negateKernel(value(op.a), value(op.dst), n); break;
+                case OpKind::EQUAL: equalKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::NOT_EQUAL: notEqualKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::LESS: lessKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::LESS_EQUAL: lessEqualKernel(value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::TRUTH: truthKernel(value(op.a), mask(op.dst), n); break;
+                case OpKind::AND: andKernel(mask(op.a), mask(op.b), mask(op.dst), n); break;
+                case OpKind::AND_NOT: andNotKernel(mask(op.a), mask(op.b), mask(op.dst), n); break;
+                case OpKind::OR: orKernel(mask(op.a), mask(op.b), mask(op.dst), n); break;
+                case OpKind::SELECT: selectKernel(mask(op.mask), value(op.a), value(op.b), value(op.dst), n); break;
+                case OpKind::STORE: selectKernel(mask(op.mask), value(op.a), value(op.dst), value(op.dst), n); break;
+                case OpKind::RETURN:
+                    selectKernel(mask(op.mask), value(op.a), value(op.dst), value(op.dst), n);
+                    std::fill_n(mask(op.mask), n, 0);
+                    break;
+            }
+        }
+
+        // Rows that never returned take the value of the body's last statement
+        selectKernel(mask(0), value(bodyColumn), value(returnColumn), out + start, n);
+    }
+    return true;
+}
@@ -0,0 +1,152 @@
+#include "batchrunner.h"
+#include "interpreter.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "sourcefile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+BatchResult runScript(std::string name, std::string_view source) {
+    BatchResult result;
+    result.script = std::move(name);
+    try {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        ASTPtr tree = parser.parse();
+        Optimizer optimizer;
+        optimizer.optimize(tree);
+        Interpreter interpreter;
+        result.value = interpreter.interpret(tree);
+    } catch (const std::exception& error) {
+        result.error = error.what();
+        if (result.error.empty()) {
+            result.error = "Unknown error";
+        }
+    }
+    return result;
+}
+
+// Tabs and line breaks would split the record
+std::string escapeField(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '\t': escaped += "\\t"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\\': escaped += "\\\\"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(unsigned workers)
+    : workers(workers > 0 ? workers : std::max(1u, std::thread::hardware_concurrency())) {}
+
+std::vector<BatchResult> BatchRunner::runFiles(const std::vector<std::string>& paths) const {
+    return runAll(paths.size(), [&paths](size_t index) {
+        const std::string& path = paths[index];
+        try {
+            SourceFile source = SourceFile::map(path);
+            return runScript(path, source.text());
+        } catch (const std::exception& error) {
+            BatchResult result;
+            result.script = path;
+            result.error = error.what();
+            return result;
+        }
+    });
+}
+
+std::vector<BatchResult> BatchRunner::runSources(const std::vector<std::pair<std::string, std::string>>& sources) const {
+    return runAll(sources.size(), [&sources](size_t index) {
+        return runScript(sources[index].first, sources[index].second);
+    });
+}
+
+// Workers claim scripts one at a time from a shared counter, so a few slow
+// scripts do not hold up the rest of a statically assigned share
+std::vector<BatchResult> BatchRunner::runAll(size_t count, const std::function<BatchResult(size_t)>& runOne) const {
+    std::vector<BatchResult> results(count);
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t index = next.fetch_add(1, std::memory_order_relaxed); index < count;
+             index = next.fetch_add(1, std::memory_order_relaxed)) {
+            results[index] = runOne(index);
+        }
+    };
+
+    size_t threadCount = std::min<size_t>(workers, count);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount > 0 ? threadCount - 1 : 0);
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(work);
+    }
+    // The calling thread is one of the workers
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+std::vector<std::string> BatchRunner::listScripts(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> scripts;
+    std::error_code error;
+    if (fs::is_directory(path, error)) {
+        for (const fs::directory_entry& entry : fs::directory_iterator(path, error)) {
+            if (entry.is_regular_file()) {
+                scripts.push_back(entry.path().string());
+            }
+        }
+        if (error) {
+            throw std::runtime_error("Could not read directory " + path);
+        }
+        std::sort(scripts.begin(), scripts.end());
+        return scripts;
+    }
+
+    std::ifstream manifest(path);
+    if (!manifest.is_open()) {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    fs::path base = fs::path(path).parent_path();
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        fs::path script(line);
+        scripts.push_back(script.is_absolute() ? script.string() : (base / script).string());
+    }
+    return scripts;
+}
+
+void BatchRunner::writeResults(std::ostream& out, const std::vector<BatchResult>& results) {
+    char value[32];
+    for (const BatchResult& result : results) {
+        out << escapeField(result.script) << '\t';
+        if (result.succeeded()) {
+            // Enough digits to read the exact double back
+            std::snprintf(value, sizeof(value), "%.17g", result.value);
+            out << value;
+        }
+        out << '\t' << escapeField(result.error) << '\n';
+    }
+}
@@ -0,0 +1,95 @@
+#include "bytecode.h"
+#include <sstream>
+
+namespace {
+
+template <typename T>
+T readOperand(const std::vector<uint8_t>& code, size_t& offset) {
+    T value;
+    std::memcpy(&value, &code[offset], sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+const char* opName(OpCode op) {
+    switch (op) {
+        case OpCode::CONSTANT: return "CONSTANT";
+        case OpCode::LOAD_LOCAL: return "LOAD_LOCAL";
+        case OpCode::STORE_LOCAL: return "STORE_LOCAL";
+        case OpCode::LOAD_GLOBAL: return "LOAD_GLOBAL";
+        case OpCode::STORE_GLOBAL: return "STORE_GLOBAL";
+        case OpCode::ADD: return "ADD";
+        case OpCode::SUBTRACT: return "SUBTRACT";
+        case OpCode::MULTIPLY: return "MULTIPLY";
+        case OpCode::DIVIDE: return "DIVIDE";
+        case OpCode::MODULUS: return "MODULUS";
+        case OpCode::POWER: return "POWER";
+        case OpCode::EQUAL: return "EQUAL";
+        case OpCode::NOT_EQUAL: return "NOT_EQUAL";
+        case OpCode::LESS: return "LESS";
+        case OpCode::GREATER: return "GREATER";
+        case OpCode::LESS_EQUAL: return "LESS_EQUAL";
+        case OpCode::GREATER_EQUAL: return "GREATER_EQUAL";
+        case OpCode::NEGATE: return "NEGATE";
+        case OpCode::POP: return "POP";
+        case OpCode::JUMP: return "JUMP";
+        case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OpCode::CALL: return "CALL";
+        case OpCode::TAIL_CALL: return "TAIL_CALL";
+        case OpCode::RETURN: return "RETURN";
+        case OpCode::DEFINE_FUNCTION: return "DEFINE_FUNCTION";
+        case OpCode::DEFINE_CLASS: return "DEFINE_CLASS";
+    }
+    return "UNKNOWN";
+}
+
+} // namespace
+
+std::string disassemble(const FunctionProto& proto) {
+    std::ostringstream out;
+    out << "== " << proto.name << " (arity " << proto.arity << ", locals " << proto.numLocals
+        << ", stack " << proto.maxStack << ") ==\n";
+    size_t offset = 0;
+    while (offset < proto.code.size()) {
+        out << offset << '\t';
+        OpCode op = static_cast<OpCode>(proto.code[offset++]);
+        out << opName(op);
+        switch (op) {
+            case OpCode::CONSTANT:
+                out << ' ' << readOperand<double>(proto.code, offset);
+                break;
+            case OpCode::LOAD_LOCAL:
+            case OpCode::STORE_LOCAL: {
+                uint16_t slot = readOperand<uint16_t>(proto.code, offset);
+                out << ' ' << slot << " (" << symbolName(proto.localNames[slot]) << ')';
+                break;
+            }
+            case OpCode::DEFINE_CLASS:
+                out << ' ' << symbolName(readOperand<uint32_t>(proto.code, offset));
+                break;
+            case OpCode::LOAD_GLOBAL:
+            case OpCode::STORE_GLOBAL:
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+                out << ' ' << readOperand<uint32_t>(proto.code, offset);
+                break;
+            case OpCode::DEFINE_FUNCTION: {
+                uint32_t index = readOperand<uint32_t>(proto.code, offset);
+                uint32_t slot = readOperand<uint32_t>(proto.code, offset);
+                out << ' ' << index << ' ' << slot;
+                break;
+            }
+            case OpCode::CALL:
+            case OpCode::TAIL_CALL: {
+                uint32_t slot = readOperand<uint32_t>(proto.code, offset);
+                uint8_t argc = readOperand<uint8_t>(proto.code, offset);
+                out << ' ' << slot << ' ' << static_cast<int>(argc);
+                break;
+            }
+            default:
+                break;
+        }
+        out << '\n';
+    }
+    return out.str();
+}
@@ -0,0 +1,319 @@
+#include "bytecodecompiler.h"
+#include <limits>
+#include <stdexcept>
+
+BytecodeCompiler::BytecodeCompiler(std::vector<std::unique_ptr<FunctionProto>>& functions,
+                                   SymbolSlots& globalSlots, SymbolSlots& functionSlots)
+    : functions(functions), globalSlots(globalSlots), functionSlots(functionSlots) {}
+
+std::unique_ptr<FunctionProto> BytecodeCompiler::compile(AST* tree) {
+    auto script = std::make_unique<FunctionProto>();
+    script->name = "<script>";
+
+    FunctionState state(script.get(), true);
+    FunctionState* enclosing = current;
+    current = &state;
+    compileNode(tree);
+    emit(OpCode::RETURN, -1);
+    current = enclosing;
+    return script;
+}
+
+uint32_t BytecodeCompiler::compileFunction(FunctionDef* node) {
+    if (node->params.size() > std::numeric_limits<uint8_t>::max()) {
+        throw std::runtime_error("Too many parameters in function: " + std::string(node->name));
+    }
+
+    uint32_t index = static_cast<uint32_t>(functions.size());
+    functions.push_back(std::make_unique<FunctionProto>());
+    FunctionProto* proto = functions.back().get();
+    proto->name = std::string(node->name);
+    proto->nameId = node->symbol;
+    proto->arity = static_cast<uint16_t>(node->params.size());
+
+    FunctionState state(proto, false);
+    FunctionState* enclosing = current;
+    current = &state;
+
+    // Parameters take the first slots in call order; a repeated name binds to its last position
+    for (Symbol param : node->params) {
+        uint16_t slot = static_cast<uint16_t>(proto->localNames.size());
+        proto->localNames.push_back(param);
+        state.slots[param] = slot;
+    }
+    collectLocals(node->body.get());
+    proto->numLocals = static_cast<uint16_t>(proto->localNames.size());
+
+    compileNode(node->body.get());
+    emit(OpCode::RETURN, -1);
+
+    current = enclosing;
+    return index;
+}
+
+// Assignments inside a function create locals, so every assigned name gets a slot
+void BytecodeCompiler::collectLocals(AST* node) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                collectLocals(child.get());
+            }
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            collectLocals(ifNode->thenBranch.get());
+            collectLocals(ifNode->elseBranch.get());
+            break;
+        }
+        case NodeType::WHILE_STATEMENT:
+            collectLocals(static_cast<WhileStatement*>(node)->body.get());
+            break;
+        case NodeType::ASSIGN: {
+            AST* target = static_cast<Assign*>(node)->left.get();
+            if (target->type == NodeType::VAR) {
+                addLocal(static_cast<Var*>(target)->symbol);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+uint16_t BytecodeCompiler::addLocal(Symbol name) {
+    auto it = current->slots.find(name);
+    if (it != current->slots.end()) {
+        return it->second;
+    }
+    if (current->proto->localNames.size() >= std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Too many local variables in function: " + current->proto->name);
+    }
+    uint16_t slot = static_cast<uint16_t>(current->proto->localNames.size());
+    current->proto->localNames.push_back(name);
+    current->slots.emplace(name, slot);
+    return slot;
+}
+
+void BytecodeCompiler::compileNode(AST* node) {
+    switch (node->type) {
+        case NodeType::BIN_OP:
+            compileBinOp(static_cast<BinOp*>(node));
+            break;
+        case NodeType::NUM:
+            emitConstant(static_cast<Num*>(node)->value);
+            break;
+        case NodeType::UNARY_OP:
+            compileUnaryOp(static_cast<UnaryOp*>(node));
+            break;
+        case NodeType::COMPOUND:
+            compileCompound(static_cast<Compound*>(node));
+            break;
+        case NodeType::ASSIGN:
+            compileAssign(static_cast<Assign*>(node));
+            break;
+        case NodeType::VAR:
+            compileVar(static_cast<Var*>(node));
+            break;
+        case NodeType::NO_OP:
+            emitConstant(0.0);
+            break;
+        case NodeType::FUNCTION_DEF: {
+            auto def = static_cast<FunctionDef*>(node);
+            uint32_t index = compileFunction(def);
+            emit(OpCode::DEFINE_FUNCTION, 1);
+            emitOperand(index);
+            emitOperand(functionSlots.slotFor(def->symbol));
+            break;
+        }
+        case NodeType::FUNCTION_CALL:
+            compileFunctionCall(static_cast<FunctionCall*>(node));
+            break;
+        case NodeType::CLASS_DEF:
+            emit(OpCode::DEFINE_CLASS, 1);
+            emitOperand(static_cast<ClassDef*>(node)->symbol);
+            break;
+        case NodeType::RETURN: {
+            AST* expr = static_cast<Return*>(node)->expr.get();
+            if (!current->isScript && expr->type == NodeType::FUNCTION_CALL) {
+                // The callee takes over this frame and returns straight to our caller
+                compileFunctionCall(static_cast<FunctionCall*>(expr), OpCode::TAIL_CALL);
+                current->stackDepth--;
+            } else {
+                compileNode(expr);
+                emit(OpCode::RETURN, -1);
+            }
+            // Code after a return is unreachable; keep the statement's value slot for the bookkeeping
+            current->stackDepth++;
+            break;
+        }
+        case NodeType::IF_STATEMENT:
+            compileIfStatement(static_cast<IfStatement*>(node));
+            break;
+        case NodeType::WHILE_STATEMENT:
+            compileWhileStatement(static_cast<WhileStatement*>(node));
+            break;
+        case NodeType::ARRAY_LITERAL:
+        case NodeType::INDEX:
+            throw std::runtime_error("Arrays are not supported by the virtual machine");
+        default:
+            throw std::runtime_error("Unknown AST node");
+    }
+}
+
+void BytecodeCompiler::compileBinOp(BinOp* node) {
+    compileNode(node->left.get());
+    compileNode(node->right.get());
+
+    OpCode op;
+    switch (node->op.type) {
+        case TokenType::PLUS: op = OpCode::ADD; break;
+        case TokenType::MINUS: op = OpCode::SUBTRACT; break;
+        case TokenType::MULTIPLY: op = OpCode::MULTIPLY; break;
+        case TokenType::DIVIDE: op = OpCode::DIVIDE; break;
+        case TokenType::MODULUS: op = OpCode::MODULUS; break;
+        case TokenType::POWER: op = OpCode::POWER; break;
+        case TokenType::EQUALS: op = OpCode::EQUAL; break;
+        case TokenType::NOT_EQUALS: op = OpCode::NOT_EQUAL; break;
+        case TokenType::LESS_THAN: op = OpCode::LESS; break;
+        case TokenType::GREATER_THAN: op = OpCode::GREATER; break;
+        case TokenType::LESS_EQUAL: op = OpCode::LESS_EQUAL; break;
+        case TokenType::GREATER_EQUAL: op = OpCode::GREATER_EQUAL; break;
+        default:
+            throw std::runtime_error("Unknown operator in binary operation");
+    }
+    emit(op, -1);
+}
+
+void BytecodeCompiler::compileUnaryOp(UnaryOp* node) {
+    compileNode(node->expr.get());
+    if (node->op.type == TokenType::MINUS) {
+        emit(OpCode::NEGATE, 0);
+    } else if (node->op.type != TokenType::PLUS) {
+        throw std::runtime_error("Unknown unary operator");
+    }
+}
+
+void BytecodeCompiler::compileCompound(Compound* node) {
+    if (node->children.empty()) {
+        emitConstant(0.0);
+        return;
+    }
+    for (size_t i = 0; i < node->children.size(); ++i) {
+        if (i > 0) {
+            emit(OpCode::POP, -1);
+        }
+        compileNode(node->children[i].get());
+    }
+}
+
+void BytecodeCompiler::compileAssign(Assign* node) {
+    if (node->left->type != NodeType::VAR) {
+        throw std::runtime_error("Left-hand side of assignment must be a variable");
+    }
+    Symbol name = static_cast<Var*>(node->left.get())->symbol;
+    compileNode(node->right.get());
+    if (current->isScript) {
+        emit(OpCode::STORE_GLOBAL, 0);
+        emitOperand(globalSlots.slotFor(name));
+    } else {
+        emit(OpCode::STORE_LOCAL, 0);
+        emitOperand(addLocal(name));
+    }
+}
+
+void BytecodeCompiler::compileVar(Var* node) {
+    if (!current->isScript) {
+        auto it = current->slots.find(node->symbol);
+        if (it != current->slots.end()) {
+            emit(OpCode::LOAD_LOCAL, 1);
+            emitOperand(it->second);
+            return;
+        }
+    }
+    emit(OpCode::LOAD_GLOBAL, 1);
+    emitOperand(globalSlots.slotFor(node->symbol));
+}
+
+void BytecodeCompiler::compileFunctionCall(FunctionCall* node, OpCode op) {
+    if (node->args.size() > std::numeric_limits<uint8_t>::max()) {
+        throw std::runtime_error("Too many arguments in function call: " + std::string(node->name));
+    }
+    for (auto& arg : node->args) {
+        compileNode(arg.get());
+    }
+    uint8_t argc = static_cast<uint8_t>(node->args.size());
+    emit(op, 1 - argc);
+    emitOperand(functionSlots.slotFor(node->symbol));
+    emitOperand(argc);
+}
+
+void BytecodeCompiler::compileIfStatement(IfStatement* node) {
+    compileNode(node->condition.get());
+    size_t elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+    current->stackDepth--;
+
+    compileNode(node->thenBranch.get());
+    size_t endJump = emitJump(OpCode::JUMP);
+    current->stackDepth--;
+
+    patchJump(elseJump);
+    if (node->elseBranch) {
+        compileNode(node->elseBranch.get());
+    } else {
+        emitConstant(0.0);
+    }
+    patchJump(endJump);
+}
+
+// The body's value is dropped every iteration and the loop leaves 0, so the
+// stack is the same height at the condition on every pass
+void BytecodeCompiler::compileWhileStatement(WhileStatement* node) {
+    uint32_t loopStart = static_cast<uint32_t>(current->proto->code.size());
+    compileNode(node->condition.get());
+    size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+    current->stackDepth--;
+
+    compileNode(node->body.get());
+    emit(OpCode::POP, -1);
+    emit(OpCode::JUMP, 0);
+    emitOperand(loopStart);
+
+    patchJump(exitJump);
+    emitConstant(0.0);
+}
+
+void BytecodeCompiler::emit(OpCode op, int stackEffect) {
+    current->proto->code.push_back(static_cast<uint8_t>(op));
+    current->stackDepth += stackEffect;
+    if (current->stackDepth > current->proto->maxStack) {
+        current->proto->maxStack = current->stackDepth;
+    }
+}
+
+void BytecodeCompiler::emitConstant(double value) {
+    emit(OpCode::CONSTANT, 1);
+    emitOperand(value);
+}
+
+template <typename T>
+void BytecodeCompiler::emitOperand(T value) {
+    auto& code = current->proto->code;
+    size_t offset = code.size();
+    code.resize(offset + sizeof(T));
+    std::memcpy(&code[offset], &value, sizeof(T));
+}
+
+size_t BytecodeCompiler::emitJump(OpCode op) {
+    emit(op, 0);
+    size_t operandOffset = current->proto->code.size();
+    emitOperand<uint32_t>(0);
+    return operandOffset;
+}
+
+void BytecodeCompiler::patchJump(size_t operandOffset) {
+    uint32_t target = static_cast<uint32_t>(current->proto->code.size());
+    std::memcpy(&current->proto->code[operandOffset], &target, sizeof(target));
+}
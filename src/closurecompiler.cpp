@@ -0,0 +1,478 @@
+#include "closurecompiler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ClosureArena::~ClosureArena() {
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) {
+        it->second(it->first);
+    }
+}
+
+void* ClosureArena::allocate(size_t size, size_t alignment) {
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    if (!cursor || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+        size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+        blocks.emplace_back(new char[blockSize]);
+        cursor = blocks.back().get();
+        limit = cursor + blockSize;
+        aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    }
+    cursor = reinterpret_cast<char*>(aligned + size);
+    return reinterpret_cast<void*>(aligned);
+}
+
+namespace {
+
+struct Add {
+    static double apply(double a, double b) { return a + b; }
+};
+struct Subtract {
+    static double apply(double a, double b) { return a - b; }
+};
+struct Multiply {
+    static double apply(double a, double b) { return a * b; }
+};
+struct Divide {
+    static double apply(double a, double b) {
+        if (b == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        return a / b;
+    }
+};
+// Division by a constant known not to be zero
+struct DivideUnchecked {
+    static double apply(double a, double b) { return a / b; }
+};
+struct Modulus {
+    static double apply(double a, double b) { return std::fmod(a, b); }
+};
+struct Power {
+    static double apply(double a, double b) { return std::pow(a, b); }
+};
+
+struct Equal {
+    static bool test(double a, double b) { return a == b; }
+};
+struct NotEqual {
+    static bool test(double a, double b) { return a != b; }
+};
+struct Less {
+    static bool test(double a, double b) { return a < b; }
+};
+struct Greater {
+    static bool test(double a, double b) { return a > b; }
+};
+struct LessEqual {
+    static bool test(double a, double b) { return a <= b; }
+};
+struct GreaterEqual {
+    static bool test(double a, double b) { return a >= b; }
+};
+
+// Adapts a comparison to an arithmetic operator yielding 1.0 or 0.0
+template <typename Compare>
+struct Compared {
+    static double apply(double a, double b) { return Compare::test(a, b) ? 1.0 : 0.0; }
+};
+
+const Num* asNum(const AST* node) {
+    return node->type == NodeType::NUM ? static_cast<const Num*>(node) : nullptr;
+}
+
+// Operands are evaluated left to right; a constant operand is folded into the closure
+template <typename Op>
+Closure binary(ClosureArena& arena, const AST* leftNode, Closure left, const AST* rightNode, Closure right) {
+    if (const Num* constant = asNum(rightNode)) {
+        double b = constant->value;
+        return Closure::make(arena, [left, b]() { return Op::apply(left(), b); });
+    }
+    if (const Num* constant = asNum(leftNode)) {
+        double a = constant->value;
+        return Closure::make(arena, [a, right]() { return Op::apply(a, right()); });
+    }
+    return Closure::make(arena, [left, right]() {
+        double a = left();
+        return Op::apply(a, right());
+    });
+}
+
+template <typename Compare>
+Condition comparison(ClosureArena& arena, const AST* leftNode, Closure left, const AST* rightNode, Closure right) {
+    if (const Num* constant = asNum(rightNode)) {
+        double b = constant->value;
+        return Condition::make(arena, [left, b]() { return Compare::test(left(), b); });
+    }
+    if (const Num* constant = asNum(leftNode)) {
+        double a = constant->value;
+        return Condition::make(arena, [a, right]() { return Compare::test(a, right()); });
+    }
+    return Condition::make(arena, [left, right]() {
+        double a = left();
+        return Compare::test(a, right());
+    });
+}
+
+Closure constant(ClosureArena& arena, double value) {
+    return Closure::make(arena, [value]() { return value; });
+}
+
+} // namespace
+
+ClosureCompiler::ClosureCompiler()
+    : resolver(symbolTable), arena(nullptr), functionsVersion(1), completion(Completion::NORMAL), topLevelReturn(false),
+      tailCallee(nullptr), recursionDepth(0) {}
+
+double ClosureCompiler::interpret(ASTPtr& tree) {
+    topLevelReturn = false;
+    resolver.resolve(tree.get());
+    // A previous run may have been aborted by an error inside a function
+    symbolTable.resetScopes();
+    recursionDepth = 0;
+    completion = Completion::NORMAL;
+
+    auto programArena = std::make_unique<ClosureArena>();
+    arena = programArena.get();
+    size_t definitionsBefore = compiledFunctions.size();
+    Closure program = compile(tree.get());
+    arena = nullptr;
+    if (compiledFunctions.size() != definitionsBefore) {
+        // Function bodies must outlive this run
+        definitionArenas.push_back(std::move(programArena));
+    }
+
+    double result = program();
+    // A top-level return ends the program with its value
+    topLevelReturn = completion == Completion::RETURN;
+    completion = Completion::NORMAL;
+    return result;
+}
+
+double ClosureCompiler::getVariableValue(const std::string& name) const {
+    Symbol symbol = Interner::global().find(name);
+    if (symbol == NO_SYMBOL) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    return symbolTable.get(symbol);
+}
+
+Closure ClosureCompiler::compile(AST* node) {
+    switch (node->type) {
+        case NodeType::BIN_OP:
+            return compileBinOp(static_cast<BinOp*>(node));
+        case NodeType::NUM:
+            return constant(*arena, static_cast<Num*>(node)->value);
+        case NodeType::UNARY_OP: {
+            auto unaryOp = static_cast<UnaryOp*>(node);
+            Closure expr = compile(unaryOp->expr.get());
+            if (unaryOp->op.type == TokenType::PLUS) {
+                return expr;
+            }
+            if (unaryOp->op.type == TokenType::MINUS) {
+                return make([expr]() { return -expr(); });
+            }
+            return make([expr]() -> double {
+                expr();
+                throw std::runtime_error("Unknown unary operator");
+            });
+        }
+        case NodeType::ASSIGN:
+            return compileAssign(static_cast<Assign*>(node));
+        case NodeType::VAR:
+            return compileVar(static_cast<Var*>(node));
+        case NodeType::NO_OP:
+        case NodeType::CLASS_DEF:
+            // Classes are recorded but have no behaviour yet
+            return constant(*arena, 0.0);
+        case NodeType::COMPOUND:
+            return compileCompound(static_cast<Compound*>(node));
+        case NodeType::FUNCTION_DEF:
+            return compileFunctionDef(static_cast<FunctionDef*>(node));
+        case NodeType::FUNCTION_CALL:
+            return compileCall(static_cast<FunctionCall*>(node), false);
+        case NodeType::RETURN: {
+            AST* expr = static_cast<Return*>(node)->expr.get();
+            if (expr->type == NodeType::FUNCTION_CALL) {
+                return compileCall(static_cast<FunctionCall*>(expr), true);
+            }
+            Closure value = compile(expr);
+            return make([this, value]() {
+                double result = value();
+                completion = Completion::RETURN;
+                return result;
+            });
+        }
+        case NodeType::IF_STATEMENT:
+            return compileIf(static_cast<IfStatement*>(node));
+        case NodeType::WHILE_STATEMENT:
+            return compileWhile(static_cast<WhileStatement*>(node));
+        case NodeType::ARRAY_LITERAL:
+        case NodeType::INDEX:
+            throw std::runtime_error("Arrays are not supported by the closure compiler");
+    }
+    throw std::runtime_error("Unknown AST node");
+}
+
+Closure ClosureCompiler::compileBinOp(BinOp* node) {
+    AST* leftNode = node->left.get();
+    AST* rightNode = node->right.get();
+    Closure left = compile(leftNode);
+    Closure right = compile(rightNode);
+    switch (node->op.type) {
+        case TokenType::PLUS:
+            return binary<Add>(*arena, leftNode, left, rightNode, right);
+        case TokenType::MINUS:
+            return binary<Subtract>(*arena, leftNode, left, rightNode, right);
+        case TokenType::MULTIPLY:
+            return binary<Multiply>(*arena, leftNode, left, rightNode, right);
+        case TokenType::DIVIDE: {
+            const Num* divisor = asNum(rightNode);
+            if (divisor && divisor->value != 0) {
+                return binary<DivideUnchecked>(*arena, leftNode, left, rightNode, right);
+            }
+            // Both operands stay closures so a zero divisor is only reported when reached
+            return make([left, right]() {
+                double a = left();
+                return Divide::apply(a, right());
+            });
+        }
+        case TokenType::MODULUS:
+            return binary<Modulus>(*arena, leftNode, left, rightNode, right);
+        case TokenType::POWER:
+            return binary<Power>(*arena, leftNode, left, rightNode, right);
+        case TokenType::EQUALS:
+            return binary<Compared<Equal>>(*arena, leftNode, left, rightNode, right);
+        case TokenType::NOT_EQUALS:
+            return binary<Compared<NotEqual>>(*arena, leftNode, left, rightNode, right);
+        case TokenType::LESS_THAN:
+            return binary<Compared<Less>>(*arena, leftNode, left, rightNode, right);
+        case TokenType::GREATER_THAN:
+            return binary<Compared<Greater>>(*arena, leftNode, left, rightNode, right);
+        case TokenType::LESS_EQUAL:
+            return binary<Compared<LessEqual>>(*arena, leftNode, left, rightNode, right);
+        case TokenType::GREATER_EQUAL:
+            return binary<Compared<GreaterEqual>>(*arena, leftNode, left, rightNode, right);
+        default:
+            return make([left, right]() -> double {
+                left();
+                right();
+                throw std::runtime_error("Unknown operator in binary operation");
+            });
+    }
+}
+
+// A comparison used as a condition yields its bool directly
+Condition ClosureCompiler::compileCondition(AST* node) {
+    if (node->type == NodeType::BIN_OP) {
+        auto binOp = static_cast<BinOp*>(node);
+        AST* leftNode = binOp->left.get();
+        AST* rightNode = binOp->right.get();
+        switch (binOp->op.type) {
+            case TokenType::EQUALS:
+                return comparison<Equal>(*arena, leftNode, compile(leftNode), rightNode, compile(rightNode));
+            case TokenType::NOT_EQUALS:
+                return comparison<NotEqual>(*arena, leftNode, compile(leftNode), rightNode, compile(rightNode));
+            case TokenType::LESS_THAN:
+                return comparison<Less>(*arena, leftNode, compile(leftNode), rightNode, compile(rightNode));
+            case TokenType::GREATER_THAN:
+                return comparison<Greater>(*arena, leftNode, compile(leftNode), rightNode, compile(rightNode));
+            case TokenType::LESS_EQUAL:
+                return comparison<LessEqual>(*arena, leftNode, compile(leftNode), rightNode, compile(rightNode));
+            case TokenType::GREATER_EQUAL:
+                return comparison<GreaterEqual>(*arena, leftNode, compile(leftNode), rightNode, compile(rightNode));
+            default:
+                break;
+        }
+    }
+    Closure value = compile(node);
+    return Condition::make(*arena, [value]() { return value() != 0.0; });
+}
+
+// A read of an unassigned slot sees the global of that name, as in the Interpreter
+Closure ClosureCompiler::compileVar(Var* node) {
+    int slot = node->slot;
+    Symbol symbol = node->symbol;
+    if (node->depth == SymbolTable::LOCAL_DEPTH) {
+        return make([this, slot, symbol]() {
+            double value = symbolTable.getLocal(slot);
+            return isUndefinedSlot(value) ? symbolTable.get(symbol) : value;
+        });
+    }
+    return make([this, slot, symbol]() {
+        double value = symbolTable.getGlobal(slot);
+        return isUndefinedSlot(value) ? symbolTable.get(symbol) : value;
+    });
+}
+
+Closure ClosureCompiler::compileAssign(Assign* node) {
+    if (node->left->type != NodeType::VAR) {
+        return make([]() -> double { throw std::runtime_error("Left-hand side of assignment must be a variable"); });
+    }
+    auto var = static_cast<Var*>(node->left.get());
+    int slot = var->slot;
+    Closure value = compile(node->right.get());
+    if (var->depth == SymbolTable::LOCAL_DEPTH) {
+        return make([this, slot, value]() {
+            double result = value();
+            symbolTable.setLocal(slot, result);
+            return result;
+        });
+    }
+    return make([this, slot, value]() {
+        double result = value();
+        symbolTable.setGlobal(slot, result);
+        return result;
+    });
+}
+
+Closure ClosureCompiler::compileCompound(Compound* node) {
+    if (node->children.empty()) {
+        return constant(*arena, 0.0);
+    }
+    if (node->children.size() == 1) {
+        return compile(node->children.front().get());
+    }
+    std::vector<Closure> children;
+    children.reserve(node->children.size());
+    for (auto& child : node->children) {
+        children.push_back(compile(child.get()));
+    }
+    return make([this, children = std::move(children)]() {
+        double result = 0.0;
+        for (const Closure& child : children) {
+            result = child();
+            if (completion != Completion::NORMAL) {
+                break;
+            }
+        }
+        return result;
+    });
+}
+
+// The body is compiled with the definition; running the definition binds the name
+Closure ClosureCompiler::compileFunctionDef(FunctionDef* node) {
+    auto function = std::make_unique<CompiledFunction>();
+    function->name = node->name;
+    function->arity = node->params.size();
+    function->numLocals = node->numLocals;
+    function->body = compile(node->body.get());
+    CompiledFunction* compiled = function.get();
+    compiledFunctions.push_back(std::move(function));
+
+    Symbol symbol = node->symbol;
+    return make([this, symbol, compiled]() {
+        functions[symbol] = compiled;
+        functionsVersion++;
+        return 0.0;
+    });
+}
+
+// Arguments are evaluated left to right in the caller's scope. A returned call
+// made inside a function is a tail call: it hands its callee and arguments to
+// the receiving call instead of growing the stack.
+Closure ClosureCompiler::compileCall(FunctionCall* node, bool isReturned) {
+    std::vector<Closure> args;
+    args.reserve(node->args.size());
+    for (auto& arg : node->args) {
+        args.push_back(compile(arg.get()));
+    }
+    CallSite* site = arena->make(CallSite{node->symbol, node->name, node->args.size()});
+    return make([this, isReturned, site, args = std::move(args)]() {
+        double inlineArgs[INLINE_ARGS];
+        std::vector<double> heapArgs;
+        double* values = inlineArgs;
+        if (args.size() > INLINE_ARGS) {
+            heapArgs.resize(args.size());
+            values = heapArgs.data();
+        }
+        for (size_t i = 0; i < args.size(); ++i) {
+            values[i] = args[i]();
+        }
+        CompiledFunction* callee = resolveCall(*site);
+        if (isReturned && recursionDepth > 0) {
+            tailCallee = callee;
+            tailArgs.assign(values, values + args.size());
+            completion = Completion::TAIL_CALL;
+            return 0.0;
+        }
+        double result = callFunction(callee, values);
+        if (isReturned) {
+            completion = Completion::RETURN;
+        }
+        return result;
+    });
+}
+
+Closure ClosureCompiler::compileIf(IfStatement* node) {
+    Condition condition = compileCondition(node->condition.get());
+    Closure thenBranch = compile(node->thenBranch.get());
+    if (!node->elseBranch) {
+        return make([condition, thenBranch]() { return condition() ? thenBranch() : 0.0; });
+    }
+    Closure elseBranch = compile(node->elseBranch.get());
+    return make([condition, thenBranch, elseBranch]() { return condition() ? thenBranch() : elseBranch(); });
+}
+
+Closure ClosureCompiler::compileWhile(WhileStatement* node) {
+    Condition condition = compileCondition(node->condition.get());
+    Closure body = compile(node->body.get());
+    return make([this, condition, body]() {
+        while (condition()) {
+            double value = body();
+            if (completion != Completion::NORMAL) {
+                return value;
+            }
+        }
+        return 0.0;
+    });
+}
+
+// Call sites re-resolve only after the function table changes
+ClosureCompiler::CompiledFunction* ClosureCompiler::resolveCall(CallSite& site) {
+    if (site.version == functionsVersion) {
+        return site.callee;
+    }
+    auto found = functions.find(site.symbol);
+    if (found == functions.end()) {
+        throw std::runtime_error("Undefined function: " + std::string(site.name));
+    }
+    CompiledFunction* callee = found->second;
+    if (site.argCount != callee->arity) {
+        throw std::runtime_error("Incorrect number of arguments in function call: " + std::string(callee->name));
+    }
+    site.callee = callee;
+    site.version = functionsVersion;
+    return callee;
+}
+
+double ClosureCompiler::callFunction(CompiledFunction* function, const double* args) {
+    recursionDepth++;
+    if (recursionDepth > MAX_RECURSION_DEPTH) {
+        recursionDepth--;
+        throw std::runtime_error("Maximum recursion depth exceeded in function: " + std::string(function->name));
+    }
+
+    // Parameters occupy the first slots of the frame
+    symbolTable.enterScope(function->numLocals);
+    for (size_t i = 0; i < function->arity; ++i) {
+        symbolTable.setLocal(static_cast<int>(i), args[i]);
+    }
+
+    // A tail call replaces the frame's contents and runs the callee in its place
+    double result = function->body();
+    while (completion == Completion::TAIL_CALL) {
+        function = tailCallee;
+        symbolTable.reuseScope(function->numLocals);
+        for (size_t i = 0; i < tailArgs.size(); ++i) {
+            symbolTable.setLocal(static_cast<int>(i), tailArgs[i]);
+        }
+        completion = Completion::NORMAL;
+        result = function->body();
+    }
+    completion = Completion::NORMAL;
+
+    symbolTable.leaveScope();
+    recursionDepth--;
+    return result;
+}
@@ -0,0 +1,87 @@
+#include "interner.h"
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// This thread's view of the part of the global table it has used. A symbol
+// never changes once assigned, so entries never go stale.
+struct ThreadCache {
+    std::unordered_map<std::string_view, Symbol> symbols; // keys view the global storage
+    std::vector<std::string_view> names;                   // indexed by symbol; empty if not cached
+};
+
+thread_local ThreadCache threadCache;
+
+void cacheName(Symbol symbol, std::string_view name) {
+    if (symbol >= threadCache.names.size()) {
+        threadCache.names.resize(symbol + 1);
+    }
+    threadCache.names[symbol] = name;
+}
+
+} // namespace
+
+Interner& Interner::global() {
+    static Interner instance;
+    return instance;
+}
+
+Symbol Interner::intern(std::string_view text) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = symbols.find(text);
+        if (it != symbols.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Another thread may have added it between the two locks
+    auto it = symbols.find(text);
+    if (it != symbols.end()) {
+        return it->second;
+    }
+    Symbol symbol = static_cast<Symbol>(storage.size());
+    storage.emplace_back(text);
+    symbols.emplace(storage.back(), symbol);
+    return symbol;
+}
+
+Symbol Interner::find(std::string_view text) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = symbols.find(text);
+    return it == symbols.end() ? NO_SYMBOL : it->second;
+}
+
+std::string_view Interner::name(Symbol symbol) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return storage[symbol];
+}
+
+size_t Interner::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return storage.size();
+}
+
+Symbol intern(std::string_view text) {
+    auto it = threadCache.symbols.find(text);
+    if (it != threadCache.symbols.end()) {
+        return it->second;
+    }
+    Interner& interner = Interner::global();
+    Symbol symbol = interner.intern(text);
+    std::string_view name = interner.name(symbol);
+    threadCache.symbols.emplace(name, symbol);
+    cacheName(symbol, name);
+    return symbol;
+}
+
+std::string_view symbolName(Symbol symbol) {
+    if (symbol < threadCache.names.size() && !threadCache.names[symbol].empty()) {
+        return threadCache.names[symbol];
+    }
+    std::string_view name = Interner::global().name(symbol);
+    cacheName(symbol, name);
+    return name;
+}
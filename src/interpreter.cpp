@@ -1,50 +1,194 @@
 #include "interpreter.h"
+#include "batchevaluator.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <stdexcept>
 
-Interpreter::Interpreter() : recursionDepth(0) {}
+namespace {
+
+uint64_t nextFunctionsVersion() {
+    static std::atomic<uint64_t> version{0};
+    return ++version;
+}
+
+} // namespace
+
+Interpreter::Interpreter()
+    : resolver(symbolTable), functionsVersion(nextFunctionsVersion()), definitionsRun(0), completion(Completion::NORMAL), topLevelReturn(false), tailCallee(nullptr), globalFallbacks(0),
+      recursionDepth(0) {}
 
 double Interpreter::interpret(ASTPtr& tree) {
-    return visit(tree.get());
+    topLevelReturn = false;
+    resolver.resolve(tree.get());
+    resetRun();
+    // Arrays left over from earlier runs are only reachable through globals
+    collectArraysIfDue();
+    ProfileScope profileScope(profiler.get(), NO_SYMBOL);
+    double result = visit(tree.get());
+    // A top-level return ends the program with its value
+    topLevelReturn = completion == Completion::RETURN;
+    completion = Completion::NORMAL;
+    return result;
+}
+
+double Interpreter::interpretStatement(ASTPtr statement) {
+    size_t definitionsBefore = definitionsRun;
+    auto keepDefinitions = [&]() {
+        if (definitionsRun != definitionsBefore) {
+            definitionTrees.push_back(std::move(statement));
+        } else if (profiler) {
+            profiler->releaseTree(statement.get());
+        }
+    };
+    double result;
+    try {
+        result = interpret(statement);
+    } catch (...) {
+        // Definitions made before the error stay callable
+        keepDefinitions();
+        throw;
+    }
+    keepDefinitions();
+    return result;
 }
 
 double Interpreter::getVariableValue(const std::string& name) const {
-    return symbolTable.get(name);
+    Symbol symbol = Interner::global().find(name);
+    if (symbol == NO_SYMBOL) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    return symbolTable.get(symbol);
+}
+
+void Interpreter::setArray(const std::string& name, const std::vector<double>& values) {
+    symbolTable.set(intern(name), arrays.make(values.data(), values.size()));
+}
+
+std::vector<double> Interpreter::getArrayValue(const std::string& name) const {
+    return arrayElements(getVariableValue(name));
+}
+
+std::vector<double> Interpreter::arrayElements(double value) const {
+    ArrayHeap::View array = arrays.view(value);
+    return std::vector<double>(array.data, array.data + array.length);
+}
+
+double Interpreter::call(const std::string& function, const std::vector<double>& args) {
+    FunctionDef* funcDef = findFunction(function);
+    checkArity(funcDef, args.size());
+    resetRun();
+    return callFunction(funcDef, args);
+}
+
+bool Interpreter::evaluateBatch(const std::string& function, const std::vector<const double*>& columns, size_t rows,
+                                double* out) {
+    FunctionDef* funcDef = findFunction(function);
+    checkArity(funcDef, columns.size());
+    resetRun();
+    // Rows evaluated as columns would not reach the profiler
+    if (!profiler) {
+        BatchEvaluator evaluator(funcDef);
+        if (evaluator.isSupported() && evaluator.run(columns, rows, out, symbolTable)) {
+            return true;
+        }
+    }
+    std::vector<double> args(columns.size());
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            args[i] = columns[i][row];
+        }
+        out[row] = callFunction(funcDef, args);
+    }
+    return false;
+}
+
+// A previous run may have been aborted by an error inside a function
+void Interpreter::resetRun() {
+    symbolTable.resetScopes();
+    pinned.clear();
+    recursionDepth = 0;
+    completion = Completion::NORMAL;
+}
+
+void Interpreter::enableMemoization(size_t maxEntriesPerFunction) {
+    memoizer.emplace(maxEntriesPerFunction);
+}
+
+MemoStats Interpreter::getMemoStats() const {
+    return memoizer ? memoizer->getStats() : MemoStats();
+}
+
+void Interpreter::enableJit(unsigned hotThreshold) {
+    if (!Jit::isSupported()) {
+        return;
+    }
+    jit = std::make_unique<Jit>(hotThreshold, &Interpreter::callFromNative);
+    JitContext& context = jit->getContext();
+    context.recursionDepth = &recursionDepth;
+    context.maxRecursionDepth = MAX_RECURSION_DEPTH;
+    context.interpreter = this;
+}
+
+size_t Interpreter::getJitCompiledCount() const {
+    return jit ? jit->getCompiledCount() : 0;
+}
+
+void Interpreter::enableProfiling() {
+    profiler = std::make_unique<Profiler>();
 }
 
 double Interpreter::visit(AST* node) {
-    if (auto binOpNode = dynamic_cast<BinOp*>(node)) {
-        return visitBinOp(binOpNode);
-    } else if (auto numNode = dynamic_cast<Num*>(node)) {
-        return visitNum(numNode);
-    } else if (auto unaryOpNode = dynamic_cast<UnaryOp*>(node)) {
-        return visitUnaryOp(unaryOpNode);
-    } else if (auto assignNode = dynamic_cast<Assign*>(node)) {
-        return visitAssign(assignNode);
-    } else if (auto varNode = dynamic_cast<Var*>(node)) {
-        return visitVar(varNode);
-    } else if (auto noOpNode = dynamic_cast<NoOp*>(node)) {
-        return visitNoOp(noOpNode);
-    } else if (auto compoundNode = dynamic_cast<Compound*>(node)) {
-        return visitCompound(compoundNode);
-    } else if (auto funcDefNode = dynamic_cast<FunctionDef*>(node)) {
-        return visitFunctionDef(funcDefNode);
-    } else if (auto funcCallNode = dynamic_cast<FunctionCall*>(node)) {
-        return visitFunctionCall(funcCallNode);
-    } else if (auto classDefNode = dynamic_cast<ClassDef*>(node)) {
-        return visitClassDef(classDefNode);
-    } else if (auto returnNode = dynamic_cast<Return*>(node)) {
-        return visitReturn(returnNode);
-    } else if (auto ifNode = dynamic_cast<IfStatement*>(node)) {
-        return visitIfStatement(ifNode);
-    } else {
-        throw std::runtime_error("Unknown AST node");
+    if (profiler) {
+        profiler->countNode(node);
+    }
+    switch (node->type) {
+        case NodeType::BIN_OP:
+            return visitBinOp(static_cast<BinOp*>(node));
+        case NodeType::NUM:
+            return visitNum(static_cast<Num*>(node));
+        case NodeType::UNARY_OP:
+            return visitUnaryOp(static_cast<UnaryOp*>(node));
+        case NodeType::ASSIGN:
+            return visitAssign(static_cast<Assign*>(node));
+        case NodeType::VAR:
+            return visitVar(static_cast<Var*>(node));
+        case NodeType::NO_OP:
+            return visitNoOp(static_cast<NoOp*>(node));
+        case NodeType::COMPOUND:
+            return visitCompound(static_cast<Compound*>(node));
+        case NodeType::FUNCTION_DEF:
+            return visitFunctionDef(static_cast<FunctionDef*>(node));
+        case NodeType::FUNCTION_CALL:
+            return visitFunctionCall(static_cast<FunctionCall*>(node));
+        case NodeType::CLASS_DEF:
+            return visitClassDef(static_cast<ClassDef*>(node));
+        case NodeType::RETURN:
+            return visitReturn(static_cast<Return*>(node));
+        case NodeType::IF_STATEMENT:
+            return visitIfStatement(static_cast<IfStatement*>(node));
+        case NodeType::WHILE_STATEMENT:
+            return visitWhileStatement(static_cast<WhileStatement*>(node));
+        case NodeType::ARRAY_LITERAL:
+            return visitArrayLiteral(static_cast<ArrayLiteral*>(node));
+        case NodeType::INDEX:
+            return visitIndex(static_cast<Index*>(node));
     }
+    throw std::runtime_error("Unknown AST node");
 }
 
 double Interpreter::visitBinOp(BinOp* node) {
     double left = visit(node->left.get());
+    if (isArrayValue(left)) {
+        pinned.push_back(left);
+        double right = visit(node->right.get());
+        pinned.pop_back();
+        return arrayArithmetic(arrays, node->op.type, left, right);
+    }
     double right = visit(node->right.get());
+    if (isArrayValue(right)) {
+        return arrayArithmetic(arrays, node->op.type, left, right);
+    }
 
     switch (node->op.type) {
         case TokenType::PLUS:
@@ -89,25 +233,30 @@ double Interpreter::visitUnaryOp(UnaryOp* node) {
     if (node->op.type == TokenType::PLUS) {
         return +value;
     } else if (node->op.type == TokenType::MINUS) {
-        return -value;
+        return isArrayValue(value) ? arrayNegate(arrays, value) : -value;
     } else {
         throw std::runtime_error("Unknown unary operator");
     }
 }
 
 double Interpreter::visitAssign(Assign* node) {
-    Var* varNode = dynamic_cast<Var*>(node->left.get());
-    if (!varNode) {
+    if (node->left->type != NodeType::VAR) {
         throw std::runtime_error("Left-hand side of assignment must be a variable");
     }
-    std::string varName = varNode->value;
+    Var* varNode = static_cast<Var*>(node->left.get());
     double value = visit(node->right.get());
-    symbolTable.set(varName, value);
+    symbolTable.set(varNode->depth, varNode->slot, value);
     return value;
 }
 
 double Interpreter::visitVar(Var* node) {
-    return symbolTable.get(node->value);
+    double value = symbolTable.get(node->depth, node->slot);
+    if (isUndefinedSlot(value)) {
+        // A local read before its first assignment sees the global of that name
+        globalFallbacks++;
+        return symbolTable.get(node->symbol);
+    }
+    return value;
 }
 
 double Interpreter::visitNoOp(NoOp* node) {
@@ -118,71 +267,251 @@ double Interpreter::visitCompound(Compound* node) {
     double result = 0.0;
     for (auto& child : node->children) {
         result = visit(child.get());
+        if (completion != Completion::NORMAL) {
+            break;
+        }
     }
     return result;
 }
 
 double Interpreter::visitFunctionDef(FunctionDef* node) {
-    // Store the function definition in the functions map
-    functions[node->name] = node;
+    // Store the function definition in the function table
+    functions[node->symbol] = node;
+    functionsVersion = nextFunctionsVersion();
+    definitionsRun++;
+    if (memoizer) {
+        // Cached results of any caller may depend on the previous definition
+        memoizer->invalidate();
+    }
+    if (jit) {
+        // Native callers bound the previous definition
+        jit->invalidate();
+    }
     return 0.0;
 }
 
+// Arguments are evaluated left to right in the caller's scope. Arrays among
+// them are pinned while the later ones run, since those may collect.
+std::vector<double> Interpreter::evaluateArgs(FunctionCall* node) {
+    std::vector<double> argValues;
+    argValues.reserve(node->args.size());
+    size_t pinnedBefore = pinned.size();
+    for (auto& arg : node->args) {
+        double value = visit(arg.get());
+        if (isArrayValue(value)) {
+            pinned.push_back(value);
+        }
+        argValues.push_back(value);
+    }
+    pinned.resize(pinnedBefore);
+    return argValues;
+}
+
+FunctionDef* Interpreter::findFunction(const std::string& name) const {
+    Symbol symbol = Interner::global().find(name);
+    FunctionDef* funcDef = findDefinition(functions, symbol);
+    if (!funcDef) {
+        throw std::runtime_error("Undefined function: " + name);
+    }
+    return funcDef;
+}
+
+// Call sites re-resolve only after the function table changes. A name the
+// program has not defined may still be an array builtin.
+FunctionDef* Interpreter::resolveCall(FunctionCall* node) {
+    if (node->cachedVersion == functionsVersion) {
+        return node->cachedCallee;
+    }
+    FunctionDef* funcDef = findDefinition(functions, node->symbol);
+    if (funcDef) {
+        checkArity(funcDef, node->args.size());
+    } else if (findArrayBuiltin(node->symbol) == ArrayBuiltin::NONE) {
+        throw std::runtime_error("Undefined function: " + std::string(node->name));
+    }
+    node->cachedCallee = funcDef;
+    node->cachedVersion = functionsVersion;
+    return funcDef;
+}
+
+void Interpreter::checkArity(FunctionDef* funcDef, size_t argCount) const {
+    if (argCount != funcDef->params.size()) {
+        throw std::runtime_error("Incorrect number of arguments in function call: " + std::string(funcDef->name));
+    }
+}
+
 double Interpreter::visitFunctionCall(FunctionCall* node) {
-    auto it = functions.find(node->name);
-    if (it == functions.end()) {
-        throw std::runtime_error("Undefined function: " + node->name);
+    std::vector<double> argValues = evaluateArgs(node);
+    FunctionDef* funcDef = resolveCall(node);
+    if (!funcDef) {
+        return callBuiltin(node->symbol, argValues);
+    }
+    return callFunction(funcDef, argValues);
+}
+
+double Interpreter::callBuiltin(Symbol symbol, const std::vector<double>& argValues) const {
+    return callArrayBuiltin(arrays, findArrayBuiltin(symbol), symbol, argValues.data(), argValues.size());
+}
+
+// Marks what the program can still reach and frees the other arrays
+void Interpreter::collectArrays() {
+    symbolTable.forEachValue([this](double value) { arrays.mark(value); });
+    for (double value : tailArgs) {
+        arrays.mark(value);
+    }
+    for (double value : pinned) {
+        arrays.mark(value);
+    }
+    arrays.sweep();
+}
+
+double Interpreter::callFunction(FunctionDef* funcDef, const std::vector<double>& argValues) {
+    bool arrayArgs = std::any_of(argValues.begin(), argValues.end(), isArrayValue);
+    // Native code would bypass the profiler's counters, and only holds numbers
+    if (jit && !memoizer && !profiler && !arrayArgs) {
+        if (NativeFunction entry = jit->entryFor(funcDef)) {
+            return runNative(entry, funcDef, argValues);
+        }
     }
 
-    FunctionDef* funcDef = it->second;
+    ProfileScope profileScope(profiler.get(), funcDef->symbol);
+    // Array handles are not stable keys: a freed array's handle can come back
+    bool memoize = memoizer && !arrayArgs && memoizer->isPure(funcDef, functions);
+    if (memoize) {
+        if (const double* cached = memoizer->lookup(funcDef, argValues)) {
+            return *cached;
+        }
+    }
+    size_t fallbacksBefore = globalFallbacks;
 
     // Check for maximum recursion depth
     recursionDepth++;
     if (recursionDepth > MAX_RECURSION_DEPTH) {
         recursionDepth--;
-        throw std::runtime_error("Maximum recursion depth exceeded in function: " + node->name);
+        throw std::runtime_error("Maximum recursion depth exceeded in function: " + std::string(funcDef->name));
     }
 
-    // Create a new symbol table for the function scope
-    symbolTable.enterScope();
+    // Create a new frame for the function scope
+    symbolTable.enterScope(funcDef->numLocals);
 
-    // Check if the number of arguments matches
-    if (node->args.size() != funcDef->params.size()) {
-        recursionDepth--;
-        throw std::runtime_error("Incorrect number of arguments in function call: " + node->name);
+    // Parameters occupy the first slots of the frame
+    for (size_t i = 0; i < argValues.size(); ++i) {
+        symbolTable.set(SymbolTable::LOCAL_DEPTH, static_cast<int>(i), argValues[i]);
     }
+    collectArraysIfDue();
 
-    // Assign arguments to parameters
-    for (size_t i = 0; i < node->args.size(); ++i) {
-        double argValue = visit(node->args[i].get());
-        symbolTable.set(funcDef->params[i], argValue);
-    }
-
-    double result = 0.0;
-
-    // Execute the function body
-    try {
-        result = visit(funcDef->body.get());
-    } catch (const ReturnException& ret) {
-        result = ret.value;
+    // Execute the function body; a return inside it completes the call, and a
+    // tail call replaces the frame's contents and runs the callee in its place
+    FunctionDef* current = funcDef;
+    double result = visit(current->body.get());
+    while (completion == Completion::TAIL_CALL) {
+        current = tailCallee;
+        if (profiler) {
+            // The callee takes over the caller's frame, and its place in the stack
+            profiler->leave();
+            profiler->enter(current->symbol);
+        }
+        symbolTable.reuseScope(current->numLocals);
+        for (size_t i = 0; i < tailArgs.size(); ++i) {
+            symbolTable.set(SymbolTable::LOCAL_DEPTH, static_cast<int>(i), tailArgs[i]);
+        }
+        collectArraysIfDue();
+        completion = Completion::NORMAL;
+        result = visit(current->body.get());
     }
+    completion = Completion::NORMAL;
 
     // Clean up
     symbolTable.leaveScope();
     recursionDepth--;
 
+    if (memoize && globalFallbacks == fallbacksBefore && !isArrayValue(result)) {
+        memoizer->store(funcDef, argValues, result);
+    }
     return result;
 }
 
+// Native code reports errors through the context; they become the same
+// exceptions the interpreted call would have thrown
+double Interpreter::runNative(NativeFunction entry, FunctionDef* funcDef, const std::vector<double>& argValues) {
+    JitContext& context = jit->getContext();
+    context.error = JitError::NONE;
+    int depthBefore = recursionDepth;
+    double result = entry(&context, argValues.data(), funcDef->symbol, static_cast<uint32_t>(argValues.size()));
+    switch (context.error) {
+        case JitError::NONE:
+            return result;
+        case JitError::RECURSION_DEPTH:
+            throw std::runtime_error("Maximum recursion depth exceeded in function: " +
+                                     std::string(symbolName(context.errorSymbol)));
+        case JitError::ARGUMENT_COUNT:
+            throw std::runtime_error("Incorrect number of arguments in function call: " +
+                                     std::string(symbolName(context.errorSymbol)));
+        case JitError::DIVISION_BY_ZERO:
+            throw std::runtime_error("Division by zero");
+        case JitError::EXCEPTION:
+            std::rethrow_exception(jit->takePendingException());
+        case JitError::ARRAY_VALUE:
+            // Functions only change their own frames, so the call can start over
+            recursionDepth = depthBefore;
+            jit->exclude(funcDef);
+            return callFunction(funcDef, argValues);
+    }
+    throw std::runtime_error("Unknown native code error");
+}
+
+// Exceptions must not unwind through native frames, so they are parked in the
+// Jit until the runNative that entered native code rethrows them
+double Interpreter::callFromNative(JitContext* context, const double* args, Symbol symbol, uint32_t argc) {
+    Interpreter* interpreter = context->interpreter;
+    try {
+        FunctionDef* funcDef = findDefinition(interpreter->functions, symbol);
+        if (!funcDef) {
+            ArrayBuiltin builtin = findArrayBuiltin(symbol);
+            if (builtin == ArrayBuiltin::NONE) {
+                throw std::runtime_error("Undefined function: " + std::string(symbolName(symbol)));
+            }
+            return callArrayBuiltin(interpreter->arrays, builtin, symbol, args, argc);
+        }
+        interpreter->checkArity(funcDef, argc);
+        double result = interpreter->callFunction(funcDef, std::vector<double>(args, args + argc));
+        if (isArrayValue(result)) {
+            context->error = JitError::ARRAY_VALUE;
+            return 0.0;
+        }
+        return result;
+    } catch (...) {
+        interpreter->jit->setPendingException(std::current_exception());
+        context->error = JitError::EXCEPTION;
+        return 0.0;
+    }
+}
+
 double Interpreter::visitClassDef(ClassDef* node) {
     // For simplicity, store class definitions similarly to functions
-    classes[node->name] = node;
+    classes[node->symbol] = node;
+    definitionsRun++;
     return 0.0;
 }
 
 double Interpreter::visitReturn(Return* node) {
+    if (recursionDepth > 0 && node->expr->type == NodeType::FUNCTION_CALL) {
+        // A call in tail position runs in the current frame once this body unwinds
+        auto call = static_cast<FunctionCall*>(node->expr.get());
+        std::vector<double> argValues = evaluateArgs(call);
+        FunctionDef* callee = resolveCall(call);
+        if (!callee) {
+            double value = callBuiltin(call->symbol, argValues);
+            completion = Completion::RETURN;
+            return value;
+        }
+        tailCallee = callee;
+        tailArgs = std::move(argValues);
+        completion = Completion::TAIL_CALL;
+        return 0.0;
+    }
     double value = visit(node->expr.get());
-    throw ReturnException(value);
+    completion = Completion::RETURN;
+    return value;
 }
 
 double Interpreter::visitIfStatement(IfStatement* node) {
@@ -194,3 +523,40 @@ double Interpreter::visitIfStatement(IfStatement* node) {
     }
     return 0.0;
 }
+
+// The body runs in the current frame; a return or tail call inside it ends the loop
+double Interpreter::visitWhileStatement(WhileStatement* node) {
+    while (visit(node->condition.get()) != 0.0) {
+        double value = visit(node->body.get());
+        if (completion != Completion::NORMAL) {
+            return value;
+        }
+        collectArraysIfDue();
+    }
+    return 0.0;
+}
+
+double Interpreter::visitArrayLiteral(ArrayLiteral* node) {
+    std::vector<double> values;
+    values.reserve(node->elements.size());
+    for (auto& element : node->elements) {
+        double value = visit(element.get());
+        if (isArrayValue(value)) {
+            throw std::runtime_error("Array elements must be numbers");
+        }
+        values.push_back(value);
+    }
+    return arrays.make(values.data(), values.size());
+}
+
+double Interpreter::visitIndex(Index* node) {
+    double array = visit(node->array.get());
+    pinned.push_back(array);
+    double index = visit(node->index.get());
+    pinned.pop_back();
+    ArrayHeap::View view = arrays.view(array);
+    if (!(index >= 0 && index < static_cast<double>(view.length)) || index != std::floor(index)) {
+        throw std::runtime_error("Array index out of range");
+    }
+    return view.data[static_cast<size_t>(index)];
+}
@@ -0,0 +1,623 @@
+#include "jit.h"
+#include "symboltable.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::is_standard_layout<JitContext>::value, "Native code addresses JitContext by offset");
+
+#ifdef JIT_X86_64
+
+namespace {
+
+constexpr int32_t RECURSION_DEPTH_OFFSET = static_cast<int32_t>(offsetof(JitContext, recursionDepth));
+constexpr int32_t MAX_DEPTH_OFFSET = static_cast<int32_t>(offsetof(JitContext, maxRecursionDepth));
+constexpr int32_t ERROR_OFFSET = static_cast<int32_t>(offsetof(JitContext, error));
+constexpr int32_t ERROR_SYMBOL_OFFSET = static_cast<int32_t>(offsetof(JitContext, errorSymbol));
+constexpr int32_t ENTRIES_OFFSET = static_cast<int32_t>(offsetof(JitContext, entries));
+
+// Condition predicates of CMPSD
+constexpr uint8_t CMP_EQ = 0;
+constexpr uint8_t CMP_LT = 1;
+constexpr uint8_t CMP_LE = 2;
+constexpr uint8_t CMP_NEQ = 4;
+
+uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Just the x86-64 encodings the code generator needs. Values live in xmm0 and
+// xmm1; rbx holds the JitContext and r12 the recursion depth counter.
+class Assembler {
+public:
+    struct Label {
+        size_t target = SIZE_MAX;
+        std::vector<size_t> uses; // offsets of rel32 fields
+    };
+
+    std::vector<uint8_t> code;
+
+    size_t position() const { return code.size(); }
+
+    void emit(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+
+    void emit32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void emit64(uint64_t value) {
+        emit32(static_cast<uint32_t>(value));
+        emit32(static_cast<uint32_t>(value >> 32));
+    }
+
+    void patch32(size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            code[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    // Jump or call opcode followed by a rel32 to the label
+    void branch(std::initializer_list<uint8_t> opcode, Label& label) {
+        emit(opcode);
+        label.uses.push_back(position());
+        emit32(0);
+    }
+    void jmp(Label& label) { branch({0xE9}, label); }
+    void je(Label& label) { branch({0x0F, 0x84}, label); }
+    void jne(Label& label) { branch({0x0F, 0x85}, label); }
+    void jp(Label& label) { branch({0x0F, 0x8A}, label); }
+    void jg(Label& label) { branch({0x0F, 0x8F}, label); }
+
+    void bind(Label& label) { label.target = position(); }
+
+    void resolve(const Label& label) {
+        for (size_t use : label.uses) {
+            patch32(use, static_cast<uint32_t>(static_cast<int32_t>(label.target - (use + 4))));
+        }
+    }
+
+    // movsd xmm, [rbp + disp]
+    void loadSlot(uint8_t xmm, int32_t disp) {
+        emit({0xF2, 0x0F, 0x10, static_cast<uint8_t>(0x85 | (xmm << 3))});
+        emit32(static_cast<uint32_t>(disp));
+    }
+
+    // movsd [rbp + disp], xmm
+    void storeSlot(uint8_t xmm, int32_t disp) {
+        emit({0xF2, 0x0F, 0x11, static_cast<uint8_t>(0x85 | (xmm << 3))});
+        emit32(static_cast<uint32_t>(disp));
+    }
+
+    // mov rax, imm64; movq xmm, rax
+    void loadBits(uint8_t xmm, uint64_t bits) {
+        emit({0x48, 0xB8});
+        emit64(bits);
+        emit({0x66, 0x48, 0x0F, 0x6E, static_cast<uint8_t>(0xC0 | (xmm << 3))});
+    }
+
+    // op xmm0, xmm1 for the F2-prefixed scalar arithmetic opcodes
+    void scalar(uint8_t opcode) { emit({0xF2, 0x0F, opcode, 0xC1}); }
+
+    // mov dword [rbx + disp], imm32
+    void storeContext32(int32_t disp, uint32_t value) {
+        emit({0xC7, 0x83});
+        emit32(static_cast<uint32_t>(disp));
+        emit32(value);
+    }
+
+    // mov rax, imm64; call rax
+    void callAbsolute(const void* target) {
+        emit({0x48, 0xB8});
+        emit64(reinterpret_cast<uint64_t>(target));
+        emit({0xFF, 0xD0});
+    }
+
+    // Branches to label if the error field of the context is set
+    void checkError(Label& label) {
+        emit({0x83, 0xBB});
+        emit32(static_cast<uint32_t>(ERROR_OFFSET));
+        emit({0x00});
+        jne(label);
+    }
+};
+
+// Translates one FunctionDef into a native function with the NativeFunction
+// signature. Every node leaves its value in xmm0, the way every Interpreter
+// visit method returns one. Locals and temporaries live in the stack frame.
+class NativeCodegen {
+public:
+    NativeCodegen(FunctionDef* function, Jit& jit)
+        : function(function), jit(jit), assigned(function->numLocals, false) {}
+
+    // False if the function uses anything native code does not support
+    bool generate() {
+        emitPrologue();
+        if (!node(function->body.get())) {
+            return false;
+        }
+        emitEpilogue();
+        return true;
+    }
+
+    const std::vector<uint8_t>& code() const { return a.code; }
+
+private:
+    FunctionDef* function;
+    Jit& jit;
+    Assembler a;
+    // Locals certainly assigned on every path reaching the current point
+    std::vector<bool> assigned;
+    int tempTop = 0;
+    int maxTemps = 0;
+    size_t frameSizeField = 0;
+    Assembler::Label bodyStart, exitLabel, epilogueLabel, depthError, arityError, divisionError;
+
+    static int32_t slotOffset(int slot) {
+        // rbx and r12 are saved just below rbp
+        return -24 - 8 * slot;
+    }
+
+    int32_t tempOffset(int temp) const { return slotOffset(function->numLocals + temp); }
+
+    int allocateTemps(int count) {
+        int first = tempTop;
+        tempTop += count;
+        if (tempTop > maxTemps) {
+            maxTemps = tempTop;
+        }
+        return first;
+    }
+
+    void releaseTemps(int count) { tempTop -= count; }
+
+    void markUnreachable() { assigned.assign(assigned.size(), true); }
+
+    void emitPrologue() {
+        a.emit({0x55});                   // push rbp
+        a.emit({0x48, 0x89, 0xE5});       // mov rbp, rsp
+        a.emit({0x53});                   // push rbx
+        a.emit({0x41, 0x54});             // push r12
+        a.emit({0x48, 0x81, 0xEC});       // sub rsp, frame size
+        frameSizeField = a.position();
+        a.emit32(0);
+        a.emit({0x48, 0x89, 0xFB});       // mov rbx, rdi
+        a.emit({0x4C, 0x8B, 0xA3});       // mov r12, [rbx + recursionDepth]
+        a.emit32(static_cast<uint32_t>(RECURSION_DEPTH_OFFSET));
+
+        // Same order as Interpreter::visitFunctionCall: depth first, then arity
+        a.emit({0x41, 0x8B, 0x04, 0x24}); // mov eax, [r12]
+        a.emit({0xFF, 0xC0});             // inc eax
+        a.emit({0x3B, 0x83});             // cmp eax, [rbx + maxRecursionDepth]
+        a.emit32(static_cast<uint32_t>(MAX_DEPTH_OFFSET));
+        a.jg(depthError);
+        a.emit({0x41, 0x89, 0x04, 0x24}); // mov [r12], eax
+        a.emit({0x81, 0xF9});             // cmp ecx, arity
+        a.emit32(static_cast<uint32_t>(function->params.size()));
+        a.jne(arityError);
+
+        // Parameters occupy the first slots of the frame
+        for (size_t i = 0; i < function->params.size(); ++i) {
+            a.emit({0xF2, 0x0F, 0x10, 0x86}); // movsd xmm0, [rsi + 8i]
+            a.emit32(static_cast<uint32_t>(8 * i));
+            a.storeSlot(0, slotOffset(static_cast<int>(i)));
+            assigned[i] = true;
+        }
+        a.bind(bodyStart);
+    }
+
+    void emitEpilogue() {
+        a.bind(exitLabel);
+        a.emit({0x41, 0xFF, 0x0C, 0x24}); // dec dword [r12]
+        a.bind(epilogueLabel);
+        a.emit({0x48, 0x81, 0xC4});       // add rsp, frame size
+        size_t restoreField = a.position();
+        a.emit32(0);
+        a.emit({0x41, 0x5C});             // pop r12
+        a.emit({0x5B});                   // pop rbx
+        a.emit({0x5D});                   // pop rbp
+        a.emit({0xC3});                   // ret
+
+        a.bind(depthError);
+        a.storeContext32(ERROR_OFFSET, static_cast<uint32_t>(JitError::RECURSION_DEPTH));
+        a.emit({0x89, 0x93});             // mov [rbx + errorSymbol], edx
+        a.emit32(static_cast<uint32_t>(ERROR_SYMBOL_OFFSET));
+        a.jmp(epilogueLabel);
+
+        a.bind(arityError);
+        a.emit({0x41, 0xFF, 0x0C, 0x24}); // dec dword [r12]
+        a.storeContext32(ERROR_OFFSET, static_cast<uint32_t>(JitError::ARGUMENT_COUNT));
+        a.emit({0x89, 0x93});             // mov [rbx + errorSymbol], edx
+        a.emit32(static_cast<uint32_t>(ERROR_SYMBOL_OFFSET));
+        a.jmp(epilogueLabel);
+
+        a.bind(divisionError);
+        a.storeContext32(ERROR_OFFSET, static_cast<uint32_t>(JitError::DIVISION_BY_ZERO));
+        a.jmp(exitLabel);
+
+        // Keep rsp 16-byte aligned at calls: three pushes leave it aligned
+        uint32_t frameSize = static_cast<uint32_t>(8 * (function->numLocals + maxTemps) + 15) & ~15u;
+        a.patch32(frameSizeField, frameSize);
+        a.patch32(restoreField, frameSize);
+        for (const Assembler::Label* label :
+             {&bodyStart, &exitLabel, &epilogueLabel, &depthError, &arityError, &divisionError}) {
+            a.resolve(*label);
+        }
+    }
+
+    bool node(AST* node) {
+        switch (node->type) {
+            case NodeType::NUM:
+                a.loadBits(0, bitsOf(static_cast<Num*>(node)->value));
+                return true;
+            case NodeType::VAR: {
+                auto var = static_cast<Var*>(node);
+                // Globals, and locals that may fall back to a global, stay interpreted
+                if (var->depth != SymbolTable::LOCAL_DEPTH || !assigned[var->slot]) {
+                    return false;
+                }
+                a.loadSlot(0, slotOffset(var->slot));
+                return true;
+            }
+            case NodeType::UNARY_OP:
+                return unaryOp(static_cast<UnaryOp*>(node));
+            case NodeType::BIN_OP:
+                return binOp(static_cast<BinOp*>(node));
+            case NodeType::COMPOUND: {
+                auto compound = static_cast<Compound*>(node);
+                if (compound->children.empty()) {
+                    a.loadBits(0, 0);
+                }
+                for (auto& child : compound->children) {
+                    if (!this->node(child.get())) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case NodeType::ASSIGN: {
+                auto assign = static_cast<Assign*>(node);
+                if (assign->left->type != NodeType::VAR) {
+                    return false;
+                }
+                auto var = static_cast<Var*>(assign->left.get());
+                if (var->depth != SymbolTable::LOCAL_DEPTH || !this->node(assign->right.get())) {
+                    return false;
+                }
+                a.storeSlot(0, slotOffset(var->slot));
+                assigned[var->slot] = true;
+                return true;
+            }
+            case NodeType::NO_OP:
+                a.loadBits(0, 0);
+                return true;
+            case NodeType::FUNCTION_CALL:
+                return call(static_cast<FunctionCall*>(node));
+            case NodeType::RETURN:
+                return returnStatement(static_cast<Return*>(node));
+            case NodeType::IF_STATEMENT:
+                return ifStatement(static_cast<IfStatement*>(node));
+            case NodeType::WHILE_STATEMENT:
+                return whileStatement(static_cast<WhileStatement*>(node));
+            case NodeType::FUNCTION_DEF:
+            case NodeType::CLASS_DEF:
+            case NodeType::ARRAY_LITERAL:
+            case NodeType::INDEX:
+                return false;
+        }
+        return false;
+    }
+
+    bool unaryOp(UnaryOp* node) {
+        if (!this->node(node->expr.get())) {
+            return false;
+        }
+        if (node->op.type == TokenType::MINUS) {
+            a.loadBits(1, 0x8000000000000000ULL);
+            a.emit({0x66, 0x0F, 0x57, 0xC1}); // xorpd xmm0, xmm1
+            return true;
+        }
+        return node->op.type == TokenType::PLUS;
+    }
+
+    bool binOp(BinOp* node) {
+        if (!this->node(node->left.get())) {
+            return false;
+        }
+        int temp = allocateTemps(1);
+        a.storeSlot(0, tempOffset(temp));
+        if (!this->node(node->right.get())) {
+            return false;
+        }
+        a.emit({0x66, 0x0F, 0x28, 0xC8}); // movapd xmm1, xmm0
+        a.loadSlot(0, tempOffset(temp));
+        releaseTemps(1);
+
+        switch (node->op.type) {
+            case TokenType::PLUS: a.scalar(0x58); return true;     // addsd
+            case TokenType::MINUS: a.scalar(0x5C); return true;    // subsd
+            case TokenType::MULTIPLY: a.scalar(0x59); return true; // mulsd
+            case TokenType::DIVIDE: {
+                // right == 0 is false for NaN, so only an ordered equal traps
+                Assembler::Label nonZero;
+                a.emit({0x66, 0x0F, 0x57, 0xD2}); // xorpd xmm2, xmm2
+                a.emit({0x66, 0x0F, 0x2E, 0xCA}); // ucomisd xmm1, xmm2
+                a.jp(nonZero);
+                a.je(divisionError);
+                a.bind(nonZero);
+                a.resolve(nonZero);
+                a.scalar(0x5E);                   // divsd
+                return true;
+            }
+            case TokenType::MODULUS:
+                a.callAbsolute(reinterpret_cast<const void*>(static_cast<double (*)(double, double)>(std::fmod)));
+                return true;
+            case TokenType::POWER:
+                a.callAbsolute(reinterpret_cast<const void*>(static_cast<double (*)(double, double)>(std::pow)));
+                return true;
+            case TokenType::EQUALS: compare(CMP_EQ, false); return true;
+            case TokenType::NOT_EQUALS: compare(CMP_NEQ, false); return true;
+            case TokenType::LESS_THAN: compare(CMP_LT, false); return true;
+            case TokenType::LESS_EQUAL: compare(CMP_LE, false); return true;
+            case TokenType::GREATER_THAN: compare(CMP_LT, true); return true;
+            case TokenType::GREATER_EQUAL: compare(CMP_LE, true); return true;
+            default:
+                return false;
+        }
+    }
+
+    // Produces 1.0 or 0.0 in xmm0 from a CMPSD mask; swapped compares right with left
+    void compare(uint8_t predicate, bool swapped) {
+        if (swapped) {
+            a.emit({0xF2, 0x0F, 0xC2, 0xC8, predicate}); // cmpsd xmm1, xmm0, predicate
+            a.emit({0x66, 0x0F, 0x28, 0xC1});            // movapd xmm0, xmm1
+        } else {
+            a.emit({0xF2, 0x0F, 0xC2, 0xC1, predicate}); // cmpsd xmm0, xmm1, predicate
+        }
+        a.loadBits(1, bitsOf(1.0));
+        a.emit({0x66, 0x0F, 0x54, 0xC1}); // andpd xmm0, xmm1
+    }
+
+    // Evaluates arguments left to right into consecutive temporaries, argument 0 at the lowest address
+    bool arguments(FunctionCall* node, int& firstTemp) {
+        int count = static_cast<int>(node->args.size());
+        firstTemp = allocateTemps(count);
+        for (int i = 0; i < count; ++i) {
+            if (!this->node(node->args[i].get())) {
+                return false;
+            }
+            a.storeSlot(0, tempOffset(firstTemp + count - 1 - i));
+        }
+        return true;
+    }
+
+    bool call(FunctionCall* node) {
+        int firstTemp;
+        if (!arguments(node, firstTemp)) {
+            return false;
+        }
+        int count = static_cast<int>(node->args.size());
+        a.emit({0x48, 0x89, 0xDF});       // mov rdi, rbx
+        a.emit({0x48, 0x8D, 0xB5});       // lea rsi, [rbp + first argument]
+        a.emit32(static_cast<uint32_t>(tempOffset(firstTemp + (count > 0 ? count - 1 : 0))));
+        a.emit({0xBA});                   // mov edx, symbol
+        a.emit32(node->symbol);
+        a.emit({0xB9});                   // mov ecx, argc
+        a.emit32(static_cast<uint32_t>(count));
+        a.emit({0x48, 0x8B, 0x83});       // mov rax, [rbx + entries]
+        a.emit32(static_cast<uint32_t>(ENTRIES_OFFSET));
+        a.emit({0xFF, 0x90});             // call [rax + 8 * slot]
+        a.emit32(8 * jit.slotFor(node->symbol));
+        a.checkError(exitLabel);
+        releaseTemps(count);
+        return true;
+    }
+
+    bool returnStatement(Return* node) {
+        AST* expr = node->expr.get();
+        if (expr->type == NodeType::FUNCTION_CALL) {
+            auto call = static_cast<FunctionCall*>(expr);
+            // Tail calls to other functions keep the interpreter's constant depth only there
+            if (call->symbol != function->symbol || call->args.size() != function->params.size()) {
+                return false;
+            }
+            int firstTemp;
+            if (!arguments(call, firstTemp)) {
+                return false;
+            }
+            int count = static_cast<int>(call->args.size());
+            for (int i = 0; i < count; ++i) {
+                a.loadSlot(0, tempOffset(firstTemp + count - 1 - i));
+                a.storeSlot(0, slotOffset(i));
+            }
+            releaseTemps(count);
+            a.jmp(bodyStart);
+            markUnreachable();
+            return true;
+        }
+        if (!this->node(expr)) {
+            return false;
+        }
+        a.jmp(exitLabel);
+        markUnreachable();
+        return true;
+    }
+
+    bool ifStatement(IfStatement* node) {
+        if (!this->node(node->condition.get())) {
+            return false;
+        }
+        Assembler::Label thenLabel, elseLabel, endLabel;
+        // A NaN condition is true, like conditionValue != 0.0
+        a.emit({0x66, 0x0F, 0x57, 0xC9}); // xorpd xmm1, xmm1
+        a.emit({0x66, 0x0F, 0x2E, 0xC1}); // ucomisd xmm0, xmm1
+        a.jp(thenLabel);
+        a.je(elseLabel);
+
+        std::vector<bool> before = assigned;
+        a.bind(thenLabel);
+        if (!this->node(node->thenBranch.get())) {
+            return false;
+        }
+        std::vector<bool> afterThen = assigned;
+        a.jmp(endLabel);
+
+        assigned = before;
+        a.bind(elseLabel);
+        if (node->elseBranch) {
+            if (!this->node(node->elseBranch.get())) {
+                return false;
+            }
+        } else {
+            a.loadBits(0, 0);
+        }
+        a.bind(endLabel);
+        for (const Assembler::Label* label : {&thenLabel, &elseLabel, &endLabel}) {
+            a.resolve(*label);
+        }
+
+        for (size_t i = 0; i < assigned.size(); ++i) {
+            assigned[i] = assigned[i] && afterThen[i];
+        }
+        return true;
+    }
+
+    // The body may run no times, so locals count as assigned inside it and
+    // after the loop only if they were before it; the loop leaves 0 in xmm0
+    bool whileStatement(WhileStatement* node) {
+        Assembler::Label loopLabel, bodyLabel, endLabel;
+        a.bind(loopLabel);
+        if (!this->node(node->condition.get())) {
+            return false;
+        }
+        a.emit({0x66, 0x0F, 0x57, 0xC9}); // xorpd xmm1, xmm1
+        a.emit({0x66, 0x0F, 0x2E, 0xC1}); // ucomisd xmm0, xmm1
+        a.jp(bodyLabel);
+        a.je(endLabel);
+
+        std::vector<bool> before = assigned;
+        a.bind(bodyLabel);
+        if (!this->node(node->body.get())) {
+            return false;
+        }
+        a.jmp(loopLabel);
+        assigned = before;
+
+        a.bind(endLabel);
+        a.loadBits(0, 0);
+        for (const Assembler::Label* label : {&loopLabel, &bodyLabel, &endLabel}) {
+            a.resolve(*label);
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+#endif // JIT_X86_64
+
+Jit::Jit(unsigned hotThreshold, NativeFunction fallback)
+    : hotThreshold(hotThreshold), fallback(fallback), context(), compiledCount(0) {}
+
+Jit::~Jit() {
+#ifdef JIT_X86_64
+    for (const auto& region : regions) {
+        munmap(region.first, region.second);
+    }
+#endif
+}
+
+bool Jit::isSupported() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t Jit::slotFor(Symbol symbol) {
+    auto [found, inserted] = slots.try_emplace(symbol, static_cast<uint32_t>(entries.size()));
+    if (inserted) {
+        entries.push_back(fallback);
+        functions.emplace_back();
+        context.entries = entries.data();
+    }
+    return found->second;
+}
+
+void Jit::invalidate() {
+    std::fill(entries.begin(), entries.end(), fallback);
+    std::fill(functions.begin(), functions.end(), FunctionState());
+}
+
+void Jit::exclude(FunctionDef* function) {
+    uint32_t slot = slotFor(function->symbol);
+    FunctionState& state = functions[slot];
+    state = FunctionState();
+    state.definition = function;
+    state.unsupported = true;
+    entries[slot] = fallback;
+}
+
+NativeFunction Jit::entryFor(FunctionDef* function) {
+    uint32_t slot = slotFor(function->symbol);
+    FunctionState& state = functions[slot];
+    if (state.definition != function) {
+        state = FunctionState();
+        state.definition = function;
+        entries[slot] = fallback;
+    }
+    if (state.entry || state.unsupported) {
+        return state.entry;
+    }
+    if (++state.calls < hotThreshold) {
+        return nullptr;
+    }
+    NativeFunction entry = compile(function);
+    // Compiling gives the function's callees slots, which may move the table
+    FunctionState& compiled = functions[slot];
+    compiled.entry = entry;
+    compiled.unsupported = entry == nullptr;
+    if (entry) {
+        entries[slot] = entry;
+    }
+    return entry;
+}
+
+NativeFunction Jit::compile(FunctionDef* function) {
+#ifdef JIT_X86_64
+    NativeCodegen codegen(function, *this);
+    if (!codegen.generate()) {
+        return nullptr;
+    }
+    const std::vector<uint8_t>& code = codegen.code();
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (code.size() + pageSize - 1) / pageSize * pageSize;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    regions.emplace_back(memory, size);
+    compiledCount++;
+    return reinterpret_cast<NativeFunction>(memory);
+#else
+    (void)function;
+    return nullptr;
+#endif
+}
@@ -1,22 +1,163 @@
-#include <iostream> // Add this for debugging
-
 #include "lexer.h"
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <charconv>
+#include <limits>
 #include <stdexcept>
 
-Lexer::Lexer(const std::string& text) : text(text), pos(0), currentChar(text[pos]) {
-    keywords = {
-        {"class", TokenType::CLASS},
-        {"function", TokenType::FUNCTION},
-        {"return", TokenType::RETURN},
-        {"if", TokenType::IF},
-        {"else", TokenType::ELSE},
-    };
+namespace {
+
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr Keyword KEYWORDS[] = {
+    {"class", TokenType::CLASS},
+    {"function", TokenType::FUNCTION},
+    {"return", TokenType::RETURN},
+    {"if", TokenType::IF},
+    {"else", TokenType::ELSE},
+    {"while", TokenType::WHILE},
+    {"for", TokenType::FOR},
+};
+
+// Perfect hash over the keyword set: length plus first character plus twice the last
+constexpr size_t KEYWORD_TABLE_SIZE = 16;
+
+constexpr size_t keywordHash(std::string_view word) {
+    return (word.size() + static_cast<unsigned char>(word.front()) + 2u * static_cast<unsigned char>(word.back())) %
+           KEYWORD_TABLE_SIZE;
+}
+
+constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> buildKeywordTable() {
+    std::array<Keyword, KEYWORD_TABLE_SIZE> table{};
+    for (const Keyword& keyword : KEYWORDS) {
+        table[keywordHash(keyword.text)] = keyword;
+    }
+    return table;
+}
+
+constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> KEYWORD_TABLE = buildKeywordTable();
+
+constexpr bool keywordHashIsPerfect() {
+    for (const Keyword& keyword : KEYWORDS) {
+        if (KEYWORD_TABLE[keywordHash(keyword.text)].text != keyword.text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(keywordHashIsPerfect(), "Keyword hash has collisions; adjust keywordHash or KEYWORD_TABLE_SIZE");
+
+// Fixed text of keywords and operators; empty for the other token types
+std::string_view spelling(TokenType type) {
+    switch (type) {
+        case TokenType::ASSIGN: return "=";
+        case TokenType::PLUS: return "+";
+        case TokenType::MINUS: return "-";
+        case TokenType::MULTIPLY: return "*";
+        case TokenType::DIVIDE: return "/";
+        case TokenType::MODULUS: return "%";
+        case TokenType::POWER: return "^";
+        case TokenType::SEMICOLON: return ";";
+        case TokenType::COMMA: return ",";
+        case TokenType::LEFT_PAREN: return "(";
+        case TokenType::RIGHT_PAREN: return ")";
+        case TokenType::LEFT_BRACE: return "{";
+        case TokenType::RIGHT_BRACE: return "}";
+        case TokenType::LEFT_BRACKET: return "[";
+        case TokenType::RIGHT_BRACKET: return "]";
+        case TokenType::CLASS: return "class";
+        case TokenType::FUNCTION: return "function";
+        case TokenType::RETURN: return "return";
+        case TokenType::IF: return "if";
+        case TokenType::ELSE: return "else";
+        case TokenType::WHILE: return "while";
+        case TokenType::FOR: return "for";
+        case TokenType::EQUALS: return "==";
+        case TokenType::NOT_EQUALS: return "!=";
+        case TokenType::LESS_THAN: return "<";
+        case TokenType::GREATER_THAN: return ">";
+        case TokenType::LESS_EQUAL: return "<=";
+        case TokenType::GREATER_EQUAL: return ">=";
+        default: return {};
+    }
+}
+
+} // namespace
+
+Lexer::Lexer(std::string_view text) : text(text), pos(0), currentChar(text.empty() ? '\0' : text[0]) {}
+
+Lexer::Lexer(std::istream& in, size_t chunkSize) : pos(0), in(&in), chunkSize(chunkSize > 0 ? chunkSize : 1) {
+    refill();
+    currentChar = text.empty() ? '\0' : text[0];
+}
+
+// Drops the text before the current token and appends the next chunk; false at the end of the stream
+bool Lexer::refill() {
+    if (!in || !*in) {
+        return false;
+    }
+    buffer.erase(0, tokenStart);
+    dropped += tokenStart;
+    pos -= tokenStart;
+    tokenStart = 0;
+    size_t kept = buffer.size();
+    buffer.resize(kept + chunkSize);
+    in->read(&buffer[kept], static_cast<std::streamsize>(chunkSize));
+    buffer.resize(kept + static_cast<size_t>(in->gcount()));
+    text = buffer;
+    return buffer.size() > kept;
+}
+
+// Token for the text from tokenStart to pos. Offsets wrap past 4 GiB of
+// streamed input, and lengths saturate; tokenText() checks both.
+Token Lexer::make(TokenType type) const {
+    size_t length = std::min<size_t>(pos - tokenStart, std::numeric_limits<uint16_t>::max());
+    return Token(type, static_cast<uint32_t>(dropped + tokenStart), static_cast<uint16_t>(length));
+}
+
+// Parses the number between tokenStart and pos once, here, so the Parser never re-reads its digits
+Token Lexer::numberToken(TokenType type) const {
+    const char* first = text.data() + tokenStart;
+    const char* last = text.data() + pos;
+    double value = 0.0;
+    auto [end, error] = std::from_chars(first, last, value);
+    if (error == std::errc::result_out_of_range) {
+        throw std::runtime_error("Number out of range: " + std::string(first, last));
+    }
+    if (error != std::errc() || end != last) {
+        throw std::runtime_error("Invalid number: " + std::string(first, last));
+    }
+    Token token = make(type);
+    token.number = value;
+    return token;
+}
+
+std::string Lexer::tokenText(const Token& token) const {
+    if (token.type == TokenType::IDENTIFIER) {
+        return std::string(symbolName(token.symbol));
+    }
+    if (token.type != TokenType::INTEGER && token.type != TokenType::FLOAT) {
+        return std::string(spelling(token.type));
+    }
+    // The number's source text, if this lexer still holds it
+    uint32_t start = token.offset - static_cast<uint32_t>(dropped);
+    if (token.length < std::numeric_limits<uint16_t>::max() && start <= text.size() &&
+        token.length <= text.size() - start) {
+        return std::string(text.substr(start, token.length));
+    }
+    char formatted[32];
+    auto [end, error] = std::to_chars(formatted, formatted + sizeof(formatted), token.number);
+    return std::string(formatted, error == std::errc() ? end : formatted);
 }
 
 void Lexer::advance() {
     pos++;
-    if (pos > text.size() - 1) {
+    if (pos >= text.size() && !refill()) {
         currentChar = '\0';  // Indicates end of input
     } else {
         currentChar = text[pos];
@@ -24,72 +165,70 @@ void Lexer::advance() {
 }
 
 void Lexer::skipWhitespace() {
-    while (currentChar != '\0' && std::isspace(currentChar)) {
+    while (currentChar != '\0' && std::isspace(static_cast<unsigned char>(currentChar))) {
+        tokenStart = pos + 1;
         advance();
     }
 }
 
 Token Lexer::integer() {
-    std::string result;
-    while (currentChar != '\0' && std::isdigit(currentChar)) {
-        result += currentChar;
+    tokenStart = pos;
+    while (currentChar != '\0' && std::isdigit(static_cast<unsigned char>(currentChar))) {
         advance();
     }
-    return Token(TokenType::INTEGER, result);
+    return numberToken(TokenType::INTEGER);
 }
 
 Token Lexer::identifier() {
-    std::string result;
-    while (currentChar != '\0' && (std::isalnum(currentChar) || currentChar == '_')) {
-        result += currentChar;
+    tokenStart = pos;
+    while (currentChar != '\0' && (std::isalnum(static_cast<unsigned char>(currentChar)) || currentChar == '_')) {
         advance();
     }
+    std::string_view result = text.substr(tokenStart, pos - tokenStart);
     // Check if the identifier is a reserved keyword
-    auto keywordIt = keywords.find(result);
-    if (keywordIt != keywords.end()) {
-        // It's a keyword
-        return Token(keywordIt->second, result);
-    } else {
-        // It's an identifier
-        return Token(TokenType::IDENTIFIER, result);
+    const Keyword& keyword = KEYWORD_TABLE[keywordHash(result)];
+    if (keyword.text == result) {
+        return make(keyword.type);
     }
+    Token token = make(TokenType::IDENTIFIER);
+    token.symbol = intern(result);
+    return token;
 }
 
 
 Token Lexer::number() {
-    std::string result;
-    while (currentChar != '\0' && std::isdigit(currentChar)) {
-        result += currentChar;
+    tokenStart = pos;
+    while (currentChar != '\0' && std::isdigit(static_cast<unsigned char>(currentChar))) {
         advance();
     }
 
     if (currentChar == '.') {
-        result += currentChar;
         advance();
 
-        while (currentChar != '\0' && std::isdigit(currentChar)) {
-            result += currentChar;
+        while (currentChar != '\0' && std::isdigit(static_cast<unsigned char>(currentChar))) {
             advance();
         }
 
-        return Token(TokenType::FLOAT, result);
+        return numberToken(TokenType::FLOAT);
     }
 
-    return Token(TokenType::INTEGER, result);
+    return numberToken(TokenType::INTEGER);
 }
 
 Token Lexer::getNextToken() {
     while (currentChar != '\0') {
-        if (std::isspace(currentChar)) {
+        tokenStart = pos;
+        unsigned char c = static_cast<unsigned char>(currentChar);
+        if (std::isspace(c)) {
             skipWhitespace();
             continue;
         }
 
-        if (std::isalpha(currentChar) || currentChar == '_') {
+        if (std::isalpha(c) || currentChar == '_') {
             return identifier();
         }
 
-        if (std::isdigit(currentChar) || currentChar == '.') {
+        if (std::isdigit(c) || currentChar == '.') {
             return number();
         }
 
@@ -99,15 +238,15 @@ Token Lexer::getNextToken() {
                 advance();
                 if (currentChar == '=') {
                     advance();
-                    return Token(TokenType::EQUALS, "==");
+                    return make(TokenType::EQUALS);
                 } else {
-                    return Token(TokenType::ASSIGN, "=");
+                    return make(TokenType::ASSIGN);
                 }
             case '!':
                 advance();
                 if (currentChar == '=') {
                     advance();
-                    return Token(TokenType::NOT_EQUALS, "!=");
+                    return make(TokenType::NOT_EQUALS);
                 } else {
                     throw std::runtime_error("Invalid token '!' without '='");
                 }
@@ -115,54 +254,60 @@ Token Lexer::getNextToken() {
                 advance();
                 if(currentChar == '=') {
                     advance();
-                    return Token(TokenType::LESS_EQUAL, "<=");
+                    return make(TokenType::LESS_EQUAL);
                 } else {
-                    return Token(TokenType::LESS_THAN, "<");
+                    return make(TokenType::LESS_THAN);
                 }
             case '>':
                 advance();
                 if (currentChar == '=') {
                     advance();
-                    return Token(TokenType::GREATER_EQUAL, ">=");
+                    return make(TokenType::GREATER_EQUAL);
                 } else {
-                    return Token(TokenType::GREATER_THAN, ">");
+                    return make(TokenType::GREATER_THAN);
                 }
             case '+':
                 advance();
-                return Token(TokenType::PLUS, "+");
+                return make(TokenType::PLUS);
             case '-':
                 advance();
-                return Token(TokenType::MINUS, "-");
+                return make(TokenType::MINUS);
             case '*':
                 advance();
-                return Token(TokenType::MULTIPLY, "*");
+                return make(TokenType::MULTIPLY);
             case '/':
                 advance();
-                return Token(TokenType::DIVIDE, "/");
+                return make(TokenType::DIVIDE);
             case ';':
                 advance();
-                return Token(TokenType::SEMICOLON, ";");
+                return make(TokenType::SEMICOLON);
             case ',':
                 advance();
-                return Token(TokenType::COMMA, ",");
+                return make(TokenType::COMMA);
             case '(':
                 advance();
-                return Token(TokenType::LEFT_PAREN, "(");
+                return make(TokenType::LEFT_PAREN);
             case ')':
                 advance();
-                return Token(TokenType::RIGHT_PAREN, ")");
+                return make(TokenType::RIGHT_PAREN);
             case '{':
                 advance();
-                return Token(TokenType::LEFT_BRACE, "{");
+                return make(TokenType::LEFT_BRACE);
             case '}':
                 advance();
-                return Token(TokenType::RIGHT_BRACE, "}");
+                return make(TokenType::RIGHT_BRACE);
+            case '[':
+                advance();
+                return make(TokenType::LEFT_BRACKET);
+            case ']':
+                advance();
+                return make(TokenType::RIGHT_BRACKET);
             case '^':
                 advance();
-                return Token(TokenType::POWER, "^");
+                return make(TokenType::POWER);
             case '%':
                 advance();
-                return Token(TokenType::MODULUS, "%");
+                return make(TokenType::MODULUS);
             default:
                 throw std::runtime_error("Syntax error: Invalid factor");
         }
@@ -170,6 +315,7 @@ Token Lexer::getNextToken() {
     }
 
     // Return END_OF_FILE token when no more characters are left to process
-    return Token(TokenType::END_OF_FILE, "");
+    tokenStart = pos;
+    return make(TokenType::END_OF_FILE);
 }
 
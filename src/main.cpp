@@ -1,38 +1,231 @@
-#include <iostream>
+#include <cstdlib>
 #include <fstream>
-#include <sstream>
+#include <iostream>
+#include <optional>
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/interpreter.h"
+#include "../include/vm.h"
+#include "../include/closurecompiler.h"
+#include "../include/optimizer.h"
+#include "../include/sourcefile.h"
+#include "../include/batchrunner.h"
+#include "../include/programcache.h"
+#include "../include/repl.h"
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--vm | --closures | --memoize | --jit] [--stream | --cache] [-O0]"
+              << " [--profile] [--profile-folded file] [file]" << std::endl
+              << "       " << program << " --repl [--memoize | --jit] [-O0] [--profile] [--profile-folded file]"
+              << std::endl
+              << "       " << program << " --batch <manifest|directory> [--jobs N] [--results file]" << std::endl
+              << "  --vm       run on the bytecode virtual machine instead of the tree-walking interpreter" << std::endl
+              << "  --closures run on the closure compiler instead of the tree-walking interpreter" << std::endl
+              << "  --memoize  cache results of pure functions and report cache statistics on exit" << std::endl
+              << "  --jit      compile hot functions to native code" << std::endl
+              << "  --stream   run each top-level statement as soon as it is read, in bounded memory" << std::endl
+              << "  --cache    reuse the parsed program saved in <file>.mcache, rebuilding it when stale" << std::endl
+              << "  --repl     read snippets from standard input and run each in one long-lived session," << std::endl
+              << "             printing its value; definitions stay usable in later snippets" << std::endl
+              << "  --profile  report calls and time per function and the most executed nodes on exit" << std::endl
+              << "  --profile-folded" << std::endl
+              << "             write the profile as folded stacks (flamegraph.pl input) to file" << std::endl
+              << "  -O0        skip constant folding and algebraic simplification" << std::endl
+              << "  --batch    run every listed script on a worker pool and write one tab-separated" << std::endl
+              << "             line per script (script, final value, error) in listing order" << std::endl
+              << "  --jobs     number of workers; defaults to one per hardware thread" << std::endl
+              << "  --results  file to write batch results to instead of standard output" << std::endl;
+}
 
 int main(int argc, char* argv[]) {
-    std::string input;
+    bool useVM = false;
+    bool useClosures = false;
+    bool optimize = true;
+    bool memoize = false;
+    bool useJit = false;
+    bool stream = false;
+    bool cache = false;
+    bool repl = false;
+    bool profile = false;
+    const char* foldedPath = nullptr;
+    const char* path = nullptr;
+    const char* batch = nullptr;
+    const char* resultsPath = nullptr;
+    unsigned jobs = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--vm") {
+            useVM = true;
+        } else if (arg == "--closures") {
+            useClosures = true;
+        } else if (arg == "--memoize") {
+            memoize = true;
+        } else if (arg == "--jit") {
+            useJit = true;
+        } else if (arg == "--stream") {
+            stream = true;
+        } else if (arg == "--cache") {
+            cache = true;
+        } else if (arg == "--repl") {
+            repl = true;
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--profile-folded" && i + 1 < argc) {
+            profile = true;
+            foldedPath = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--results" && i + 1 < argc) {
+            resultsPath = argv[++i];
+        } else if (arg == "-O0") {
+            optimize = false;
+        } else if (!path && (arg.empty() || arg[0] != '-')) {
+            path = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (useVM + useClosures + memoize + useJit > 1 ||
+        (batch && (useVM || useClosures || memoize || useJit || stream || cache || profile || path || repl)) ||
+        (repl && (useVM || useClosures || stream || cache || path)) ||
+        (profile && (useVM || useClosures)) ||
+        (cache && (stream || !path))) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (batch) {
+        // Failed scripts are reported in the results; only a batch that cannot run fails
+        try {
+            BatchRunner runner(jobs);
+            std::vector<BatchResult> results = runner.runFiles(BatchRunner::listScripts(batch));
+            if (resultsPath) {
+                std::ofstream out(resultsPath);
+                if (!out.is_open()) {
+                    std::cerr << "Error: Could not open file " << resultsPath << std::endl;
+                    return 1;
+                }
+                BatchRunner::writeResults(out, results);
+            } else {
+                BatchRunner::writeResults(std::cout, results);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    if (argc > 1) {
-        // Read input from the file specified as the first command-line argument
-        std::ifstream file(argv[1]);
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open file " << argv[1] << std::endl;
+    std::optional<SourceFile> source;
+    std::ifstream file;
+    if (stream) {
+        // Streamed input is read chunk by chunk as statements are parsed
+        if (path) {
+            file.open(path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Error: Could not open file " << path << std::endl;
+                return 1;
+            }
+        }
+    } else if (path) {
+        // Map the file specified on the command line
+        try {
+            source.emplace(SourceFile::map(path));
+        } catch (const std::exception&) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
             return 1;
         }
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        input = buffer.str();
-    } else {
+    } else if (!repl) {
         // Read input from standard input
         std::cout << "Enter code (end with EOF/Ctrl+D):" << std::endl;
-        std::stringstream buffer;
-        buffer << std::cin.rdbuf();
-        input = buffer.str();
+        source.emplace(SourceFile::read(std::cin));
     }
 
     try {
-        Lexer lexer(input);
-        Parser parser(lexer);
-        ASTPtr tree = parser.parse();
-
+        Optimizer optimizer;
+        VirtualMachine vm;
+        ClosureCompiler closures;
         Interpreter interpreter;
-        interpreter.interpret(tree);
+        if (memoize) {
+            interpreter.enableMemoization();
+        }
+        if (useJit) {
+            interpreter.enableJit();
+        }
+        if (profile) {
+            interpreter.enableProfiling();
+        }
+
+        if (repl) {
+            Repl session(interpreter, optimize);
+            session.loop(std::cin, std::cout, std::cerr);
+        } else if (stream) {
+            // Each statement's tree is freed once it has run
+            Lexer lexer(path ? static_cast<std::istream&>(file) : std::cin);
+            Parser parser(lexer);
+            while (ASTPtr statement = parser.parseStatement()) {
+                if (optimize) {
+                    optimizer.optimize(statement);
+                }
+                // A top-level return ends the program, as it would the whole tree
+                bool returned;
+                if (useVM) {
+                    vm.interpret(statement);
+                    returned = vm.returned();
+                } else if (useClosures) {
+                    closures.interpret(statement);
+                    returned = closures.returned();
+                } else {
+                    interpreter.interpretStatement(std::move(statement));
+                    returned = interpreter.returned();
+                }
+                if (returned) {
+                    break;
+                }
+            }
+        } else {
+            ASTPtr tree;
+            if (cache) {
+                tree = ProgramCache::load(path, source->text(), optimize);
+            } else {
+                Lexer lexer(source->text());
+                Parser parser(lexer);
+                tree = parser.parse();
+                if (optimize) {
+                    optimizer.optimize(tree);
+                }
+            }
+            if (useVM) {
+                vm.interpret(tree);
+            } else if (useClosures) {
+                closures.interpret(tree);
+            } else {
+                interpreter.interpret(tree);
+            }
+        }
+
+        if (memoize) {
+            MemoStats stats = interpreter.getMemoStats();
+            std::cerr << "memo: " << stats.hits << " hits, " << stats.misses << " misses ("
+                      << stats.hitRate() * 100.0 << "% hit rate), " << stats.entries << " entries, "
+                      << stats.bytes << " bytes" << std::endl;
+        }
+        if (profile) {
+            interpreter.getProfiler()->writeReport(std::cerr);
+        }
+        if (foldedPath) {
+            std::ofstream folded(foldedPath);
+            if (!folded.is_open()) {
+                std::cerr << "Error: Could not open file " << foldedPath << std::endl;
+                return 1;
+            }
+            interpreter.getProfiler()->writeFoldedStacks(folded);
+        }
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << std::endl;
         return 1;
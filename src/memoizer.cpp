@@ -0,0 +1,170 @@
+#include "memoizer.h"
+
+Memoizer::Memoizer(size_t maxEntriesPerFunction) : maxEntries(maxEntriesPerFunction) {}
+
+Memoizer::FunctionMemo& Memoizer::memoFor(FunctionDef* function) {
+    FunctionMemo& memo = memos[function->symbol];
+    if (memo.definition != function) {
+        for (const auto& entry : memo.results) {
+            stats.bytes -= entryBytes(entry.first);
+        }
+        stats.entries -= memo.results.size();
+        memo = FunctionMemo();
+        memo.definition = function;
+    }
+    return memo;
+}
+
+bool Memoizer::isPure(FunctionDef* function, const FunctionTable& functions) {
+    FunctionMemo& memo = memoFor(function);
+    switch (memo.purity) {
+        case Purity::PURE:
+        case Purity::IN_PROGRESS:
+            return true;
+        case Purity::IMPURE:
+            return false;
+        case Purity::UNKNOWN:
+            break;
+    }
+    memo.purity = Purity::IN_PROGRESS;
+    analysisDepth++;
+    bool pure = bodyIsPure(function->body.get(), functions);
+    analysisDepth--;
+    if (!pure) {
+        // Assuming callers still in progress pure can only hide impurity, never add it
+        memo.purity = Purity::IMPURE;
+    } else if (analysisDepth > 0) {
+        // Pure only if the functions still being analysed turn out pure as well;
+        // it stays assumed pure until the outermost analysis settles
+        provisional.push_back(function->symbol);
+    } else {
+        memo.purity = Purity::PURE;
+    }
+    if (analysisDepth == 0) {
+        // Every function on the analysis stack above an impure one is impure, so
+        // a pure outermost function confirms all provisional verdicts; otherwise
+        // they are analysed again when next asked
+        for (Symbol symbol : provisional) {
+            if (memos[symbol].purity == Purity::IN_PROGRESS) {
+                memos[symbol].purity = pure ? Purity::PURE : Purity::UNKNOWN;
+            }
+        }
+        provisional.clear();
+    }
+    return pure;
+}
+
+bool Memoizer::bodyIsPure(AST* node, const FunctionTable& functions) {
+    if (!node) {
+        return true;
+    }
+    switch (node->type) {
+        case NodeType::BIN_OP: {
+            auto binOp = static_cast<BinOp*>(node);
+            return bodyIsPure(binOp->left.get(), functions) && bodyIsPure(binOp->right.get(), functions);
+        }
+        case NodeType::UNARY_OP:
+            return bodyIsPure(static_cast<UnaryOp*>(node)->expr.get(), functions);
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                if (!bodyIsPure(child.get(), functions)) {
+                    return false;
+                }
+            }
+            return true;
+        case NodeType::ASSIGN:
+            // Assignments inside a function body always target its own frame
+            return bodyIsPure(static_cast<Assign*>(node)->right.get(), functions);
+        case NodeType::VAR:
+            return static_cast<Var*>(node)->depth == SymbolTable::LOCAL_DEPTH;
+        case NodeType::FUNCTION_CALL: {
+            auto call = static_cast<FunctionCall*>(node);
+            FunctionDef* callee = findDefinition(functions, call->symbol);
+            // Array builtins only read their arguments
+            if (callee ? !isPure(callee, functions) : findArrayBuiltin(call->symbol) == ArrayBuiltin::NONE) {
+                return false;
+            }
+            for (auto& arg : call->args) {
+                if (!bodyIsPure(arg.get(), functions)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case NodeType::RETURN:
+            return bodyIsPure(static_cast<Return*>(node)->expr.get(), functions);
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            return bodyIsPure(ifNode->condition.get(), functions) &&
+                   bodyIsPure(ifNode->thenBranch.get(), functions) &&
+                   bodyIsPure(ifNode->elseBranch.get(), functions);
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto whileNode = static_cast<WhileStatement*>(node);
+            return bodyIsPure(whileNode->condition.get(), functions) &&
+                   bodyIsPure(whileNode->body.get(), functions);
+        }
+        case NodeType::ARRAY_LITERAL:
+            for (auto& element : static_cast<ArrayLiteral*>(node)->elements) {
+                if (!bodyIsPure(element.get(), functions)) {
+                    return false;
+                }
+            }
+            return true;
+        case NodeType::INDEX: {
+            auto index = static_cast<Index*>(node);
+            return bodyIsPure(index->array.get(), functions) && bodyIsPure(index->index.get(), functions);
+        }
+        case NodeType::NUM:
+        case NodeType::NO_OP:
+            return true;
+        case NodeType::FUNCTION_DEF:
+        case NodeType::CLASS_DEF:
+            return false;
+    }
+    return false;
+}
+
+const double* Memoizer::lookup(FunctionDef* function, const std::vector<double>& args) {
+    FunctionMemo& memo = memoFor(function);
+    auto it = memo.results.find(makeKey(args));
+    if (it == memo.results.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+    stats.hits++;
+    return &it->second;
+}
+
+void Memoizer::store(FunctionDef* function, const std::vector<double>& args, double result) {
+    FunctionMemo& memo = memoFor(function);
+    if (memo.results.size() >= maxEntries) {
+        // Bounded: start over rather than track recency on every hit
+        for (const auto& entry : memo.results) {
+            stats.bytes -= entryBytes(entry.first);
+        }
+        stats.entries -= memo.results.size();
+        memo.results.clear();
+    }
+    auto inserted = memo.results.emplace(makeKey(args), result);
+    if (inserted.second) {
+        stats.entries++;
+        stats.bytes += entryBytes(inserted.first->first);
+    }
+}
+
+void Memoizer::invalidate() {
+    memos.clear();
+    stats.entries = 0;
+    stats.bytes = 0;
+}
+
+std::string Memoizer::makeKey(const std::vector<double>& args) {
+    return std::string(reinterpret_cast<const char*>(args.data()), args.size() * sizeof(double));
+}
+
+// Approximate heap cost of one cached result: hash node, key and bucket pointer
+size_t Memoizer::entryBytes(const std::string& key) {
+    size_t heapKey = key.size() > 15 ? key.size() + 1 : 0;
+    return sizeof(std::pair<const std::string, double>) + 2 * sizeof(void*) + heapKey;
+}
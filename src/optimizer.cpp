@@ -0,0 +1,210 @@
+#include "optimizer.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+bool isNum(const ASTPtr& node) {
+    return node && node->type == NodeType::NUM;
+}
+
+bool isNumWithBits(const ASTPtr& node, double value) {
+    if (!isNum(node)) {
+        return false;
+    }
+    double actual = static_cast<Num*>(node.get())->value;
+    return std::memcmp(&actual, &value, sizeof(double)) == 0;
+}
+
+double numValue(const ASTPtr& node) {
+    return static_cast<Num*>(node.get())->value;
+}
+
+} // namespace
+
+Optimizer::Optimizer() : arena(nullptr), foldedCount(0) {}
+
+void Optimizer::optimize(ASTPtr& tree) {
+    if (!tree) {
+        return;
+    }
+    arena = tree.get_deleter().ownedArena;
+    if (arena) {
+        // The root link owns the arena, so the root itself is never replaced
+        optimizeChildren(tree.get());
+    } else {
+        optimizeNode(tree);
+    }
+    arena = nullptr;
+}
+
+void Optimizer::optimizeChildren(AST* node) {
+    switch (node->type) {
+        case NodeType::BIN_OP: {
+            auto binOp = static_cast<BinOp*>(node);
+            optimizeNode(binOp->left);
+            optimizeNode(binOp->right);
+            break;
+        }
+        case NodeType::UNARY_OP:
+            optimizeNode(static_cast<UnaryOp*>(node)->expr);
+            break;
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                optimizeNode(child);
+            }
+            break;
+        case NodeType::ASSIGN:
+            optimizeNode(static_cast<Assign*>(node)->right);
+            break;
+        case NodeType::FUNCTION_DEF:
+            optimizeNode(static_cast<FunctionDef*>(node)->body);
+            break;
+        case NodeType::FUNCTION_CALL:
+            for (auto& arg : static_cast<FunctionCall*>(node)->args) {
+                optimizeNode(arg);
+            }
+            break;
+        case NodeType::CLASS_DEF:
+            for (auto& method : static_cast<ClassDef*>(node)->methods) {
+                optimizeNode(method);
+            }
+            break;
+        case NodeType::RETURN:
+            optimizeNode(static_cast<Return*>(node)->expr);
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            optimizeNode(ifNode->condition);
+            optimizeNode(ifNode->thenBranch);
+            optimizeNode(ifNode->elseBranch);
+            break;
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto whileNode = static_cast<WhileStatement*>(node);
+            optimizeNode(whileNode->condition);
+            optimizeNode(whileNode->body);
+            break;
+        }
+        case NodeType::ARRAY_LITERAL:
+            for (auto& element : static_cast<ArrayLiteral*>(node)->elements) {
+                optimizeNode(element);
+            }
+            break;
+        case NodeType::INDEX: {
+            auto index = static_cast<Index*>(node);
+            optimizeNode(index->array);
+            optimizeNode(index->index);
+            break;
+        }
+        case NodeType::NUM:
+        case NodeType::VAR:
+        case NodeType::NO_OP:
+            break;
+    }
+}
+
+void Optimizer::optimizeNode(ASTPtr& node) {
+    if (!node) {
+        return;
+    }
+    optimizeChildren(node.get());
+    if (node->type == NodeType::BIN_OP) {
+        foldBinOp(node);
+    } else if (node->type == NodeType::UNARY_OP) {
+        foldUnaryOp(node);
+    }
+}
+
+void Optimizer::foldBinOp(ASTPtr& node) {
+    auto binOp = static_cast<BinOp*>(node.get());
+    ASTPtr& left = binOp->left;
+    ASTPtr& right = binOp->right;
+
+    if (isNum(left) && isNum(right)) {
+        double l = numValue(left);
+        double r = numValue(right);
+        double result;
+        switch (binOp->op.type) {
+            case TokenType::PLUS: result = l + r; break;
+            case TokenType::MINUS: result = l - r; break;
+            case TokenType::MULTIPLY: result = l * r; break;
+            case TokenType::DIVIDE:
+                if (r == 0) {
+                    return; // Left for the interpreter to report at run time
+                }
+                result = l / r;
+                break;
+            case TokenType::MODULUS: result = std::fmod(l, r); break;
+            case TokenType::POWER: result = std::pow(l, r); break;
+            case TokenType::EQUALS: result = l == r ? 1.0 : 0.0; break;
+            case TokenType::NOT_EQUALS: result = l != r ? 1.0 : 0.0; break;
+            case TokenType::LESS_THAN: result = l < r ? 1.0 : 0.0; break;
+            case TokenType::GREATER_THAN: result = l > r ? 1.0 : 0.0; break;
+            case TokenType::LESS_EQUAL: result = l <= r ? 1.0 : 0.0; break;
+            case TokenType::GREATER_EQUAL: result = l >= r ? 1.0 : 0.0; break;
+            default:
+                return;
+        }
+        replace(node, makeNum(result));
+        return;
+    }
+
+    switch (binOp->op.type) {
+        case TokenType::MULTIPLY:
+            if (isNumWithBits(right, 1.0)) {
+                replace(node, std::move(left));
+            } else if (isNumWithBits(left, 1.0)) {
+                replace(node, std::move(right));
+            }
+            break;
+        case TokenType::DIVIDE:
+            if (isNumWithBits(right, 1.0)) {
+                replace(node, std::move(left));
+            }
+            break;
+        case TokenType::MINUS:
+            if (isNumWithBits(right, 0.0)) {
+                replace(node, std::move(left));
+            }
+            break;
+        case TokenType::PLUS:
+            if (isNumWithBits(right, -0.0)) {
+                replace(node, std::move(left));
+            } else if (isNumWithBits(left, -0.0)) {
+                replace(node, std::move(right));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Optimizer::foldUnaryOp(ASTPtr& node) {
+    auto unaryOp = static_cast<UnaryOp*>(node.get());
+    ASTPtr& operand = unaryOp->expr;
+
+    if (unaryOp->op.type == TokenType::PLUS) {
+        replace(node, std::move(operand));
+    } else if (unaryOp->op.type == TokenType::MINUS) {
+        if (isNum(operand)) {
+            replace(node, makeNum(-numValue(operand)));
+        } else if (operand->type == NodeType::UNARY_OP &&
+                   static_cast<UnaryOp*>(operand.get())->op.type == TokenType::MINUS) {
+            replace(node, std::move(static_cast<UnaryOp*>(operand.get())->expr));
+        }
+    }
+}
+
+ASTPtr Optimizer::makeNum(double value) {
+    if (arena) {
+        return arena->makePtr<Num>(value);
+    }
+    return std::make_unique<Num>(value);
+}
+
+void Optimizer::replace(ASTPtr& node, ASTPtr replacement) {
+    // The replacement may be a child of node, so it is detached before node is released
+    node = std::move(replacement);
+    ++foldedCount;
+}
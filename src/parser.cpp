@@ -8,7 +8,7 @@ void Parser::eat(TokenType type) {
         currentToken = nextToken;
         nextToken = lexer.getNextToken();
     } else {
-        throw std::runtime_error("Syntax error: Unexpected token '" + currentToken.value + "'");
+        throw std::runtime_error("Syntax error: Unexpected token '" + lexer.tokenText(currentToken) + "'");
     }
 }
 
@@ -28,32 +28,56 @@ ASTPtr Parser::factor() {
                 }
             }
             eat(TokenType::RIGHT_PAREN);
-            return std::make_unique<FunctionCall>(token.value, std::move(args));
+            return indexes(make<FunctionCall>(token.symbol, std::move(args)));
         } else {
             // Variable
-            return std::make_unique<Var>(token);
+            return indexes(make<Var>(token));
         }
     } else {
         if (token.type == TokenType::PLUS) {
             eat(TokenType::PLUS);
-            return std::make_unique<UnaryOp>(token, factor());
+            return make<UnaryOp>(token, factor());
         } else if (token.type == TokenType::MINUS) {
             eat(TokenType::MINUS);
-            return std::make_unique<UnaryOp>(token, factor());
+            return make<UnaryOp>(token, factor());
         } else if (token.type == TokenType::INTEGER || token.type == TokenType::FLOAT) {
             eat(token.type);
-            return std::make_unique<Num>(token);
+            return make<Num>(token);
         } else if (token.type == TokenType::LEFT_PAREN) {
             eat(TokenType::LEFT_PAREN);
             ASTPtr node = expr();
             eat(TokenType::RIGHT_PAREN);
-            return node;
+            return indexes(std::move(node));
+        } else if (token.type == TokenType::LEFT_BRACKET) {
+            // Array literal
+            eat(TokenType::LEFT_BRACKET);
+            std::vector<ASTPtr> elements;
+            if (currentToken.type != TokenType::RIGHT_BRACKET) {
+                elements.push_back(expr());
+                while (currentToken.type == TokenType::COMMA) {
+                    eat(TokenType::COMMA);
+                    elements.push_back(expr());
+                }
+            }
+            eat(TokenType::RIGHT_BRACKET);
+            return indexes(make<ArrayLiteral>(std::move(elements)));
         } else {
             throw std::runtime_error("Syntax error: Invalid factor");
         }
     }
 }
 
+// Any [index] suffixes of a factor, applied left to right
+ASTPtr Parser::indexes(ASTPtr node) {
+    while (currentToken.type == TokenType::LEFT_BRACKET) {
+        eat(TokenType::LEFT_BRACKET);
+        ASTPtr index = expr();
+        eat(TokenType::RIGHT_BRACKET);
+        node = make<Index>(std::move(node), std::move(index));
+    }
+    return node;
+}
+
 ASTPtr Parser::term() {
     ASTPtr node = factor();
     while (currentToken.type == TokenType::MULTIPLY ||
@@ -70,7 +94,7 @@ ASTPtr Parser::term() {
         } else if (token.type == TokenType::POWER) {
             eat(TokenType::POWER);
         }
-        node = std::make_unique<BinOp>(std::move(node), token, factor());
+        node = make<BinOp>(std::move(node), token, factor());
     }
     return node;
 }
@@ -85,7 +109,7 @@ ASTPtr Parser::expr() {
         } else if (token.type == TokenType::MINUS) {
             eat(TokenType::MINUS);
         }
-        node = std::make_unique<BinOp>(std::move(node), token, term());
+        node = make<BinOp>(std::move(node), token, term());
     }
     return node;
 }
@@ -93,7 +117,7 @@ ASTPtr Parser::expr() {
 ASTPtr Parser::variable() {
     Token token = currentToken;
     eat(TokenType::IDENTIFIER);
-    return std::make_unique<Var>(token);
+    return make<Var>(token);
 }
 
 ASTPtr Parser::assignmentStatement() {
@@ -101,44 +125,65 @@ ASTPtr Parser::assignmentStatement() {
     Token token = currentToken;
     eat(TokenType::ASSIGN);
     ASTPtr right = expr();
-    return std::make_unique<Assign>(std::move(left), token, std::move(right));
+    return make<Assign>(std::move(left), token, std::move(right));
 }
 
 ASTPtr Parser::statement() {
-    ASTPtr node;
     if (currentToken.type == TokenType::IF) {
         return ifStatement();
-    }  else if (currentToken.type == TokenType::CLASS) {
+    } else if (currentToken.type == TokenType::WHILE) {
+        return whileStatement();
+    } else if (currentToken.type == TokenType::FOR) {
+        return forStatement();
+    } else if (currentToken.type == TokenType::CLASS) {
         return classDeclaration();
     } else if (currentToken.type == TokenType::FUNCTION) {
         return functionDeclaration();
     } else if (currentToken.type == TokenType::RETURN) {
         return returnStatement();
-    } else if (currentToken.type == TokenType::IDENTIFIER && nextToken.type == TokenType::ASSIGN) {
-        node = assignmentStatement();
-    } else {
-        node = expr();
     }
+    ASTPtr node = simpleStatement();
     if (currentToken.type == TokenType::SEMICOLON) {
         eat(TokenType::SEMICOLON);
     }
     return node;
 }
 
+// An assignment or an expression, without its semicolon
+ASTPtr Parser::simpleStatement() {
+    if (currentToken.type == TokenType::IDENTIFIER && nextToken.type == TokenType::ASSIGN) {
+        return assignmentStatement();
+    }
+    return expr();
+}
+
 ASTPtr Parser::program() {
-    auto compound = std::make_unique<Compound>();
+    Compound* compound = arena->make<Compound>();
     while (currentToken.type != TokenType::END_OF_FILE) {
         compound->addChild(statement());
     }
-    return compound;
+    return ASTPtr(compound, ASTDeleter::borrowing());
 }
 
 ASTPtr Parser::parse() {
+    auto treeArena = std::make_unique<ASTArena>();
+    arena = treeArena.get();
     ASTPtr node = program();
     if (currentToken.type != TokenType::END_OF_FILE) {
         throw std::runtime_error("Syntax error: Unexpected token at the end of input");
     }
-    return node;
+    // The root link takes ownership of the arena and with it the whole tree
+    return ASTPtr(node.release(), ASTDeleter::owning(treeArena.release()));
+}
+
+ASTPtr Parser::parseStatement() {
+    if (currentToken.type == TokenType::END_OF_FILE) {
+        return nullptr;
+    }
+    auto statementArena = std::make_unique<ASTArena>();
+    arena = statementArena.get();
+    ASTPtr node = statement();
+    return ASTPtr(node.release(), ASTDeleter::owning(statementArena.release()));
 }
 
 ASTPtr Parser::classDeclaration() {
@@ -155,7 +200,7 @@ ASTPtr Parser::classDeclaration() {
 
     eat(TokenType::RIGHT_BRACE);
 
-    return std::make_unique<ClassDef>(className.value, std::move(methods));
+    return make<ClassDef>(className.symbol, std::move(methods));
 }
 
 ASTPtr Parser::functionDeclaration() {
@@ -164,14 +209,14 @@ ASTPtr Parser::functionDeclaration() {
     eat(TokenType::IDENTIFIER);
     eat(TokenType::LEFT_PAREN);
 
-    std::vector<std::string> params;
+    std::vector<Symbol> params;
     if (currentToken.type != TokenType::RIGHT_PAREN) {
-        params.push_back(currentToken.value);
+        params.push_back(currentToken.symbol);
         eat(TokenType::IDENTIFIER);
 
         while (currentToken.type == TokenType::COMMA) {
             eat(TokenType::COMMA);
-            params.push_back(currentToken.value);
+            params.push_back(currentToken.symbol);
             eat(TokenType::IDENTIFIER);
         }
     }
@@ -179,19 +224,19 @@ ASTPtr Parser::functionDeclaration() {
 
     ASTPtr body = block();
 
-    return std::make_unique<FunctionDef>(funcName.value, params, std::move(body));
+    return make<FunctionDef>(funcName.symbol, std::move(params), std::move(body));
 }
 
 ASTPtr Parser::block() {
     eat(TokenType::LEFT_BRACE);
 
-    auto compound = std::make_unique<Compound>();
+    Compound* compound = arena->make<Compound>();
     while (currentToken.type != TokenType::RIGHT_BRACE) {
         compound->addChild(statement());
     }
 
     eat(TokenType::RIGHT_BRACE);
-    return compound;
+    return ASTPtr(compound, ASTDeleter::borrowing());
 }
 
 ASTPtr Parser::returnStatement() {
@@ -200,7 +245,7 @@ ASTPtr Parser::returnStatement() {
     if (currentToken.type == TokenType::SEMICOLON) {
         eat(TokenType::SEMICOLON);
     }
-    return std::make_unique<Return>(std::move(node));
+    return make<Return>(std::move(node));
 }
 
 ASTPtr Parser::condition() {
@@ -211,7 +256,7 @@ ASTPtr Parser::condition() {
         op.type == TokenType::LESS_EQUAL || op.type == TokenType::GREATER_EQUAL) {
         eat(op.type);
         ASTPtr right = expr();
-        return std::make_unique<BinOp>(std::move(left), op, std::move(right));
+        return make<BinOp>(std::move(left), op, std::move(right));
     } else {
         throw std::runtime_error("Invalid comparison operator");
     }
@@ -230,5 +275,41 @@ ASTPtr Parser::ifStatement() {
         elseBranch = block();
     }
 
-    return std::make_unique<IfStatement>(std::move(conditionNode), std::move(thenBranch), std::move(elseBranch));
+    return make<IfStatement>(std::move(conditionNode), std::move(thenBranch), std::move(elseBranch));
+}
+
+ASTPtr Parser::whileStatement() {
+    eat(TokenType::WHILE);
+    eat(TokenType::LEFT_PAREN);
+    ASTPtr conditionNode = condition();
+    eat(TokenType::RIGHT_PAREN);
+    ASTPtr body = block();
+    return make<WhileStatement>(std::move(conditionNode), std::move(body));
+}
+
+// for (init; condition; update) { body } is lowered to
+// init; while (condition) { body update }, so backends only know while loops.
+// The init and update clauses may be left empty.
+ASTPtr Parser::forStatement() {
+    eat(TokenType::FOR);
+    eat(TokenType::LEFT_PAREN);
+    ASTPtr init = currentToken.type == TokenType::SEMICOLON ? nullptr : simpleStatement();
+    eat(TokenType::SEMICOLON);
+    ASTPtr conditionNode = condition();
+    eat(TokenType::SEMICOLON);
+    ASTPtr update = currentToken.type == TokenType::RIGHT_PAREN ? nullptr : simpleStatement();
+    eat(TokenType::RIGHT_PAREN);
+    ASTPtr body = block();
+
+    if (update) {
+        static_cast<Compound*>(body.get())->addChild(std::move(update));
+    }
+    ASTPtr loop = make<WhileStatement>(std::move(conditionNode), std::move(body));
+    if (!init) {
+        return loop;
+    }
+    Compound* compound = arena->make<Compound>();
+    compound->addChild(std::move(init));
+    compound->addChild(std::move(loop));
+    return ASTPtr(compound, ASTDeleter::borrowing());
 }
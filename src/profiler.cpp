@@ -0,0 +1,315 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+namespace {
+
+const char* operatorText(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS: return "+";
+        case TokenType::MINUS: return "-";
+        case TokenType::MULTIPLY: return "*";
+        case TokenType::DIVIDE: return "/";
+        case TokenType::MODULUS: return "%";
+        case TokenType::POWER: return "^";
+        case TokenType::EQUALS: return "==";
+        case TokenType::NOT_EQUALS: return "!=";
+        case TokenType::LESS_THAN: return "<";
+        case TokenType::GREATER_THAN: return ">";
+        case TokenType::LESS_EQUAL: return "<=";
+        case TokenType::GREATER_EQUAL: return ">=";
+        default: return "?";
+    }
+}
+
+} // namespace
+
+void Profiler::enter(Symbol function) {
+    int parent = frames.empty() ? -1 : frames.back().stack;
+    int stack;
+    if (parent < 0) {
+        // Stacks without a caller are found among the roots
+        auto root = std::find_if(stacks.begin(), stacks.end(),
+                                 [function](const Stack& s) { return s.parent < 0 && s.function == function; });
+        stack = static_cast<int>(root - stacks.begin());
+        if (root == stacks.end()) {
+            stacks.emplace_back(function, -1);
+        }
+    } else {
+        auto found = stacks[parent].children.find(function);
+        if (found != stacks[parent].children.end()) {
+            stack = found->second;
+        } else {
+            stack = static_cast<int>(stacks.size());
+            stacks[parent].children.emplace(function, stack);
+            stacks.emplace_back(function, parent);
+        }
+    }
+
+    Totals& functionTotals = totals[function];
+    functionTotals.calls++;
+    functionTotals.active++;
+    frames.push_back({function, stack, Clock::now(), 0.0});
+}
+
+void Profiler::leave() {
+    Frame frame = frames.back();
+    frames.pop_back();
+    double elapsed = std::chrono::duration<double>(Clock::now() - frame.start).count();
+    double exclusive = std::max(0.0, elapsed - frame.childSeconds);
+
+    stacks[frame.stack].exclusiveSeconds += exclusive;
+    Totals& functionTotals = totals[frame.function];
+    functionTotals.exclusiveSeconds += exclusive;
+    if (--functionTotals.active == 0) {
+        functionTotals.inclusiveSeconds += elapsed;
+    }
+    if (!frames.empty()) {
+        frames.back().childSeconds += elapsed;
+    }
+}
+
+void Profiler::countNode(const AST* node) {
+    auto [entry, inserted] = nodes.try_emplace(node);
+    if (inserted) {
+        // Described now, since trees may be freed before the report
+        entry->second.description = describe(node);
+        entry->second.function = functionName(frames.empty() ? NO_SYMBOL : frames.back().function);
+    }
+    entry->second.count++;
+}
+
+void Profiler::releaseTree(const AST* tree) {
+    if (!nodes.empty()) {
+        releaseNode(tree);
+    }
+}
+
+void Profiler::releaseNode(const AST* node) {
+    if (!node) {
+        return;
+    }
+    auto found = nodes.find(node);
+    if (found != nodes.end()) {
+        releasedNodes[{found->second.function, found->second.description}] += found->second.count;
+        nodes.erase(found);
+    }
+    switch (node->type) {
+        case NodeType::BIN_OP: {
+            auto binOp = static_cast<const BinOp*>(node);
+            releaseNode(binOp->left.get());
+            releaseNode(binOp->right.get());
+            break;
+        }
+        case NodeType::UNARY_OP:
+            releaseNode(static_cast<const UnaryOp*>(node)->expr.get());
+            break;
+        case NodeType::COMPOUND:
+            for (const auto& child : static_cast<const Compound*>(node)->children) {
+                releaseNode(child.get());
+            }
+            break;
+        case NodeType::ASSIGN: {
+            auto assign = static_cast<const Assign*>(node);
+            releaseNode(assign->left.get());
+            releaseNode(assign->right.get());
+            break;
+        }
+        case NodeType::FUNCTION_DEF:
+            releaseNode(static_cast<const FunctionDef*>(node)->body.get());
+            break;
+        case NodeType::FUNCTION_CALL:
+            for (const auto& arg : static_cast<const FunctionCall*>(node)->args) {
+                releaseNode(arg.get());
+            }
+            break;
+        case NodeType::CLASS_DEF:
+            for (const auto& method : static_cast<const ClassDef*>(node)->methods) {
+                releaseNode(method.get());
+            }
+            break;
+        case NodeType::RETURN:
+            releaseNode(static_cast<const Return*>(node)->expr.get());
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<const IfStatement*>(node);
+            releaseNode(ifNode->condition.get());
+            releaseNode(ifNode->thenBranch.get());
+            releaseNode(ifNode->elseBranch.get());
+            break;
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto whileNode = static_cast<const WhileStatement*>(node);
+            releaseNode(whileNode->condition.get());
+            releaseNode(whileNode->body.get());
+            break;
+        }
+        case NodeType::ARRAY_LITERAL:
+            for (const auto& element : static_cast<const ArrayLiteral*>(node)->elements) {
+                releaseNode(element.get());
+            }
+            break;
+        case NodeType::INDEX: {
+            auto index = static_cast<const Index*>(node);
+            releaseNode(index->array.get());
+            releaseNode(index->index.get());
+            break;
+        }
+        case NodeType::NUM:
+        case NodeType::VAR:
+        case NodeType::NO_OP:
+            break;
+    }
+}
+
+std::vector<FunctionProfile> Profiler::getFunctionProfiles() const {
+    std::vector<FunctionProfile> profiles;
+    for (const auto& [function, functionTotals] : totals) {
+        profiles.push_back({functionName(function), functionTotals.calls, functionTotals.inclusiveSeconds,
+                            functionTotals.exclusiveSeconds});
+    }
+    std::sort(profiles.begin(), profiles.end(), [](const FunctionProfile& a, const FunctionProfile& b) {
+        if (a.exclusiveSeconds != b.exclusiveSeconds) {
+            return a.exclusiveSeconds > b.exclusiveSeconds;
+        }
+        return a.name < b.name;
+    });
+    return profiles;
+}
+
+std::vector<NodeProfile> Profiler::getNodeProfiles() const {
+    std::vector<NodeProfile> profiles;
+    profiles.reserve(nodes.size() + releasedNodes.size());
+    for (const auto& [node, profile] : nodes) {
+        profiles.push_back(profile);
+    }
+    for (const auto& [key, count] : releasedNodes) {
+        profiles.push_back({key.second, key.first, count});
+    }
+    std::sort(profiles.begin(), profiles.end(), [](const NodeProfile& a, const NodeProfile& b) {
+        if (a.count != b.count) {
+            return a.count > b.count;
+        }
+        if (a.function != b.function) {
+            return a.function < b.function;
+        }
+        return a.description < b.description;
+    });
+    return profiles;
+}
+
+void Profiler::writeReport(std::ostream& out, size_t maxNodes) const {
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << std::setw(12) << "calls" << std::setw(14) << "incl ms" << std::setw(14) << "excl ms" << "  function"
+        << std::endl;
+    for (const FunctionProfile& profile : getFunctionProfiles()) {
+        out << std::setw(12) << profile.calls << std::setw(14) << profile.inclusiveSeconds * 1000.0 << std::setw(14)
+            << profile.exclusiveSeconds * 1000.0 << "  " << profile.name << std::endl;
+    }
+
+    std::vector<NodeProfile> nodeProfiles = getNodeProfiles();
+    if (nodeProfiles.size() > maxNodes) {
+        nodeProfiles.resize(maxNodes);
+    }
+    out << std::endl << std::setw(12) << "count" << "  node (function)" << std::endl;
+    for (const NodeProfile& profile : nodeProfiles) {
+        out << std::setw(12) << profile.count << "  " << profile.description << " (" << profile.function << ")"
+            << std::endl;
+    }
+    out.flags(flags);
+}
+
+void Profiler::writeFoldedStacks(std::ostream& out) const {
+    std::vector<std::pair<std::string, long long>> lines;
+    for (size_t stack = 0; stack < stacks.size(); ++stack) {
+        long long micros = std::llround(stacks[stack].exclusiveSeconds * 1e6);
+        if (micros > 0) {
+            lines.emplace_back(stackPath(static_cast<int>(stack)), micros);
+        }
+    }
+    std::sort(lines.begin(), lines.end());
+    for (const auto& [path, micros] : lines) {
+        out << path << ' ' << micros << '\n';
+    }
+}
+
+std::string Profiler::functionName(Symbol function) {
+    return function == NO_SYMBOL ? TOP_LEVEL : std::string(symbolName(function));
+}
+
+std::string Profiler::describe(const AST* node) {
+    std::ostringstream text;
+    switch (node->type) {
+        case NodeType::BIN_OP:
+            text << "BinOp " << operatorText(static_cast<const BinOp*>(node)->op.type);
+            break;
+        case NodeType::NUM:
+            text << "Num " << static_cast<const Num*>(node)->value;
+            break;
+        case NodeType::UNARY_OP:
+            text << "UnaryOp " << operatorText(static_cast<const UnaryOp*>(node)->op.type);
+            break;
+        case NodeType::COMPOUND:
+            text << "Compound";
+            break;
+        case NodeType::ASSIGN: {
+            auto left = static_cast<const Assign*>(node)->left.get();
+            text << "Assign";
+            if (left->type == NodeType::VAR) {
+                text << ' ' << static_cast<const Var*>(left)->value;
+            }
+            break;
+        }
+        case NodeType::VAR:
+            text << "Var " << static_cast<const Var*>(node)->value;
+            break;
+        case NodeType::NO_OP:
+            text << "NoOp";
+            break;
+        case NodeType::FUNCTION_DEF:
+            text << "FunctionDef " << static_cast<const FunctionDef*>(node)->name;
+            break;
+        case NodeType::FUNCTION_CALL:
+            text << "FunctionCall " << static_cast<const FunctionCall*>(node)->name;
+            break;
+        case NodeType::CLASS_DEF:
+            text << "ClassDef " << static_cast<const ClassDef*>(node)->name;
+            break;
+        case NodeType::RETURN:
+            text << "Return";
+            break;
+        case NodeType::IF_STATEMENT:
+            text << "IfStatement";
+            break;
+        case NodeType::WHILE_STATEMENT:
+            text << "WhileStatement";
+            break;
+        case NodeType::ARRAY_LITERAL:
+            text << "ArrayLiteral";
+            break;
+        case NodeType::INDEX:
+            text << "Index";
+            break;
+    }
+    return text.str();
+}
+
+// Frames from the outermost in, as flamegraph tools expect
+std::string Profiler::stackPath(int stack) const {
+    std::vector<int> chain;
+    for (int s = stack; s >= 0; s = stacks[s].parent) {
+        chain.push_back(s);
+    }
+    std::string path;
+    for (auto s = chain.rbegin(); s != chain.rend(); ++s) {
+        if (!path.empty()) {
+            path += ';';
+        }
+        path += functionName(stacks[*s].function);
+    }
+    return path;
+}
@@ -0,0 +1,46 @@
+#include "program.h"
+#include <stdexcept>
+#include "lexer.h"
+#include "parser.h"
+#include "optimizer.h"
+
+std::shared_ptr<const Program> Program::compile(std::string_view source, bool optimize) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    ASTPtr tree = parser.parse();
+    if (optimize) {
+        Optimizer().optimize(tree);
+    }
+
+    // The machine's state after the top-level code is the program's
+    VirtualMachine vm;
+    vm.interpret(tree);
+    std::shared_ptr<Program> program(new Program());
+    program->functionProtos = std::move(vm.functionProtos);
+    program->bindings = std::move(vm.own);
+    return program;
+}
+
+bool Program::hasFunction(const std::string& name) const {
+    int slot = bindings.functionSlots.find(Interner::global().find(name));
+    return slot >= 0 && bindings.functions[slot];
+}
+
+double Program::getVariableValue(const std::string& name) const {
+    int slot = bindings.globalSlots.find(Interner::global().find(name));
+    if (slot < 0 || isUndefinedSlot(bindings.globals[slot])) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    return bindings.globals[slot];
+}
+
+ExecutionContext::ExecutionContext(std::shared_ptr<const Program> program)
+    : program(std::move(program)), vm(*this->program) {}
+
+double ExecutionContext::call(const std::string& function, const double* args, size_t argCount) {
+    Symbol symbol = Interner::global().find(function);
+    if (symbol == NO_SYMBOL) {
+        throw std::runtime_error("Undefined function: " + function);
+    }
+    return vm.call(symbol, args, argCount);
+}
@@ -0,0 +1,472 @@
+#include "programcache.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "sourcefile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x4843434D; // "MCCH"
+constexpr uint32_t FLAG_OPTIMIZED = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    uint64_t bodySize;
+    uint64_t bodyChecksum;
+};
+
+static_assert(sizeof(Header) == 48, "Cache header layout must not depend on padding");
+
+// Literal text for operator tokens rebuilt on load
+std::string_view operatorText(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS: return "+";
+        case TokenType::MINUS: return "-";
+        case TokenType::MULTIPLY: return "*";
+        case TokenType::DIVIDE: return "/";
+        case TokenType::MODULUS: return "%";
+        case TokenType::POWER: return "^";
+        case TokenType::EQUALS: return "==";
+        case TokenType::NOT_EQUALS: return "!=";
+        case TokenType::LESS_THAN: return "<";
+        case TokenType::GREATER_THAN: return ">";
+        case TokenType::LESS_EQUAL: return "<=";
+        case TokenType::GREATER_EQUAL: return ">=";
+        default: return {};
+    }
+}
+
+class Writer {
+public:
+    std::string names;
+    std::string nodes;
+    uint32_t nameCount = 0;
+
+    void node(const AST* node) {
+        put<uint8_t>(static_cast<uint8_t>(node->type));
+        switch (node->type) {
+            case NodeType::BIN_OP: {
+                auto binOp = static_cast<const BinOp*>(node);
+                put<uint8_t>(static_cast<uint8_t>(binOp->op.type));
+                this->node(binOp->left.get());
+                this->node(binOp->right.get());
+                break;
+            }
+            case NodeType::NUM:
+                put<double>(static_cast<const Num*>(node)->value);
+                break;
+            case NodeType::UNARY_OP: {
+                auto unaryOp = static_cast<const UnaryOp*>(node);
+                put<uint8_t>(static_cast<uint8_t>(unaryOp->op.type));
+                this->node(unaryOp->expr.get());
+                break;
+            }
+            case NodeType::COMPOUND:
+                list(static_cast<const Compound*>(node)->children);
+                break;
+            case NodeType::ASSIGN: {
+                auto assign = static_cast<const Assign*>(node);
+                this->node(assign->left.get());
+                this->node(assign->right.get());
+                break;
+            }
+            case NodeType::VAR:
+                symbol(static_cast<const Var*>(node)->symbol);
+                break;
+            case NodeType::NO_OP:
+                break;
+            case NodeType::FUNCTION_DEF: {
+                auto def = static_cast<const FunctionDef*>(node);
+                symbol(def->symbol);
+                put<uint32_t>(static_cast<uint32_t>(def->params.size()));
+                for (Symbol param : def->params) {
+                    symbol(param);
+                }
+                this->node(def->body.get());
+                break;
+            }
+            case NodeType::FUNCTION_CALL: {
+                auto call = static_cast<const FunctionCall*>(node);
+                symbol(call->symbol);
+                list(call->args);
+                break;
+            }
+            case NodeType::CLASS_DEF: {
+                auto classDef = static_cast<const ClassDef*>(node);
+                symbol(classDef->symbol);
+                list(classDef->methods);
+                break;
+            }
+            case NodeType::RETURN:
+                this->node(static_cast<const Return*>(node)->expr.get());
+                break;
+            case NodeType::IF_STATEMENT: {
+                auto ifNode = static_cast<const IfStatement*>(node);
+                this->node(ifNode->condition.get());
+                this->node(ifNode->thenBranch.get());
+                put<uint8_t>(ifNode->elseBranch ? 1 : 0);
+                if (ifNode->elseBranch) {
+                    this->node(ifNode->elseBranch.get());
+                }
+                break;
+            }
+            case NodeType::WHILE_STATEMENT: {
+                auto whileNode = static_cast<const WhileStatement*>(node);
+                this->node(whileNode->condition.get());
+                this->node(whileNode->body.get());
+                break;
+            }
+            case NodeType::ARRAY_LITERAL:
+                list(static_cast<const ArrayLiteral*>(node)->elements);
+                break;
+            case NodeType::INDEX: {
+                auto index = static_cast<const Index*>(node);
+                this->node(index->array.get());
+                this->node(index->index.get());
+                break;
+            }
+        }
+    }
+
+private:
+    std::unordered_map<Symbol, uint32_t> indices; // process Symbol -> index in the file's name table
+
+    template <typename T>
+    void put(T value) {
+        nodes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void list(const std::vector<ASTPtr>& children) {
+        put<uint32_t>(static_cast<uint32_t>(children.size()));
+        for (const ASTPtr& child : children) {
+            node(child.get());
+        }
+    }
+
+    void symbol(Symbol symbol) {
+        auto it = indices.find(symbol);
+        if (it == indices.end()) {
+            std::string_view name = symbolName(symbol);
+            uint32_t length = static_cast<uint32_t>(name.size());
+            names.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            names.append(name);
+            it = indices.emplace(symbol, nameCount++).first;
+        }
+        put<uint32_t>(it->second);
+    }
+};
+
+// Every read is bounds-checked: a damaged file must fail to decode, never crash
+class Reader {
+public:
+    Reader(std::string_view bytes, ASTArena& arena) : bytes(bytes), arena(arena) {}
+
+    void readNames() {
+        uint32_t count = get<uint32_t>();
+        need(static_cast<uint64_t>(count) * sizeof(uint32_t));
+        symbols.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t length = get<uint32_t>();
+            need(length);
+            symbols.push_back(intern(bytes.substr(pos, length)));
+            pos += length;
+        }
+    }
+
+    ASTPtr node() {
+        auto type = static_cast<NodeType>(get<uint8_t>());
+        switch (type) {
+            case NodeType::BIN_OP: {
+                Token op = operatorToken(false);
+                ASTPtr left = node();
+                ASTPtr right = node();
+                return arena.makePtr<BinOp>(std::move(left), op, std::move(right));
+            }
+            case NodeType::NUM:
+                return arena.makePtr<Num>(get<double>());
+            case NodeType::UNARY_OP: {
+                Token op = operatorToken(true);
+                return arena.makePtr<UnaryOp>(op, node());
+            }
+            case NodeType::COMPOUND: {
+                Compound* compound = arena.make<Compound>();
+                uint32_t count = count32();
+                for (uint32_t i = 0; i < count; ++i) {
+                    compound->addChild(node());
+                }
+                return ASTPtr(compound, ASTDeleter::borrowing());
+            }
+            case NodeType::ASSIGN: {
+                ASTPtr left = node();
+                if (left->type != NodeType::VAR) {
+                    corrupt();
+                }
+                ASTPtr right = node();
+                return arena.makePtr<Assign>(std::move(left), Token(TokenType::ASSIGN), std::move(right));
+            }
+            case NodeType::VAR: {
+                Symbol name = symbol();
+                return arena.makePtr<Var>(Token::identifier(name));
+            }
+            case NodeType::NO_OP:
+                return arena.makePtr<NoOp>();
+            case NodeType::FUNCTION_DEF: {
+                Symbol name = symbol();
+                uint32_t count = count32();
+                std::vector<Symbol> params;
+                params.reserve(count);
+                for (uint32_t i = 0; i < count; ++i) {
+                    params.push_back(symbol());
+                }
+                return arena.makePtr<FunctionDef>(name, std::move(params), node());
+            }
+            case NodeType::FUNCTION_CALL: {
+                Symbol name = symbol();
+                return arena.makePtr<FunctionCall>(name, list());
+            }
+            case NodeType::CLASS_DEF: {
+                Symbol name = symbol();
+                std::vector<ASTPtr> methods = list();
+                for (const ASTPtr& method : methods) {
+                    if (method->type != NodeType::FUNCTION_DEF) {
+                        corrupt();
+                    }
+                }
+                return arena.makePtr<ClassDef>(name, std::move(methods));
+            }
+            case NodeType::RETURN:
+                return arena.makePtr<Return>(node());
+            case NodeType::IF_STATEMENT: {
+                ASTPtr condition = node();
+                ASTPtr thenBranch = node();
+                ASTPtr elseBranch = get<uint8_t>() ? node() : nullptr;
+                return arena.makePtr<IfStatement>(std::move(condition), std::move(thenBranch),
+                                                  std::move(elseBranch));
+            }
+            case NodeType::WHILE_STATEMENT: {
+                ASTPtr condition = node();
+                ASTPtr body = node();
+                return arena.makePtr<WhileStatement>(std::move(condition), std::move(body));
+            }
+            case NodeType::ARRAY_LITERAL:
+                return arena.makePtr<ArrayLiteral>(list());
+            case NodeType::INDEX: {
+                ASTPtr array = node();
+                ASTPtr index = node();
+                return arena.makePtr<Index>(std::move(array), std::move(index));
+            }
+        }
+        corrupt();
+    }
+
+    bool atEnd() const { return pos == bytes.size(); }
+
+private:
+    std::string_view bytes;
+    size_t pos = 0;
+    ASTArena& arena;
+    std::vector<Symbol> symbols; // file name index -> process Symbol
+
+    [[noreturn]] static void corrupt() {
+        throw std::runtime_error("Corrupt program cache");
+    }
+
+    void need(uint64_t size) const {
+        if (size > bytes.size() - pos) {
+            corrupt();
+        }
+    }
+
+    template <typename T>
+    T get() {
+        need(sizeof(T));
+        T value;
+        std::memcpy(&value, bytes.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    // Element count of a list, each element taking at least one byte
+    uint32_t count32() {
+        uint32_t count = get<uint32_t>();
+        need(count);
+        return count;
+    }
+
+    Symbol symbol() {
+        uint32_t index = get<uint32_t>();
+        if (index >= symbols.size()) {
+            corrupt();
+        }
+        return symbols[index];
+    }
+
+    std::vector<ASTPtr> list() {
+        uint32_t count = count32();
+        std::vector<ASTPtr> children;
+        children.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            children.push_back(node());
+        }
+        return children;
+    }
+
+    Token operatorToken(bool unary) {
+        auto type = static_cast<TokenType>(get<uint8_t>());
+        if (operatorText(type).empty() || (unary && type != TokenType::PLUS && type != TokenType::MINUS)) {
+            corrupt();
+        }
+        return Token(type);
+    }
+};
+
+ASTPtr parseProgram(std::string_view source, bool optimize) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    ASTPtr tree = parser.parse();
+    if (optimize) {
+        Optimizer optimizer;
+        optimizer.optimize(tree);
+    }
+    return tree;
+}
+
+// Written under a unique name and renamed into place, so concurrent runs never
+// see a partial file
+void writeCache(const std::string& path, const std::string& bytes) {
+    std::string temporary = path + ".tmp" +
+                            std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                                           static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+            out.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+} // namespace
+
+std::string ProgramCache::cachePathFor(const std::string& sourcePath) {
+    return sourcePath + ".mcache";
+}
+
+uint64_t ProgramCache::hash(std::string_view bytes) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string ProgramCache::serialize(const AST* tree, std::string_view source, bool optimized) {
+    Writer writer;
+    writer.node(tree);
+
+    std::string body;
+    body.reserve(sizeof(uint32_t) + writer.names.size() + writer.nodes.size());
+    body.append(reinterpret_cast<const char*>(&writer.nameCount), sizeof(writer.nameCount));
+    body += writer.names;
+    body += writer.nodes;
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = FORMAT_VERSION;
+    header.flags = optimized ? FLAG_OPTIMIZED : 0;
+    header.sourceSize = source.size();
+    header.sourceHash = hash(source);
+    header.bodySize = body.size();
+    header.bodyChecksum = hash(body);
+
+    std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes += body;
+    return bytes;
+}
+
+ASTPtr ProgramCache::deserialize(std::string_view bytes, std::string_view source, bool optimized, Status* status) {
+    auto fail = [status](Status reason, const char* message) -> ASTPtr {
+        if (status) {
+            *status = reason;
+        }
+        throw std::runtime_error(message);
+    };
+
+    Header header;
+    if (bytes.size() < sizeof(header)) {
+        return fail(Status::CORRUPT, "Corrupt program cache");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != MAGIC) {
+        return fail(Status::CORRUPT, "Corrupt program cache");
+    }
+    if (header.version != FORMAT_VERSION || header.flags != (optimized ? FLAG_OPTIMIZED : 0) ||
+        header.sourceSize != source.size() || header.sourceHash != hash(source)) {
+        return fail(Status::STALE, "Stale program cache");
+    }
+    std::string_view body = bytes.substr(sizeof(header));
+    if (header.bodySize != body.size() || header.bodyChecksum != hash(body)) {
+        return fail(Status::CORRUPT, "Corrupt program cache");
+    }
+
+    auto arena = std::make_unique<ASTArena>();
+    ASTPtr root;
+    try {
+        Reader reader(body, *arena);
+        reader.readNames();
+        root = reader.node();
+        if (!reader.atEnd()) {
+            return fail(Status::CORRUPT, "Corrupt program cache");
+        }
+    } catch (const std::runtime_error&) {
+        if (status) {
+            *status = Status::CORRUPT;
+        }
+        throw;
+    }
+    if (status) {
+        *status = Status::HIT;
+    }
+    return ASTPtr(root.release(), ASTDeleter::owning(arena.release()));
+}
+
+ASTPtr ProgramCache::load(const std::string& sourcePath, std::string_view source, bool optimize, Status* status) {
+    std::string cachePath = cachePathFor(sourcePath);
+    Status outcome = Status::MISSING;
+    try {
+        SourceFile cached = SourceFile::map(cachePath);
+        ASTPtr tree = deserialize(cached.text(), source, optimize, &outcome);
+        if (status) {
+            *status = outcome;
+        }
+        return tree;
+    } catch (const std::runtime_error&) {
+        // Missing, stale or corrupt: parse the source and replace the file
+    }
+    if (status) {
+        *status = outcome;
+    }
+
+    ASTPtr tree = parseProgram(source, optimize);
+    writeCache(cachePath, serialize(tree.get(), source, optimize));
+    return tree;
+}
@@ -0,0 +1,174 @@
+#include "repl.h"
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include "lexer.h"
+#include "parser.h"
+
+namespace {
+
+bool isBlank(std::string_view text) {
+    return text.find_first_not_of(" \t\r\n") == std::string_view::npos;
+}
+
+// What isComplete and awaitsElse need to know about the tokens of a snippet
+struct SnippetShape {
+    bool lexError = false;
+    int depth = 0;
+    TokenType last = TokenType::END_OF_FILE;
+    // Keyword of the top-level statement the last block at depth 0 belongs to
+    TokenType blockOwner = TokenType::END_OF_FILE;
+};
+
+SnippetShape shapeOf(std::string_view text) {
+    SnippetShape shape;
+    try {
+        Lexer lexer(text);
+        for (Token token = lexer.getNextToken(); token.type != TokenType::END_OF_FILE;
+             token = lexer.getNextToken()) {
+            switch (token.type) {
+                case TokenType::LEFT_PAREN:
+                case TokenType::LEFT_BRACE:
+                case TokenType::LEFT_BRACKET:
+                    shape.depth++;
+                    break;
+                case TokenType::RIGHT_PAREN:
+                case TokenType::RIGHT_BRACE:
+                case TokenType::RIGHT_BRACKET:
+                    shape.depth--;
+                    break;
+                case TokenType::IF:
+                case TokenType::ELSE:
+                case TokenType::WHILE:
+                case TokenType::FUNCTION:
+                case TokenType::CLASS:
+                    if (shape.depth == 0) {
+                        shape.blockOwner = token.type;
+                    }
+                    break;
+                case TokenType::SEMICOLON:
+                    if (shape.depth == 0) {
+                        shape.blockOwner = TokenType::END_OF_FILE;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            shape.last = token.type;
+        }
+    } catch (const std::runtime_error&) {
+        shape.lexError = true;
+    }
+    return shape;
+}
+
+bool startsWithElse(std::string_view line) {
+    try {
+        Lexer lexer(line);
+        return lexer.getNextToken().type == TokenType::ELSE;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+} // namespace
+
+Repl::Repl(Interpreter& interpreter, bool optimize) : interpreter(interpreter), optimize(optimize) {}
+
+bool Repl::isComplete(std::string_view text) {
+    SnippetShape shape = shapeOf(text);
+    if (shape.lexError) {
+        return true;
+    }
+    // An unmatched closing bracket cannot be completed either
+    return shape.depth < 0 ||
+           (shape.depth == 0 && (shape.last == TokenType::SEMICOLON || shape.last == TokenType::RIGHT_BRACE));
+}
+
+bool Repl::awaitsElse(std::string_view text) {
+    SnippetShape shape = shapeOf(text);
+    return !shape.lexError && shape.depth == 0 && shape.last == TokenType::RIGHT_BRACE &&
+           shape.blockOwner == TokenType::IF;
+}
+
+std::optional<double> Repl::run(std::string_view snippet) {
+    Lexer lexer(snippet);
+    Parser parser(lexer);
+    std::optional<double> result;
+    while (ASTPtr statement = parser.parseStatement()) {
+        if (optimize) {
+            optimizer.optimize(statement);
+        }
+        bool silent = statement->type == NodeType::FUNCTION_DEF || statement->type == NodeType::CLASS_DEF ||
+                      statement->type == NodeType::ASSIGN;
+        double value = interpreter.interpretStatement(std::move(statement));
+        result = silent ? std::nullopt : std::optional<double>(value);
+        if (interpreter.returned()) {
+            // The rest of the snippet is unreachable, as after a return in a program
+            break;
+        }
+    }
+    return result;
+}
+
+std::string Repl::format(double value) const {
+    char buffer[32];
+    if (!isArrayValue(value)) {
+        return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+    }
+    std::string text = "[";
+    for (double element : interpreter.arrayElements(value)) {
+        if (text.size() > 1) {
+            text += ", ";
+        }
+        text.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), element).ptr);
+    }
+    return text + "]";
+}
+
+void Repl::loop(std::istream& in, std::ostream& out, std::ostream& err) {
+    std::string snippet;
+    std::string line;
+    auto runSnippet = [&]() {
+        try {
+            if (std::optional<double> value = run(snippet)) {
+                out << format(*value) << '\n';
+            }
+        } catch (const std::exception& ex) {
+            err << ex.what() << std::endl;
+        }
+        snippet.clear();
+    };
+
+    bool awaitingElse = false;
+    out << PROMPT << std::flush;
+    while (std::getline(in, line)) {
+        // An if held back for its else runs as it is once the next line is not one
+        if (awaitingElse && !startsWithElse(line)) {
+            runSnippet();
+        }
+        awaitingElse = false;
+        snippet += line;
+        snippet += '\n';
+        if (isBlank(snippet)) {
+            snippet.clear();
+        } else if (isComplete(snippet)) {
+            if (awaitsElse(snippet)) {
+                awaitingElse = true;
+                out << CONTINUATION_PROMPT << std::flush;
+                continue;
+            }
+            runSnippet();
+        } else {
+            out << CONTINUATION_PROMPT << std::flush;
+            continue;
+        }
+        out << PROMPT << std::flush;
+    }
+    // Input that ends inside a snippet still runs, so its error is reported
+    if (!isBlank(snippet)) {
+        runSnippet();
+    }
+    out << std::endl;
+}
@@ -0,0 +1,184 @@
+#include "resolver.h"
+
+Resolver::Resolver(SymbolTable& symbolTable) : symbolTable(symbolTable) {}
+
+void Resolver::resolve(AST* tree) {
+    // Top-level assignments create globals, wherever they appear in the program
+    declareGlobals(tree);
+    function = nullptr;
+    resolveNode(tree);
+}
+
+void Resolver::declareGlobals(AST* node) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                declareGlobals(child.get());
+            }
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            declareGlobals(ifNode->thenBranch.get());
+            declareGlobals(ifNode->elseBranch.get());
+            break;
+        }
+        case NodeType::WHILE_STATEMENT:
+            declareGlobals(static_cast<WhileStatement*>(node)->body.get());
+            break;
+        case NodeType::ASSIGN: {
+            AST* target = static_cast<Assign*>(node)->left.get();
+            if (target->type == NodeType::VAR) {
+                symbolTable.declareGlobal(static_cast<Var*>(target)->symbol);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Every name assigned in a function body (but not in nested definitions) is a local
+void Resolver::collectLocals(AST* node, FunctionScope& scope) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                collectLocals(child.get(), scope);
+            }
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            collectLocals(ifNode->thenBranch.get(), scope);
+            collectLocals(ifNode->elseBranch.get(), scope);
+            break;
+        }
+        case NodeType::WHILE_STATEMENT:
+            collectLocals(static_cast<WhileStatement*>(node)->body.get(), scope);
+            break;
+        case NodeType::ASSIGN: {
+            AST* target = static_cast<Assign*>(node)->left.get();
+            if (target->type == NodeType::VAR) {
+                Symbol name = static_cast<Var*>(target)->symbol;
+                if (scope.slots.find(name) == scope.slots.end()) {
+                    scope.slots.emplace(name, scope.slotCount++);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Resolver::resolveNode(AST* node) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case NodeType::BIN_OP: {
+            auto binOp = static_cast<BinOp*>(node);
+            resolveNode(binOp->left.get());
+            resolveNode(binOp->right.get());
+            break;
+        }
+        case NodeType::UNARY_OP:
+            resolveNode(static_cast<UnaryOp*>(node)->expr.get());
+            break;
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                resolveNode(child.get());
+            }
+            break;
+        case NodeType::ASSIGN: {
+            auto assign = static_cast<Assign*>(node);
+            resolveNode(assign->right.get());
+            if (assign->left->type == NodeType::VAR) {
+                resolveVar(static_cast<Var*>(assign->left.get()));
+            }
+            break;
+        }
+        case NodeType::VAR:
+            resolveVar(static_cast<Var*>(node));
+            break;
+        case NodeType::FUNCTION_DEF:
+            resolveFunction(static_cast<FunctionDef*>(node));
+            break;
+        case NodeType::FUNCTION_CALL:
+            for (auto& arg : static_cast<FunctionCall*>(node)->args) {
+                resolveNode(arg.get());
+            }
+            break;
+        case NodeType::CLASS_DEF:
+            for (auto& method : static_cast<ClassDef*>(node)->methods) {
+                resolveNode(method.get());
+            }
+            break;
+        case NodeType::RETURN:
+            resolveNode(static_cast<Return*>(node)->expr.get());
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            resolveNode(ifNode->condition.get());
+            resolveNode(ifNode->thenBranch.get());
+            resolveNode(ifNode->elseBranch.get());
+            break;
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto whileNode = static_cast<WhileStatement*>(node);
+            resolveNode(whileNode->condition.get());
+            resolveNode(whileNode->body.get());
+            break;
+        }
+        case NodeType::ARRAY_LITERAL:
+            for (auto& element : static_cast<ArrayLiteral*>(node)->elements) {
+                resolveNode(element.get());
+            }
+            break;
+        case NodeType::INDEX: {
+            auto index = static_cast<Index*>(node);
+            resolveNode(index->array.get());
+            resolveNode(index->index.get());
+            break;
+        }
+        case NodeType::NUM:
+        case NodeType::NO_OP:
+            break;
+    }
+}
+
+void Resolver::resolveFunction(FunctionDef* node) {
+    FunctionScope scope;
+    // Parameters take the first slots in call order; a repeated name binds to its last position
+    for (Symbol param : node->params) {
+        scope.slots[param] = scope.slotCount++;
+    }
+    collectLocals(node->body.get(), scope);
+    node->numLocals = scope.slotCount;
+
+    FunctionScope* enclosing = function;
+    function = &scope;
+    resolveNode(node->body.get());
+    function = enclosing;
+}
+
+void Resolver::resolveVar(Var* node) {
+    if (function) {
+        auto it = function->slots.find(node->symbol);
+        if (it != function->slots.end()) {
+            node->depth = SymbolTable::LOCAL_DEPTH;
+            node->slot = it->second;
+            return;
+        }
+    }
+    // Any other name is a global. It may not be assigned yet, or ever: a read from
+    // a function body can run after the assignment, and a top-level read can sit on
+    // a path that never runs. The slot starts undefined and a read that does run
+    // reports the error.
+    node->depth = SymbolTable::GLOBAL_DEPTH;
+    node->slot = symbolTable.declareGlobal(node->symbol);
+}
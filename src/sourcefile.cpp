@@ -0,0 +1,84 @@
+#include "sourcefile.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCEFILE_HAS_MMAP 1
+#endif
+
+SourceFile SourceFile::map(const std::string& path) {
+#ifdef SOURCEFILE_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::close(fd);
+            ::madvise(address, size, MADV_SEQUENTIAL);
+            SourceFile source;
+            source.mapping = address;
+            source.mappingSize = size;
+            source.view = std::string_view(static_cast<const char*>(address), size);
+            return source;
+        }
+    }
+    ::close(fd);
+#endif
+    // Empty files, pipes and platforms without mmap are read into memory
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    return read(file);
+}
+
+SourceFile SourceFile::read(std::istream& in) {
+    SourceFile source;
+    std::stringstream contents;
+    contents << in.rdbuf();
+    source.buffer = contents.str();
+    source.view = source.buffer;
+    return source;
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        buffer = std::move(other.buffer);
+        view = mapping ? other.view : std::string_view(buffer);
+        other.mapping = nullptr;
+        other.mappingSize = 0;
+        other.view = std::string_view();
+    }
+    return *this;
+}
+
+SourceFile::~SourceFile() {
+    release();
+}
+
+void SourceFile::release() noexcept {
+#ifdef SOURCEFILE_HAS_MMAP
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+}
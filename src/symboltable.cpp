@@ -1,32 +1,59 @@
 #include "symboltable.h"
 
-SymbolTable::SymbolTable() {
-    // Initialize with a global scope
-    scopes.emplace_back();
+namespace {
+
+// Slots the stack starts with, enough for most call depths
+constexpr size_t INITIAL_STACK_SLOTS = 1024;
+
+} // namespace
+
+SymbolTable::SymbolTable() : stack(INITIAL_STACK_SLOTS), locals(globals.data()) {}
+
+void SymbolTable::set(Symbol name, double value) {
+    globals[declareGlobal(name)] = value;
 }
 
-void SymbolTable::set(const std::string& name, double value) {
-    scopes.back()[name] = value;
+double SymbolTable::get(Symbol name) const {
+    int slot = findGlobal(name);
+    if (slot < 0 || isUndefinedSlot(globals[slot])) {
+        throw std::runtime_error("Undefined variable: " + std::string(symbolName(name)));
+    }
+    return globals[slot];
 }
 
-double SymbolTable::get(const std::string& name) const {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-        auto varIt = it->find(name);
-        if (varIt != it->end()) {
-            return varIt->second;
-        }
+int SymbolTable::declareGlobal(Symbol name) {
+    auto [found, inserted] = globalSlots.try_emplace(name, static_cast<int>(globalSymbols.size()));
+    if (!inserted) {
+        return found->second;
     }
-    throw std::runtime_error("Undefined variable: " + name);
+    int slot = found->second;
+    globalSymbols.push_back(name);
+    globals.push_back(undefinedSlot());
+    if (frameBases.empty()) {
+        locals = globals.data();
+    }
+    return slot;
 }
 
-void SymbolTable::enterScope() {
-    scopes.emplace_back();
+void SymbolTable::growStack(size_t slotCount) {
+    stack.resize(std::max(slotCount, stack.size() * 2));
+    if (!frameBases.empty()) {
+        locals = stack.data() + frameBases.back();
+    }
 }
 
-void SymbolTable::leaveScope() {
-    if (scopes.size() > 1) {
-        scopes.pop_back();
-    } else {
-        throw std::runtime_error("Cannot leave global scope");
+void SymbolTable::reuseScope(size_t slotCount) {
+    if (frameBases.empty()) {
+        throw std::runtime_error("Cannot reuse global scope");
     }
+    size_t base = frameBases.back();
+    reserveSlots(base + slotCount);
+    top = base + slotCount;
+    std::fill(locals, locals + slotCount, undefinedSlot());
+}
+
+void SymbolTable::resetScopes() {
+    frameBases.clear();
+    top = 0;
+    locals = globals.data();
 }
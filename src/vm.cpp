@@ -0,0 +1,299 @@
+#include "vm.h"
+#include "bytecodecompiler.h"
+#include "program.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Use a computed-goto dispatch table where the compiler supports labels as values
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+VirtualMachine::VirtualMachine() : protos(&functionProtos), bindings(&own), functions(&own.functions) {}
+
+// Calls never store globals, so nothing of the Program needs copying up front
+VirtualMachine::VirtualMachine(const Program& program)
+    : protos(&program.functionProtos), bindings(&program.bindings), functions(&program.bindings.functions) {}
+
+double VirtualMachine::interpret(ASTPtr& tree) {
+    if (protos != &functionProtos) {
+        throw std::runtime_error("Cannot interpret on a machine running a compiled program");
+    }
+    topLevelReturn = false;
+    BytecodeCompiler compiler(functionProtos, own.globalSlots, own.functionSlots);
+    std::unique_ptr<FunctionProto> script = compiler.compile(tree.get());
+    return run(script.get());
+}
+
+double VirtualMachine::getVariableValue(const std::string& name) const {
+    // A script that failed to compile can leave slots the tables do not have yet
+    int slot = bindings->globalSlots.find(Interner::global().find(name));
+    const std::vector<double>& globals = bindings->globals;
+    if (slot < 0 || static_cast<size_t>(slot) >= globals.size() || isUndefinedSlot(globals[slot])) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    return globals[slot];
+}
+
+// Names that are not locals of the executing function are globals
+double VirtualMachine::loadGlobal(uint32_t slot) const {
+    double value = bindings->globals[slot];
+    if (!isUndefinedSlot(value)) {
+        return value;
+    }
+    throw std::runtime_error("Undefined variable: " + std::string(symbolName(bindings->globalSlots.name(slot))));
+}
+
+// A local read before its first assignment falls back to the global of that name
+double VirtualMachine::loadUnassignedLocal(Symbol name) const {
+    int slot = bindings->globalSlots.find(name);
+    if (slot < 0) {
+        throw std::runtime_error("Undefined variable: " + std::string(symbolName(name)));
+    }
+    return loadGlobal(static_cast<uint32_t>(slot));
+}
+
+void VirtualMachine::ensureStack(size_t used, size_t needed) {
+    if (stack.size() < used + needed) {
+        stack.resize(std::max(stack.size() * 2, used + needed + 256));
+    }
+}
+
+double VirtualMachine::run(const FunctionProto* script) {
+    // The compiler gave slots to every name the script refers to
+    own.globals.resize(own.globalSlots.size(), undefinedSlot());
+    own.functions.resize(own.functionSlots.size(), nullptr);
+    frames.clear();
+    ensureStack(0, script->maxStack);
+    frames.push_back({script, script->code.data(), 0});
+    return execute(0);
+}
+
+double VirtualMachine::call(Symbol function, const double* args, size_t argCount) {
+    int slot = bindings->functionSlots.find(function);
+    const FunctionProto* callee =
+        slot >= 0 && static_cast<size_t>(slot) < functions->size() ? (*functions)[slot] : nullptr;
+    if (!callee) {
+        throw std::runtime_error("Undefined function: " + std::string(symbolName(function)));
+    }
+    if (argCount != callee->arity) {
+        throw std::runtime_error("Incorrect number of arguments in function call: " + callee->name);
+    }
+
+    // The callee's frame is the outermost, so its return ends the run
+    frames.clear();
+    ensureStack(0, callee->numLocals + callee->maxStack);
+    std::copy(args, args + argCount, stack.begin());
+    std::fill(stack.begin() + argCount, stack.begin() + callee->numLocals, undefinedSlot());
+    frames.push_back({callee, callee->code.data(), 0});
+    return execute(callee->numLocals);
+}
+
+double VirtualMachine::execute(size_t stackUsed) {
+    const FunctionProto* proto = frames.back().proto;
+    const uint8_t* ip = frames.back().ip;
+    double* slots = stack.data() + frames.back().base;
+    double* sp = stack.data() + stackUsed;
+
+#define READ_OPERAND(type, var) \
+    type var;                   \
+    std::memcpy(&var, ip, sizeof(type)); \
+    ip += sizeof(type)
+
+#define BINARY_OP(expression) \
+    {                         \
+        double right = *--sp; \
+        double left = sp[-1]; \
+        sp[-1] = (expression); \
+        VM_NEXT();            \
+    }
+
+#ifdef VM_COMPUTED_GOTO
+    // Must list the handlers in OpCode order
+    static void* dispatchTable[] = {
+        &&op_CONSTANT, &&op_LOAD_LOCAL, &&op_STORE_LOCAL, &&op_LOAD_GLOBAL, &&op_STORE_GLOBAL,
+        &&op_ADD, &&op_SUBTRACT, &&op_MULTIPLY, &&op_DIVIDE, &&op_MODULUS, &&op_POWER,
+        &&op_EQUAL, &&op_NOT_EQUAL, &&op_LESS, &&op_GREATER, &&op_LESS_EQUAL, &&op_GREATER_EQUAL,
+        &&op_NEGATE, &&op_POP, &&op_JUMP, &&op_JUMP_IF_FALSE, &&op_CALL, &&op_TAIL_CALL, &&op_RETURN,
+        &&op_DEFINE_FUNCTION, &&op_DEFINE_CLASS,
+    };
+#define VM_CASE(op) op_##op:
+#define VM_NEXT() goto *dispatchTable[*ip++]
+    VM_NEXT();
+#else
+#define VM_CASE(op) case OpCode::op:
+#define VM_NEXT() goto dispatch
+dispatch:
+    switch (static_cast<OpCode>(*ip++)) {
+#endif
+
+    VM_CASE(CONSTANT) {
+        READ_OPERAND(double, value);
+        *sp++ = value;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_LOCAL) {
+        READ_OPERAND(uint16_t, slot);
+        double value = slots[slot];
+        if (isUndefinedSlot(value)) {
+            value = loadUnassignedLocal(proto->localNames[slot]);
+        }
+        *sp++ = value;
+        VM_NEXT();
+    }
+    VM_CASE(STORE_LOCAL) {
+        READ_OPERAND(uint16_t, slot);
+        slots[slot] = sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_GLOBAL) {
+        READ_OPERAND(uint32_t, slot);
+        *sp++ = loadGlobal(slot);
+        VM_NEXT();
+    }
+    VM_CASE(STORE_GLOBAL) {
+        READ_OPERAND(uint32_t, slot);
+        // Only top-level code stores globals, and only an own machine runs it
+        own.globals[slot] = sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(ADD) BINARY_OP(left + right)
+    VM_CASE(SUBTRACT) BINARY_OP(left - right)
+    VM_CASE(MULTIPLY) BINARY_OP(left * right)
+    VM_CASE(DIVIDE) {
+        double right = *--sp;
+        if (right == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        sp[-1] = sp[-1] / right;
+        VM_NEXT();
+    }
+    VM_CASE(MODULUS) BINARY_OP(std::fmod(left, right))
+    VM_CASE(POWER) BINARY_OP(std::pow(left, right))
+    VM_CASE(EQUAL) BINARY_OP(left == right ? 1.0 : 0.0)
+    VM_CASE(NOT_EQUAL) BINARY_OP(left != right ? 1.0 : 0.0)
+    VM_CASE(LESS) BINARY_OP(left < right ? 1.0 : 0.0)
+    VM_CASE(GREATER) BINARY_OP(left > right ? 1.0 : 0.0)
+    VM_CASE(LESS_EQUAL) BINARY_OP(left <= right ? 1.0 : 0.0)
+    VM_CASE(GREATER_EQUAL) BINARY_OP(left >= right ? 1.0 : 0.0)
+    VM_CASE(NEGATE) {
+        sp[-1] = -sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(POP) {
+        --sp;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP) {
+        READ_OPERAND(uint32_t, target);
+        ip = proto->code.data() + target;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP_IF_FALSE) {
+        READ_OPERAND(uint32_t, target);
+        if (*--sp == 0.0) {
+            ip = proto->code.data() + target;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(CALL) {
+        READ_OPERAND(uint32_t, slot);
+        READ_OPERAND(uint8_t, argc);
+        const FunctionProto* callee = (*functions)[slot];
+        if (!callee) {
+            throw std::runtime_error("Undefined function: " + std::string(symbolName(bindings->functionSlots.name(slot))));
+        }
+        if (frames.size() > static_cast<size_t>(MAX_RECURSION_DEPTH)) {
+            throw std::runtime_error("Maximum recursion depth exceeded in function: " + std::string(symbolName(bindings->functionSlots.name(slot))));
+        }
+        if (argc != callee->arity) {
+            throw std::runtime_error("Incorrect number of arguments in function call: " + std::string(symbolName(bindings->functionSlots.name(slot))));
+        }
+
+        frames.back().ip = ip;
+        // The arguments already on the stack become the callee's first slots
+        size_t base = static_cast<size_t>(sp - stack.data()) - argc;
+        ensureStack(base, callee->numLocals + callee->maxStack);
+        sp = stack.data() + base + argc;
+        for (size_t slot = argc; slot < callee->numLocals; ++slot) {
+            *sp++ = undefinedSlot();
+        }
+        frames.push_back({callee, callee->code.data(), base});
+        proto = callee;
+        ip = callee->code.data();
+        slots = stack.data() + base;
+        VM_NEXT();
+    }
+    VM_CASE(TAIL_CALL) {
+        READ_OPERAND(uint32_t, slot);
+        READ_OPERAND(uint8_t, argc);
+        const FunctionProto* callee = (*functions)[slot];
+        if (!callee) {
+            throw std::runtime_error("Undefined function: " + std::string(symbolName(bindings->functionSlots.name(slot))));
+        }
+        if (argc != callee->arity) {
+            throw std::runtime_error("Incorrect number of arguments in function call: " + std::string(symbolName(bindings->functionSlots.name(slot))));
+        }
+
+        // The arguments replace the current frame's slots; the depth does not grow
+        CallFrame& frame = frames.back();
+        size_t argsStart = static_cast<size_t>(sp - stack.data()) - argc;
+        ensureStack(frame.base, callee->numLocals + callee->maxStack);
+        std::memmove(stack.data() + frame.base, stack.data() + argsStart, argc * sizeof(double));
+        sp = stack.data() + frame.base + argc;
+        for (size_t slot = argc; slot < callee->numLocals; ++slot) {
+            *sp++ = undefinedSlot();
+        }
+        frame.proto = callee;
+        proto = callee;
+        ip = callee->code.data();
+        slots = stack.data() + frame.base;
+        VM_NEXT();
+    }
+    VM_CASE(RETURN) {
+        double result = *--sp;
+        size_t base = frames.back().base;
+        frames.pop_back();
+        if (frames.empty()) {
+            // Only the RETURN the compiler appends ends the code; any other is a return statement
+            topLevelReturn = ip != proto->code.data() + proto->code.size();
+            return result;
+        }
+        sp = stack.data() + base;
+        *sp++ = result;
+        const CallFrame& caller = frames.back();
+        proto = caller.proto;
+        ip = caller.ip;
+        slots = stack.data() + caller.base;
+        VM_NEXT();
+    }
+    VM_CASE(DEFINE_FUNCTION) {
+        READ_OPERAND(uint32_t, index);
+        READ_OPERAND(uint32_t, slot);
+        if (functions != &own.functions) {
+            // The first function a call defines gives this machine its own table
+            own.functions = *functions;
+            functions = &own.functions;
+        }
+        own.functions[slot] = (*protos)[index].get();
+        *sp++ = 0.0;
+        VM_NEXT();
+    }
+    VM_CASE(DEFINE_CLASS) {
+        READ_OPERAND(uint32_t, nameId);
+        own.classes.insert(nameId);
+        *sp++ = 0.0;
+        VM_NEXT();
+    }
+
+#ifndef VM_COMPUTED_GOTO
+    }
+    throw std::runtime_error("Unknown opcode");
+#endif
+
+#undef READ_OPERAND
+#undef BINARY_OP
+#undef VM_CASE
+#undef VM_NEXT
+}
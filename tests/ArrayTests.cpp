@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+
+namespace {
+
+// Allocates about 2 MB of short-lived arrays, enough to trigger collections
+const std::string CHURN = R"(
+    function churn(n) {
+        i = 0;
+        while (i < n) {
+            t = [i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i];
+            i = i + 1;
+        }
+        return 1;
+    }
+)";
+
+template <typename Backend>
+void expectError(const std::string& input, const std::string& message) {
+    Backend backend;
+    try {
+        interpretInput(input, backend);
+        ADD_FAILURE() << "Expected an error from: " << input;
+    } catch (const std::runtime_error& error) {
+        EXPECT_EQ(error.what(), message) << input;
+    }
+}
+
+} // namespace
+
+TYPED_TEST_SUITE(ArrayTest, ArrayBackends, BackendNames);
+
+TYPED_TEST(ArrayTest, LiteralsIndexingAndLength) {
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>("a = [1, 2, 3 + 4]; a[2] + len(a);"), 10.0);
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>("len([]);"), 0.0);
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>("i = 1; [10, 20, 30][i + 1];"), 30.0);
+}
+
+TYPED_TEST(ArrayTest, ArithmeticIsElementWise) {
+    TypeParam backend;
+    interpretInput(R"(
+        a = [1, 2, 3];
+        b = [4, 5, 6];
+        sums = a + b;
+        mixed = (a + b) * 2 - a / b ^ 1;
+        scaled = 12 / a - 1;
+        negated = -a % 2;
+    )", backend);
+    EXPECT_EQ(backend.getArrayValue("sums"), (std::vector<double>{5, 7, 9}));
+    EXPECT_EQ(backend.getArrayValue("mixed"), (std::vector<double>{10 - 0.25, 14 - 0.4, 18 - 0.5}));
+    EXPECT_EQ(backend.getArrayValue("scaled"), (std::vector<double>{11, 5, 3}));
+    EXPECT_EQ(backend.getArrayValue("negated"), (std::vector<double>{-1, 0, -1}));
+    // Operations make new arrays
+    EXPECT_EQ(backend.getArrayValue("a"), (std::vector<double>{1, 2, 3}));
+}
+
+TYPED_TEST(ArrayTest, ReductionsCoverEveryElement) {
+    // Lengths that leave a tail after the vectorized part
+    for (size_t n : {1u, 7u, 8u, 37u, 1000u}) {
+        std::vector<double> xs(n);
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = static_cast<double>((i * 7) % 11);
+        }
+        xs[n - 1] = -3.0;
+        double sum = 0.0;
+        double squares = 0.0;
+        for (double x : xs) {
+            sum += x;
+            squares += x * x;
+        }
+
+        TypeParam backend;
+        backend.setArray("xs", xs);
+        EXPECT_DOUBLE_EQ(interpretInput("sum(xs);", backend), sum) << n;
+        EXPECT_DOUBLE_EQ(interpretInput("dot(xs, xs);", backend), squares) << n;
+        EXPECT_DOUBLE_EQ(interpretInput("min(xs);", backend), -3.0) << n;
+        EXPECT_DOUBLE_EQ(interpretInput("max(xs + 1);", backend), n > 1 ? 11.0 : -2.0) << n;
+    }
+}
+
+TYPED_TEST(ArrayTest, FunctionsShareTheArraysTheyAreGiven) {
+    TypeParam backend;
+    backend.setArray("xs", std::vector<double>(1000, 2.0));
+    std::string input = R"(
+        function total(a, n) {
+            if (n == 0) {
+                return sum(a);
+            }
+            return total(a, n - 1) + a[n];
+        }
+        total(xs, 100);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput(input, backend), 2200.0);
+    // No call copied the array
+    EXPECT_EQ(backend.getArrayCount(), 1u);
+}
+
+TYPED_TEST(ArrayTest, FunctionsReturnArrays) {
+    std::string input = R"(
+        function pair(n) { return [n, n + 1]; }
+        function total(n) { return sum(pair(n)) + n; }
+        total(1) + total(2);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 3.0 + 1.0 + 5.0 + 2.0);
+}
+
+TYPED_TEST(ArrayTest, UnreachableArraysAreCollected) {
+    TypeParam backend;
+    EXPECT_DOUBLE_EQ(interpretInput(CHURN + "kept = [1, 2]; churn(20000);", backend), 1.0);
+    EXPECT_LT(backend.getArrayCount(), 20000u);
+    EXPECT_EQ(backend.getArrayValue("kept"), (std::vector<double>{1, 2}));
+}
+
+TYPED_TEST(ArrayTest, ArraysInFlightSurviveCollections) {
+    TypeParam backend;
+    interpretInput(CHURN + R"(
+        function add(a, b) { return a + b; }
+        left = [1, 2, 3] + churn(20000);
+        args = add([1, 2], [churn(20000), churn(20000)]);
+        indexed = [5, 6, 7][churn(20000)];
+    )", backend);
+    EXPECT_EQ(backend.getArrayValue("left"), (std::vector<double>{2, 3, 4}));
+    EXPECT_EQ(backend.getArrayValue("args"), (std::vector<double>{2, 3}));
+    EXPECT_DOUBLE_EQ(backend.getVariableValue("indexed"), 6.0);
+}
+
+TYPED_TEST(ArrayTest, UserFunctionsTakeThePlaceOfBuiltins) {
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>("function sum(a) { return 42; } sum([1, 2]);"), 42.0);
+}
+
+TYPED_TEST(ArrayTest, ReportsErrors) {
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {"[1, 2] + [1, 2, 3];", "Array lengths differ"},
+        {"dot([1], [1, 2]);", "Array lengths differ"},
+        {"[1, 2][2];", "Array index out of range"},
+        {"[1, 2][-1];", "Array index out of range"},
+        {"[1, 2][0.5];", "Array index out of range"},
+        {"[1, 2] / [1, 0];", "Division by zero"},
+        {"[1, 2] / 0;", "Division by zero"},
+        {"if ([1] < 2) { 1; }", "Operator not supported on arrays"},
+        {"[[1]];", "Array elements must be numbers"},
+        {"x = 3; x[0];", "Not an array"},
+        {"len(3);", "Not an array"},
+        {"min([]);", "min of an empty array"},
+        {"dot([1]);", "Incorrect number of arguments in function call: dot"},
+    };
+    for (const auto& [input, message] : cases) {
+        expectError<TypeParam>(input, message);
+    }
+}
+
+TEST(ArrayMemoTest, ArrayArgumentsAndResultsAreNotCached) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    std::string input = R"(
+        function total(a) { return sum(a); }
+        function pair(n) { return [n, n]; }
+        total([1, 2]) + total([3, 4]) + sum(pair(1) + pair(1));
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput(input, interpreter), 14.0);
+    EXPECT_EQ(interpreter.getMemoStats().entries, 0u);
+}
+
+TEST(ArrayBackendTest, OtherBackendsRejectArrays) {
+    expectError<VirtualMachine>("[1, 2];", "Arrays are not supported by the virtual machine");
+    expectError<ClosureCompiler>("a = 1; a[0];", "Arrays are not supported by the closure compiler");
+}
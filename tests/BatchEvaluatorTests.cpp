@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "../include/batchevaluator.h"
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+
+namespace {
+
+const std::string PROGRAM = R"(
+    scale = 2.5;
+    function score(x, y) {
+        d = x - y;
+        if (d < 0) {
+            d = -d;
+        }
+        if (x > 40) {
+            return d * scale;
+        } else {
+            if (y == 3) {
+                return 0 - x;
+            }
+        }
+        r = d % 7 + x ^ 2 / (y + 1000);
+        if (r >= 100) {
+            r = r / 3;
+        } else {
+            r = r + scale;
+        }
+        r;
+    }
+    function ratio(x, y) { return x / y; }
+    function twice(x) { return x * 2; }
+    function viaCall(x, y) { return twice(x) + y; }
+    function maybe(x, y) {
+        if (x > 0) {
+            m = x;
+        }
+        return m + y;
+    }
+    function usesLater(x, y) { return x + later; }
+    function steps(x, y) {
+        n = 0;
+        while (x > y) {
+            x = x - 10;
+            n = n + 1;
+        }
+        return n;
+    }
+)";
+
+class BatchEvaluatorTest : public ::testing::Test {
+protected:
+    ASTPtr tree = parseInput(PROGRAM);
+    Interpreter interpreter;
+    // Not a multiple of the block size, so the last block is partial
+    static constexpr size_t ROWS = 2 * BatchEvaluator::BLOCK_SIZE + 37;
+    std::vector<double> xs;
+    std::vector<double> ys;
+
+    void SetUp() override {
+        interpreter.interpret(tree);
+        for (size_t i = 0; i < ROWS; ++i) {
+            xs.push_back(static_cast<double>(i % 97) - 30.5);
+            ys.push_back(static_cast<double>(i % 11) - 2.0);
+        }
+    }
+
+    std::vector<double> perRow(const std::string& function) {
+        std::vector<double> results;
+        for (size_t i = 0; i < ROWS; ++i) {
+            results.push_back(interpreter.call(function, {xs[i], ys[i]}));
+        }
+        return results;
+    }
+};
+
+} // namespace
+
+TEST_F(BatchEvaluatorTest, MatchesPerRowCallsBitForBit) {
+    std::vector<double> out(ROWS);
+    EXPECT_TRUE(interpreter.evaluateBatch("score", {xs.data(), ys.data()}, ROWS, out.data()));
+    std::vector<double> expected = perRow("score");
+    EXPECT_EQ(std::memcmp(out.data(), expected.data(), ROWS * sizeof(double)), 0);
+}
+
+TEST_F(BatchEvaluatorTest, FallsBackToPerRowCalls) {
+    std::vector<double> out(ROWS);
+    // A call, and a local that may still be unassigned when read
+    EXPECT_FALSE(interpreter.evaluateBatch("viaCall", {xs.data(), ys.data()}, ROWS, out.data()));
+    EXPECT_EQ(out, perRow("viaCall"));
+
+    interpretInput("m = 100;", interpreter);
+    EXPECT_FALSE(interpreter.evaluateBatch("maybe", {xs.data(), ys.data()}, ROWS, out.data()));
+    EXPECT_EQ(out, perRow("maybe"));
+    EXPECT_DOUBLE_EQ(out[0], 100 + ys[0]);
+
+    // Loops run row by row
+    EXPECT_FALSE(interpreter.evaluateBatch("steps", {xs.data(), ys.data()}, ROWS, out.data()));
+    EXPECT_EQ(out, perRow("steps"));
+}
+
+TEST_F(BatchEvaluatorTest, ReadsGlobalsWhenTheBatchRuns) {
+    std::vector<double> out(ROWS);
+    EXPECT_THROW(interpreter.evaluateBatch("usesLater", {xs.data(), ys.data()}, ROWS, out.data()),
+                 std::runtime_error);
+
+    interpretInput("later = 4;", interpreter);
+    EXPECT_TRUE(interpreter.evaluateBatch("usesLater", {xs.data(), ys.data()}, ROWS, out.data()));
+    EXPECT_DOUBLE_EQ(out[ROWS - 1], xs[ROWS - 1] + 4);
+}
+
+TEST_F(BatchEvaluatorTest, ReportsErrors) {
+    std::vector<double> out(ROWS);
+    EXPECT_THROW(interpreter.evaluateBatch("ratio", {xs.data(), ys.data()}, ROWS, out.data()), std::runtime_error);
+    EXPECT_THROW(interpreter.evaluateBatch("missing", {xs.data()}, ROWS, out.data()), std::runtime_error);
+    EXPECT_THROW(interpreter.evaluateBatch("ratio", {xs.data()}, ROWS, out.data()), std::runtime_error);
+
+    // Rows that never divide by zero are fine
+    std::vector<double> ones(ROWS, 1.0);
+    EXPECT_TRUE(interpreter.evaluateBatch("ratio", {xs.data(), ones.data()}, ROWS, out.data()));
+    EXPECT_EQ(out, xs);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "../include/batchrunner.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<std::pair<std::string, std::string>> fibScripts(int count) {
+    std::vector<std::pair<std::string, std::string>> scripts;
+    for (int i = 0; i < count; ++i) {
+        scripts.emplace_back("script" + std::to_string(i),
+                             "function fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); } "
+                             "fib(" + std::to_string(i % 15) + ");");
+    }
+    return scripts;
+}
+
+double fib(int n) {
+    return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+} // namespace
+
+TEST(BatchRunnerTest, ReturnsResultsInInputOrder) {
+    BatchRunner runner(4);
+    std::vector<BatchResult> results = runner.runSources(fibScripts(200));
+    ASSERT_EQ(results.size(), 200u);
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(results[i].script, "script" + std::to_string(i));
+        EXPECT_TRUE(results[i].succeeded()) << results[i].error;
+        EXPECT_DOUBLE_EQ(results[i].value, fib(i % 15));
+    }
+}
+
+TEST(BatchRunnerTest, ScriptsDoNotShareState) {
+    BatchRunner runner(2);
+    std::vector<BatchResult> results = runner.runSources({
+        {"defines", "shared = 5; function f() { return 1; } shared;"},
+        {"reads", "shared;"},
+        {"calls", "f();"},
+    });
+    EXPECT_DOUBLE_EQ(results[0].value, 5.0);
+    EXPECT_EQ(results[1].error, "Undefined variable: shared");
+    EXPECT_EQ(results[2].error, "Undefined function: f");
+}
+
+TEST(BatchRunnerTest, ReportsErrorsPerScript) {
+    BatchRunner runner(3);
+    std::vector<BatchResult> results = runner.runSources({
+        {"ok", "1 + 2;"},
+        {"syntax", "a = ;"},
+        {"runtime", "x = 1; x / 0;"},
+    });
+    EXPECT_TRUE(results[0].succeeded());
+    EXPECT_DOUBLE_EQ(results[0].value, 3.0);
+    EXPECT_FALSE(results[1].succeeded());
+    EXPECT_EQ(results[2].error, "Division by zero");
+}
+
+TEST(BatchRunnerTest, ListsDirectoriesAndManifests) {
+    fs::path directory = fs::temp_directory_path() / "batchrunner_test_scripts";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    std::ofstream(directory / "b.txt") << "2 * 21;";
+    std::ofstream(directory / "a.txt") << "1 + 1;";
+    std::ofstream(directory / "c.txt") << "missing;";
+
+    std::vector<std::string> listed = BatchRunner::listScripts(directory.string());
+    ASSERT_EQ(listed.size(), 3u);
+    EXPECT_EQ(fs::path(listed[0]).filename(), "a.txt");
+    EXPECT_EQ(fs::path(listed[2]).filename(), "c.txt");
+
+    fs::path manifest = directory / "manifest";
+    std::ofstream(manifest) << "b.txt\n\nc.txt\r\nnot_there.txt\n";
+    std::vector<std::string> scripts = BatchRunner::listScripts(manifest.string());
+    ASSERT_EQ(scripts.size(), 3u);
+    EXPECT_EQ(fs::path(scripts[0]), directory / "b.txt");
+
+    std::vector<BatchResult> results = BatchRunner(2).runFiles(scripts);
+    std::ostringstream out;
+    BatchRunner::writeResults(out, results);
+    std::string expected = scripts[0] + "\t42\t\n" +
+                           scripts[1] + "\t\tUndefined variable: missing\n" +
+                           scripts[2] + "\t\tCould not open file " + scripts[2] + "\n";
+    EXPECT_EQ(out.str(), expected);
+    fs::remove_all(directory);
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "../include/closurecompiler.h"
+#include "TestUtils.h"
+
+TEST(ClosureCompilerTest, FunctionsOutliveTheirTree) {
+    ClosureCompiler backend;
+    // interpretInput frees each tree once it has run
+    interpretInput("function scale(x) { return x * factor; } factor = 3;", backend);
+    interpretInput("function twice(x) { return scale(x) + scale(x); }", backend);
+    EXPECT_DOUBLE_EQ(interpretInput("twice(7);", backend), 42.0);
+}
+
+TEST(ClosureCompilerTest, RecoversAfterErrors) {
+    ClosureCompiler backend;
+    interpretInput("function down(n) { if (n == 0) { return 1 / n; } return down(n - 1) + 1; }", backend);
+    EXPECT_THROW(interpretInput("down(5);", backend), std::runtime_error);
+    EXPECT_THROW(interpretInput("down(2000);", backend), std::runtime_error);
+    interpretInput("function down(n) { if (n == 0) { return 0; } return down(n - 1) + 1; }", backend);
+    EXPECT_DOUBLE_EQ(interpretInput("down(5);", backend), 5.0);
+}
+
+TEST(ClosureCompilerTest, ConditionsWithAConstantOnEitherSide) {
+    ClosureCompiler backend;
+    interpretInput(R"(
+        function sides(n) {
+            count = 0;
+            if (3 < n) { count = count + 1; }
+            if (3 <= n) { count = count + 1; }
+            if (3 > n) { count = count + 1; }
+            if (3 >= n) { count = count + 1; }
+            if (3 == n) { count = count + 1; }
+            if (3 != n) { count = count + 1; }
+            if (n < 3) { count = count + 10; }
+            return count;
+        }
+    )", backend);
+    EXPECT_DOUBLE_EQ(interpretInput("sides(4);", backend), 3.0);
+    EXPECT_DOUBLE_EQ(interpretInput("sides(3);", backend), 3.0);
+    EXPECT_DOUBLE_EQ(interpretInput("sides(2);", backend), 13.0);
+}
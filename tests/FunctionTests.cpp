@@ -4,18 +4,20 @@
 #include "../include/interpreter.h"
 #include "TestUtils.h"
 
-TEST(FunctionTest, DefinesAndCallsFunction) {
+TYPED_TEST_SUITE(FunctionTest, Backends, BackendNames);
+
+TYPED_TEST(FunctionTest, DefinesAndCallsFunction) {
     std::string input = R"(
         function add(a, b) {
             return a + b;
         }
         result = add(5, 3);
     )";
-    double result = interpretInput(input);
+    double result = interpretInput<TypeParam>(input);
     EXPECT_DOUBLE_EQ(result, 8.0);
 }
 
-TEST(FunctionTest, HandlesRecursion) {
+TYPED_TEST(FunctionTest, HandlesRecursion) {
     std::string input = R"(
         function factorial(n) {
             if (n == 0) {
@@ -26,10 +28,35 @@ TEST(FunctionTest, HandlesRecursion) {
         }
         result = factorial(5);
     )";
-    double result = interpretInput(input);
+    double result = interpretInput<TypeParam>(input);
     EXPECT_DOUBLE_EQ(result, 120.0);
 }
 
+TYPED_TEST(FunctionTest, ReturnSkipsRemainingStatements) {
+    std::string input = R"(
+        function classify(n) {
+            if (n < 0) {
+                if (n < -10) {
+                    return -2;
+                }
+                return -1;
+            }
+            n = n + 100;
+            return n;
+        }
+        classify(-20) * 1000 + classify(-5) * 100 + classify(1);
+    )";
+    double result = interpretInput<TypeParam>(input);
+    EXPECT_DOUBLE_EQ(result, -2000.0 - 100.0 + 101.0);
+}
+
+TYPED_TEST(FunctionTest, TopLevelReturnEndsProgram) {
+    TypeParam interpreter;
+    double result = interpretInput("a = 1; return a + 1; a = 5;", interpreter);
+    EXPECT_DOUBLE_EQ(result, 2.0);
+    EXPECT_DOUBLE_EQ(interpreter.getVariableValue("a"), 1.0);
+}
+
 /*
 TEST(FunctionTest, HandlesFunctionRedefinitionWithSameParameters) {
     std::string input = R"(
@@ -72,4 +99,108 @@ TEST(FunctionTest, HandlesNestedFunctionDefinitions) {
     }, std::runtime_error);
 }
 
-}*/
\ No newline at end of file
+}*/
+TYPED_TEST(FunctionTest, TailRecursionRunsInConstantDepth) {
+    std::string input = R"(
+        function loop(n, acc) {
+            if (n == 0) {
+                return acc;
+            }
+            return loop(n - 1, acc + 2);
+        }
+        loop(10000000, 0);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 20000000.0);
+}
+
+TYPED_TEST(FunctionTest, MutualTailRecursionRunsInConstantDepth) {
+    std::string input = R"(
+        function isEven(n) {
+            if (n == 0) {
+                return 1;
+            }
+            return isOdd(n - 1);
+        }
+        function isOdd(n) {
+            if (n == 0) {
+                return 0;
+            }
+            return isEven(n - 1);
+        }
+        isEven(100001);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 0.0);
+}
+
+TYPED_TEST(FunctionTest, TailCallsGetAFreshFrame) {
+    std::string input = R"(
+        x = 42;
+        function step(n) {
+            if (n > 0) {
+                x = n;
+                return finish(n - 1, 0, 0);
+            }
+            return x;
+        }
+        function finish(a, b, c) {
+            return step(a);
+        }
+        step(3);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 42.0);
+}
+
+TYPED_TEST(FunctionTest, TailCallsCheckTheirArguments) {
+    std::string input = R"(
+        function f(n) {
+            return g(n, n);
+        }
+        function g(n) {
+            return n;
+        }
+        f(1);
+    )";
+    EXPECT_THROW(interpretInput<TypeParam>(input), std::runtime_error);
+}
+
+TYPED_TEST(FunctionTest, CallSitesSeeRedefinitions) {
+    std::string input = R"(
+        function f(x) { return x + 1; }
+        function caller(x) { return f(x) * 10; }
+        a = caller(1);
+        a = caller(a);
+        function f(x) { return x + 2; }
+        a + caller(1);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 240.0);
+}
+
+TYPED_TEST(FunctionTest, CallSitesRecheckArityAfterRedefinition) {
+    std::string input = R"(
+        function f(x) { return x + 1; }
+        function caller(x) { return f(x) * 10; }
+        a = caller(1);
+        function f(x, y) { return x + y; }
+        caller(1);
+    )";
+    EXPECT_THROW(interpretInput<TypeParam>(input), std::runtime_error);
+}
+
+TYPED_TEST(FunctionTest, LocalsSurviveDeepCallStacks) {
+    // Deep enough to outgrow the initial frame stack while callers' frames are live
+    std::string input = R"(
+        function sum(n) {
+            a = n;
+            b = n * 2;
+            c = n * 3;
+            d = n * 4;
+            if (n == 0) {
+                return 0;
+            }
+            rest = sum(n - 1);
+            return rest + a + b + c + d - 9 * n;
+        }
+        sum(800);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 800.0 * 801.0 / 2.0);
+}
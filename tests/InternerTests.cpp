@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "../include/interner.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(InternerTest, ReturnsTheSameSymbolForEqualText) {
+    std::string first = "interner_test_name";
+    std::string second = "interner_test_name";
+    Symbol symbol = intern(first);
+    EXPECT_EQ(intern(second), symbol);
+    EXPECT_NE(intern("interner_test_other"), symbol);
+    EXPECT_EQ(symbolName(symbol), "interner_test_name");
+}
+
+TEST(InternerTest, FindDoesNotIntern) {
+    size_t before = Interner::global().size();
+    EXPECT_EQ(Interner::global().find("interner_test_never_seen"), NO_SYMBOL);
+    EXPECT_EQ(Interner::global().size(), before);
+}
+
+TEST(InternerTest, NamesOutliveTheSourceText) {
+    std::string_view name;
+    {
+        std::string temporary = "interner_test_temporary";
+        name = symbolName(intern(temporary));
+    }
+    EXPECT_EQ(name, "interner_test_temporary");
+}
+
+TEST(InternerTest, ConcurrentInterningAgreesOnSymbols) {
+    const int threadCount = 4;
+    const int nameCount = 2000;
+    std::vector<std::vector<Symbol>> results(threadCount, std::vector<Symbol>(nameCount));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&results, t] {
+            for (int i = 0; i < nameCount; ++i) {
+                results[t][i] = intern("interner_test_concurrent_" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 1; t < threadCount; ++t) {
+        EXPECT_EQ(results[t], results[0]);
+    }
+    EXPECT_EQ(symbolName(results[0][42]), "interner_test_concurrent_42");
+}
+
+TEST(InternerTest, ThreadsSeeNamesInternedByOtherThreads) {
+    Symbol symbol = intern("interner_test_from_main_thread");
+    std::string_view seen;
+    Symbol found = NO_SYMBOL;
+    std::thread worker([&] {
+        seen = symbolName(symbol);
+        found = intern("interner_test_from_main_thread");
+    });
+    worker.join();
+    EXPECT_EQ(seen, "interner_test_from_main_thread");
+    EXPECT_EQ(found, symbol);
+}
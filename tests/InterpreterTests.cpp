@@ -6,45 +6,48 @@
 #include <cmath>
 #include "TestUtils.h"
 
-TEST(InterpreterTest, EvaluatesSimpleAddition) {
-    Interpreter interpreter;
+TYPED_TEST_SUITE(InterpreterTest, Backends, BackendNames);
+TYPED_TEST_SUITE(FunctionTest, Backends, BackendNames);
+
+TYPED_TEST(InterpreterTest, EvaluatesSimpleAddition) {
+    TypeParam interpreter;
     double result = interpretInput("3 + 5;", interpreter);
     EXPECT_EQ(result, 8);
 }
 
-TEST(InterpreterTest, EvaluatesVariableAssignmentAndUsage) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, EvaluatesVariableAssignmentAndUsage) {
+    TypeParam interpreter;
     interpretInput("a = 5;", interpreter);
     double result = interpretInput("a + 2;", interpreter);
     EXPECT_EQ(result, 7);
 }
 
-TEST(InterpreterTest, EvaluatesOperatorPrecedence) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, EvaluatesOperatorPrecedence) {
+    TypeParam interpreter;
     double result = interpretInput("3 + 5 * 2;", interpreter);
     EXPECT_EQ(result, 13);
 }
 
-TEST(InterpreterTest, EvaluatesParentheses) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, EvaluatesParentheses) {
+    TypeParam interpreter;
     double result = interpretInput("(3 + 5) * 2;", interpreter);
     EXPECT_EQ(result, 16);
 }
 
-TEST(InterpreterTest, EvaluatesFloatingPointNumbers) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, EvaluatesFloatingPointNumbers) {
+    TypeParam interpreter;
     double result = interpretInput("3.5 + 2.5;", interpreter);
     EXPECT_DOUBLE_EQ(result, 6.0);
 }
 
-TEST(InterpreterTest, HandlesCompoundStatements) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, HandlesCompoundStatements) {
+    TypeParam interpreter;
     double result = interpretInput("a = 5; b = a * 2; b + 3;", interpreter);
     EXPECT_EQ(result, 13);
 }
 
-TEST(InterpreterTest, HandlesUnaryOperations) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, HandlesUnaryOperations) {
+    TypeParam interpreter;
     double result1 = interpretInput("-5 + 3;", interpreter);
     EXPECT_EQ(result1, -2);
 
@@ -52,43 +55,49 @@ TEST(InterpreterTest, HandlesUnaryOperations) {
     EXPECT_EQ(result2, 3);
 }
 
-TEST(InterpreterTest, ThrowsOnUndefinedVariable) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, ThrowsOnUndefinedVariable) {
+    TypeParam interpreter;
     ASSERT_THROW(interpretInput("a + 2;", interpreter), std::runtime_error);
 }
 
-TEST(InterpreterTest, ThrowsOnDivisionByZero) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, UndefinedVariableOnAPathThatNeverRuns) {
+    TypeParam interpreter;
+    EXPECT_DOUBLE_EQ(interpretInput("a = 1; if (a == 2) { b = zz; } a = 3;", interpreter), 3.0);
+    EXPECT_DOUBLE_EQ(interpreter.getVariableValue("a"), 3.0);
+}
+
+TYPED_TEST(InterpreterTest, ThrowsOnDivisionByZero) {
+    TypeParam interpreter;
     ASSERT_THROW(interpretInput("5 / 0;", interpreter), std::runtime_error);
 }
 
-TEST(InterpreterTest, EvaluatesModulusOperator) {
+TYPED_TEST(InterpreterTest, EvaluatesModulusOperator) {
     std::string input = "result = 10 % 3;";
-    double result = interpretInput(input);
+    double result = interpretInput<TypeParam>(input);
     EXPECT_DOUBLE_EQ(result, 1.0);
 }
 
-TEST(InterpreterTest, EvaluatesMultipleAssignments) {
-    Interpreter interpreter;
+TYPED_TEST(InterpreterTest, EvaluatesMultipleAssignments) {
+    TypeParam interpreter;
     double result = interpretInput("x = 10; y = x + 5; z = y * 2; z;", interpreter);
     EXPECT_EQ(result, 30);
 }
 
-TEST(InterpreterTest, HandlesDivisionByZero) {
+TYPED_TEST(InterpreterTest, HandlesDivisionByZero) {
     std::string input = "result = 10 / 0;";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     EXPECT_THROW(interpreter.interpret(tree), std::runtime_error);
 }
 
-TEST(InterpreterTest, HandlesUndefinedVariables) {
+TYPED_TEST(InterpreterTest, HandlesUndefinedVariables) {
     std::string input = "result = a + 5;";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     EXPECT_THROW(interpreter.interpret(tree), std::runtime_error);
 }
 /*
@@ -109,7 +118,7 @@ TEST(InterpreterTest, HandlesFunctionRedefinition) {
 }
 */
 
-TEST(FunctionTest, HandlesMutualRecursion) {
+TYPED_TEST(FunctionTest, HandlesMutualRecursion) {
     std::string input = R"(
         function isEven(n) {
             if (n == 0) {
@@ -130,30 +139,30 @@ TEST(FunctionTest, HandlesMutualRecursion) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result"), 1.0);
 }
 
-TEST(InterpreterTest, DetectsInfiniteRecursion) {
+TYPED_TEST(InterpreterTest, DetectsInfiniteRecursion) {
     std::string input = R"(
         function infinite() {
-            return infinite();
+            return 1 + infinite();
         }
         result = infinite();
     )";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     // Depending on your interpreter, this might cause a stack overflow
     // You may need to implement recursion depth limits
 
     EXPECT_THROW(interpreter.interpret(tree), std::runtime_error);
 }
 
-TEST(InterpreterTest, EvaluatesBasicArithmetic) {
+TYPED_TEST(InterpreterTest, EvaluatesBasicArithmetic) {
     std::string input = R"(
         result1 = 1 + 2 - 3;
         result2 = 4 * 5 / 2;
@@ -162,7 +171,7 @@ TEST(InterpreterTest, EvaluatesBasicArithmetic) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result1"), 0.0);
@@ -170,12 +179,12 @@ TEST(InterpreterTest, EvaluatesBasicArithmetic) {
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result3"), 3.0);
 }
 
-TEST(InterpreterTest, EvaluatesPowerOperator) {
+TYPED_TEST(InterpreterTest, EvaluatesPowerOperator) {
     std::string input = "result = 2 ^ 3;";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result"), 8.0);
@@ -208,7 +217,7 @@ TEST(InterpreterTest, HandlesMultipleAssignments) {
 }
 */
 
-TEST(InterpreterTest, HandlesVariableScope) {
+TYPED_TEST(InterpreterTest, HandlesVariableScope) {
     std::string input = R"(
         a = 10;
         function testScope() {
@@ -221,14 +230,14 @@ TEST(InterpreterTest, HandlesVariableScope) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result1"), 5.0);
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result2"), 10.0);  // If variables are local to functions
 }
 
-TEST(InterpreterTest, EvaluatesChainedFunctionCalls) {
+TYPED_TEST(InterpreterTest, EvaluatesChainedFunctionCalls) {
     std::string input = R"(
         function increment(n) {
             return n + 1;
@@ -241,7 +250,7 @@ TEST(InterpreterTest, EvaluatesChainedFunctionCalls) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result"), 12.0);
@@ -279,7 +288,7 @@ TEST(InterpreterTest, HandlesFunctionWithZeroAndNegativeInputs) {
 }
 */
 
-TEST(InterpreterTest, HandlesRecursiveFunctionEdgeCases) {
+TYPED_TEST(InterpreterTest, HandlesRecursiveFunctionEdgeCases) {
     std::string input = R"(
         function fibonacci(n) {
             if (n <= 1) {
@@ -293,13 +302,13 @@ TEST(InterpreterTest, HandlesRecursiveFunctionEdgeCases) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result"), 55.0);
 }
 
-TEST(InterpreterTest, EvaluatesComplexExpressionsWithFunctions) {
+TYPED_TEST(InterpreterTest, EvaluatesComplexExpressionsWithFunctions) {
     std::string input = R"(
         function complexCalc(a, b, c) {
             return (a ^ b) / (c - a) + (b % c) * a;
@@ -309,46 +318,46 @@ TEST(InterpreterTest, EvaluatesComplexExpressionsWithFunctions) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     double expectedResult = (std::pow(2, 3) / (5 - 2)) + ((3 % 5) * 2);
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result"), expectedResult);
 }
 
-TEST(InterpreterTest, EvaluatesNegativeExponents) {
+TYPED_TEST(InterpreterTest, EvaluatesNegativeExponents) {
     std::string input = "result = 2 ^ -2;";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_NEAR(interpreter.getVariableValue("result"), 0.25, 1e-6);
 }
 
-TEST(InterpreterTest, EvaluatesLargeNumbers) {
+TYPED_TEST(InterpreterTest, EvaluatesLargeNumbers) {
     std::string input = R"(
         result = 9999999999 * 8888888888;
     )";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     double expectedResult = 9999999999.0 * 8888888888.0;
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result"), expectedResult);
 }
 
-TEST(InterpreterTest, HandlesFloatingPointPrecision) {
+TYPED_TEST(InterpreterTest, HandlesFloatingPointPrecision) {
     std::string input = R"(
         result = 0.1 + 0.2;
     )";
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     // Due to floating point precision, the result might not be exactly 0.3
@@ -372,7 +381,7 @@ TEST(InterpreterTest, EvaluatesAssociativity) {
 }
 */
 
-TEST(InterpreterTest, EvaluatesModulusWithNegativeNumbers) {
+TYPED_TEST(InterpreterTest, EvaluatesModulusWithNegativeNumbers) {
     std::string input = R"(
         result1 = -10 % 3;
         result2 = 10 % -3;
@@ -381,7 +390,7 @@ TEST(InterpreterTest, EvaluatesModulusWithNegativeNumbers) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result1"), -1.0);
@@ -389,7 +398,7 @@ TEST(InterpreterTest, EvaluatesModulusWithNegativeNumbers) {
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result3"), -1.0);
 }
 
-TEST(InterpreterTest, EvaluatesPowerOperatorEdgeCases) {
+TYPED_TEST(InterpreterTest, EvaluatesPowerOperatorEdgeCases) {
     std::string input = R"(
         result1 = 2 ^ 0;
         result2 = 0 ^ 0;
@@ -399,7 +408,7 @@ TEST(InterpreterTest, EvaluatesPowerOperatorEdgeCases) {
     Lexer lexer(input);
     Parser parser(lexer);
     ASTPtr tree = parser.parse();
-    Interpreter interpreter;
+    TypeParam interpreter;
     interpreter.interpret(tree);
 
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result1"), 1.0);
@@ -409,3 +418,16 @@ TEST(InterpreterTest, EvaluatesPowerOperatorEdgeCases) {
     EXPECT_DOUBLE_EQ(interpreter.getVariableValue("result3"), -8.0);
     EXPECT_NEAR(interpreter.getVariableValue("result4"), 0.125, 1e-6);
 }
+
+TEST(InterpreterTest, CallSiteCachesAreNotSharedBetweenInterpreters) {
+    ASTPtr first = parseInput("function f() { return 1; }");
+    ASTPtr second = parseInput("function f() { return 2; }");
+    ASTPtr call = parseInput("f();");
+    Interpreter one;
+    Interpreter two;
+    one.interpret(first);
+    two.interpret(second);
+    EXPECT_DOUBLE_EQ(one.interpret(call), 1.0);
+    EXPECT_DOUBLE_EQ(two.interpret(call), 2.0);
+    EXPECT_DOUBLE_EQ(one.interpret(call), 1.0);
+}
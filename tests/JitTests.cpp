@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "../include/interpreter.h"
+#include "../include/jit.h"
+#include "TestUtils.h"
+#include <cstring>
+#include <stdexcept>
+
+class JitTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!Jit::isSupported()) {
+            GTEST_SKIP() << "No native code generator for this target";
+        }
+    }
+};
+
+TEST_F(JitTest, CompilesFunctionsOnceTheyAreHot) {
+    Interpreter interpreter;
+    interpreter.enableJit(3);
+    double result = interpretInput(R"(
+        function sq(x) { return x * x; }
+        a = sq(2);
+        b = sq(3);
+        c = sq(4);
+        a + b + c;
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 29.0);
+    EXPECT_EQ(interpreter.getJitCompiledCount(), 1u);
+}
+
+TEST_F(JitTest, ResultsAreBitIdenticalToTheInterpreter) {
+    std::string input = R"(
+        function f(a, b) {
+            c = a / b + a % b - b ^ 0.5;
+            if (c >= a) {
+                c = -c * 3;
+            } else {
+                c = +c / 7;
+            }
+            return c + a * 0.1;
+        }
+        f(1, 3) + f(10, 7) * f(0.3, 0.7) - f(2 ^ 52, 3);
+    )";
+    double expected = interpretInput<Interpreter>(input);
+    JitInterpreter interpreter;
+    double actual = interpretInput(input, interpreter);
+    EXPECT_EQ(std::memcmp(&expected, &actual, sizeof(double)), 0) << expected << " vs " << actual;
+    EXPECT_EQ(interpreter.getJitCompiledCount(), 1u);
+}
+
+TEST_F(JitTest, SelfTailCallsBecomeLoops) {
+    JitInterpreter interpreter;
+    double result = interpretInput(R"(
+        function sum(n, total) {
+            if (n == 0) {
+                return total;
+            }
+            return sum(n - 1, total + n);
+        }
+        sum(100000, 0);
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 5000050000.0);
+    EXPECT_EQ(interpreter.getJitCompiledCount(), 1u);
+}
+
+TEST_F(JitTest, CompilesLoops) {
+    JitInterpreter interpreter;
+    double result = interpretInput(R"(
+        function sumTo(n) {
+            total = 0;
+            for (i = 1; i <= n; i = i + 1) {
+                if (i % 1000 == 0) {
+                    total = total - 1;
+                }
+                total = total + i;
+            }
+            return total;
+        }
+        sumTo(100000);
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 5000050000.0 - 100);
+    EXPECT_EQ(interpreter.getJitCompiledCount(), 1u);
+}
+
+TEST_F(JitTest, LeavesUnsupportedFunctionsInterpreted) {
+    JitInterpreter interpreter;
+    double result = interpretInput(R"(
+        scale = 10;
+        function scaled(x) { return x * scale; }
+        function maybe(x) {
+            if (x > 0) {
+                y = x;
+            }
+            return y;
+        }
+        function twice(x) { return scaled(x) * 2; }
+        y = 5;
+        twice(2) + maybe(0);
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 45.0);
+    // Only twice: scaled reads a global and maybe may read y before assigning it
+    EXPECT_EQ(interpreter.getJitCompiledCount(), 1u);
+}
+
+TEST_F(JitTest, ReportsErrorsFromNativeCode) {
+    std::string divide = "function div(a, b) { return a / b; } div(1, 2); div(1, 0);";
+    std::string arity = "function f(a) { return a; } function g() { return f(1, 2); } g();";
+    std::string depth = "function down(n) { return 1 + down(n - 1); } down(0);";
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {divide, "Division by zero"},
+        {arity, "Incorrect number of arguments in function call: f"},
+        {depth, "Maximum recursion depth exceeded in function: down"},
+    };
+    for (const auto& [input, message] : cases) {
+        JitInterpreter interpreter;
+        try {
+            interpretInput(input, interpreter);
+            ADD_FAILURE() << "Expected an error from: " << input;
+        } catch (const std::runtime_error& error) {
+            EXPECT_EQ(error.what(), message);
+        }
+    }
+}
+
+TEST_F(JitTest, PropagatesExceptionsFromInterpretedCallees) {
+    JitInterpreter interpreter;
+    try {
+        interpretInput(R"(
+            function inner(x) { return x + missing; }
+            function outer(x) { return inner(x) + 1; }
+            outer(1);
+        )", interpreter);
+        FAIL() << "Expected an undefined variable error";
+    } catch (const std::runtime_error& error) {
+        EXPECT_STREQ(error.what(), "Undefined variable: missing");
+    }
+    // The interpreter is usable again after the error
+    EXPECT_DOUBLE_EQ(interpretInput("function one() { return 1; } one();", interpreter), 1.0);
+}
+
+TEST_F(JitTest, RedefinitionReplacesCompiledCode) {
+    JitInterpreter interpreter;
+    double result = interpretInput(R"(
+        function f(x) { return x + 1; }
+        function g(x) { return f(x) * 10; }
+        a = g(1);
+        function f(x) { return x + 2; }
+        a + g(1);
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 50.0);
+}
+
+TEST_F(JitTest, IsIgnoredWhileMemoizing) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    interpreter.enableJit(1);
+    double result = interpretInput("function sq(x) { return x * x; } sq(3) + sq(3);", interpreter);
+    EXPECT_DOUBLE_EQ(result, 18.0);
+    EXPECT_EQ(interpreter.getJitCompiledCount(), 0u);
+    EXPECT_EQ(interpreter.getMemoStats().hits, 1u);
+}
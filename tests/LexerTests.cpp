@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "../include/lexer.h"
 #include "../include/token.h"
+#include "TestUtils.h"
+#include <sstream>
 
 TEST(LexerTest, RecognizesAllTokens) {
     std::string input = R"(
@@ -30,7 +32,7 @@ TEST(LexerTest, RecognizesAllTokens) {
         Token token = lexer.getNextToken();
         EXPECT_EQ(token.type, expectedType) << "Expected token type " << static_cast<int>(expectedType)
                                             << " but got " << static_cast<int>(token.type)
-                                            << " with value '" << token.value << "'";
+                                            << " with value '" << lexer.tokenText(token) << "'";
     }
 }
 
@@ -43,7 +45,7 @@ TEST(LexerTest, HandlesIdentifiers) {
     for (const auto& expectedValue : expectedValues) {
         Token token = lexer.getNextToken();
         EXPECT_EQ(token.type, TokenType::IDENTIFIER);
-        EXPECT_EQ(token.value, expectedValue);
+        EXPECT_EQ(lexer.tokenText(token), expectedValue);
     }
 }
 
@@ -51,7 +53,8 @@ TEST(LexerTest, HandlesNumbers) {
     std::string input = "0 00 0.0 .5 5. .123456789 1234567890";
     Lexer lexer(input);
 
-    std::vector<std::string> expectedValues = {"0", "00", "0.0", ".5", "5.", ".123456789", "1234567890"};
+    std::vector<std::string> expectedTexts = {"0", "00", "0.0", ".5", "5.", ".123456789", "1234567890"};
+    std::vector<double> expectedValues = {0.0, 0.0, 0.0, 0.5, 5.0, 0.123456789, 1234567890.0};
     std::vector<TokenType> expectedTypes = {
         TokenType::INTEGER, TokenType::INTEGER, TokenType::FLOAT,
         TokenType::FLOAT, TokenType::FLOAT, TokenType::FLOAT, TokenType::INTEGER
@@ -60,12 +63,13 @@ TEST(LexerTest, HandlesNumbers) {
     for (size_t i = 0; i < expectedValues.size(); ++i) {
         Token token = lexer.getNextToken();
         EXPECT_EQ(token.type, expectedTypes[i]);
-        EXPECT_EQ(token.value, expectedValues[i]);
+        EXPECT_EQ(lexer.tokenText(token), expectedTexts[i]);
+        EXPECT_EQ(token.number, expectedValues[i]);
     }
 }
 
 TEST(LexerTest, HandlesOperatorsAndDelimiters) {
-    std::string input = "+ - * / % ^ = == != < > <= >= ; , ( ) { }";
+    std::string input = "+ - * / % ^ = == != < > <= >= ; , ( ) { } [ ]";
     Lexer lexer(input);
 
     std::vector<TokenType> expectedTokens = {
@@ -76,6 +80,7 @@ TEST(LexerTest, HandlesOperatorsAndDelimiters) {
         TokenType::GREATER_EQUAL, TokenType::SEMICOLON, TokenType::COMMA,
         TokenType::LEFT_PAREN, TokenType::RIGHT_PAREN,
         TokenType::LEFT_BRACE, TokenType::RIGHT_BRACE,
+        TokenType::LEFT_BRACKET, TokenType::RIGHT_BRACKET,
         TokenType::END_OF_FILE
     };
 
@@ -84,3 +89,97 @@ TEST(LexerTest, HandlesOperatorsAndDelimiters) {
         EXPECT_EQ(token.type, expectedType);
     }
 }
+
+TEST(LexerTest, HandlesEmptyInput) {
+    Lexer lexer("");
+    EXPECT_EQ(lexer.getNextToken().type, TokenType::END_OF_FILE);
+}
+
+TEST(LexerTest, TokensRecordTheirPlaceInTheSource) {
+    std::string input = "alpha = 12.5;";
+    Lexer lexer(input);
+
+    Token identifier = lexer.getNextToken();
+    EXPECT_EQ(identifier.offset, 0u);
+    EXPECT_EQ(identifier.length, 5u);
+    Token assign = lexer.getNextToken();
+    EXPECT_EQ(assign.offset, 6u);
+    EXPECT_EQ(lexer.tokenText(assign), "=");
+    Token number = lexer.getNextToken();
+    EXPECT_EQ(number.offset, 8u);
+    EXPECT_EQ(number.length, 4u);
+    EXPECT_EQ(lexer.tokenText(number), "12.5");
+    EXPECT_EQ(number.number, 12.5);
+}
+
+TEST(LexerTest, ParsesNumbersIndependentlyOfLength) {
+    std::string digits(400, '9');
+    EXPECT_THROW(tokenize(digits), std::runtime_error);
+    EXPECT_THROW(tokenize("."), std::runtime_error);
+    EXPECT_EQ(tokenize("0.1")[0].number, 0.1);
+    EXPECT_EQ(tokenize("9007199254740993")[0].number, 9007199254740992.0);
+}
+
+TEST(LexerTest, InternsIdentifiersAtLexTime) {
+    std::string input = "count = count + other;";
+    std::vector<Token> tokens = tokenize(input);
+
+    ASSERT_EQ(tokens[0].type, TokenType::IDENTIFIER);
+    EXPECT_NE(tokens[0].symbol, NO_SYMBOL);
+    EXPECT_EQ(tokens[0].symbol, tokens[2].symbol);
+    EXPECT_NE(tokens[0].symbol, tokens[4].symbol);
+    EXPECT_EQ(symbolName(tokens[0].symbol), "count");
+    EXPECT_EQ(tokens[1].symbol, NO_SYMBOL);
+}
+
+TEST(LexerTest, KeywordsNeedAnExactMatch) {
+    std::string input = "if iff classy class elsewhere else functions function returned return "
+                        "whilst while form for";
+    std::vector<Token> tokens = tokenize(input);
+    std::vector<TokenType> expected = {
+        TokenType::IF, TokenType::IDENTIFIER, TokenType::IDENTIFIER, TokenType::CLASS,
+        TokenType::IDENTIFIER, TokenType::ELSE, TokenType::IDENTIFIER, TokenType::FUNCTION,
+        TokenType::IDENTIFIER, TokenType::RETURN, TokenType::IDENTIFIER, TokenType::WHILE,
+        TokenType::IDENTIFIER, TokenType::FOR,
+    };
+    ASSERT_GE(tokens.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(tokens[i].type, expected[i]) << i;
+    }
+}
+
+TEST(LexerTest, StreamedInputMatchesBufferedInputAtAnyChunkSize) {
+    std::string input = "function average(first, second) { return (first + second) / 2.25; }\n"
+                        "result = average(12345, 678.9) >= 100;";
+    Lexer buffered(input);
+    std::vector<Token> expected = tokenize(input);
+    for (size_t chunkSize : {1, 2, 3, 7, 64}) {
+        std::istringstream in(input);
+        Lexer lexer(in, chunkSize);
+        for (const Token& want : expected) {
+            Token token = lexer.getNextToken();
+            EXPECT_EQ(token.type, want.type) << "chunk size " << chunkSize;
+            EXPECT_EQ(token.offset, want.offset) << "chunk size " << chunkSize;
+            EXPECT_EQ(token.length, want.length) << "chunk size " << chunkSize;
+            if (token.type == TokenType::INTEGER || token.type == TokenType::FLOAT) {
+                EXPECT_EQ(token.number, want.number) << "chunk size " << chunkSize;
+            } else {
+                EXPECT_EQ(token.symbol, want.symbol) << "chunk size " << chunkSize;
+            }
+            EXPECT_EQ(lexer.tokenText(token), buffered.tokenText(want)) << "chunk size " << chunkSize;
+        }
+    }
+}
+
+TEST(LexerTest, StreamedTokensOutliveTheChunkTheyWereReadFrom) {
+    std::istringstream in("alpha 1.5 beta 42 gamma");
+    Lexer lexer(in, 1);
+    Token first = lexer.getNextToken();
+    Token second = lexer.getNextToken();
+    Token third = lexer.getNextToken();
+    lexer.getNextToken();
+    EXPECT_EQ(lexer.tokenText(first), "alpha");
+    EXPECT_EQ(second.number, 1.5);
+    EXPECT_EQ(lexer.tokenText(second), "1.5");
+    EXPECT_EQ(lexer.tokenText(third), "beta");
+}
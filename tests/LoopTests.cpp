@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+
+TYPED_TEST_SUITE(LoopTest, Backends, BackendNames);
+
+TYPED_TEST(LoopTest, WhileLoopsRunAtTopLevel) {
+    std::string input = R"(
+        sum = 0;
+        i = 1;
+        while (i <= 5000) {
+            sum = sum + i;
+            i = i + 1;
+        }
+        sum;
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 12502500.0);
+}
+
+TYPED_TEST(LoopTest, LoopsInFunctionsAreNotBoundByTheRecursionLimit) {
+    std::string input = R"(
+        function sumTo(n) {
+            total = 0;
+            i = 0;
+            while (i < n) {
+                i = i + 1;
+                total = total + i;
+            }
+            return total;
+        }
+        sumTo(100000);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 5000050000.0);
+}
+
+TYPED_TEST(LoopTest, ForLoopsRunInitConditionBodyAndUpdate) {
+    std::string input = R"(
+        total = 0;
+        for (i = 0; i < 10; i = i + 1) {
+            total = total + i * i;
+        }
+        total + i;
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 295.0);
+}
+
+TYPED_TEST(LoopTest, ForClausesMayBeEmpty) {
+    std::string input = R"(
+        i = 0;
+        for (; i < 5;) {
+            i = i + 1;
+        }
+        i;
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 5.0);
+}
+
+TYPED_TEST(LoopTest, LoopsAreStatementsWorthZero) {
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>("i = 0; while (i < 3) { i = i + 1; }"), 0.0);
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>("i = 5; while (i < 3) { i = i + 1; }"), 0.0);
+}
+
+TYPED_TEST(LoopTest, NestedLoops) {
+    std::string input = R"(
+        function pairs(n) {
+            count = 0;
+            for (a = 0; a < n; a = a + 1) {
+                for (b = a; b < n; b = b + 1) {
+                    count = count + 1;
+                }
+            }
+            return count;
+        }
+        pairs(20);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 210.0);
+}
+
+TYPED_TEST(LoopTest, ReturnLeavesTheLoop) {
+    std::string input = R"(
+        function firstSquareAbove(n) {
+            i = 0;
+            while (i < n) {
+                if (i * i > n) {
+                    return i;
+                }
+                i = i + 1;
+            }
+            return -1;
+        }
+        firstSquareAbove(50) * 100 + firstSquareAbove(0);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 799.0);
+}
+
+TYPED_TEST(LoopTest, TopLevelReturnLeavesTheLoop) {
+    std::string input = R"(
+        i = 0;
+        while (i < 10) {
+            if (i == 4) {
+                return i * 10;
+            }
+            i = i + 1;
+        }
+        i;
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 40.0);
+}
+
+TYPED_TEST(LoopTest, TailCallsLeaveTheLoop) {
+    std::string input = R"(
+        function countDown(n) {
+            while (n > 0) {
+                return countDown(n - 1);
+            }
+            return 42;
+        }
+        countDown(5000);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 42.0);
+}
+
+TYPED_TEST(LoopTest, LoopsCallFunctions) {
+    std::string input = R"(
+        function square(x) { return x * x; }
+        total = 0;
+        for (i = 1; i <= 100; i = i + 1) {
+            total = total + square(i);
+        }
+        total;
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<TypeParam>(input), 338350.0);
+}
+
+TYPED_TEST(LoopTest, ConditionErrorsSurface) {
+    EXPECT_THROW(interpretInput<TypeParam>("while (missing < 3) { missing = missing + 1; }"), std::runtime_error);
+    EXPECT_THROW(interpretInput<TypeParam>("i = 0; while (i < 3) { i = i / 0; }"), std::runtime_error);
+}
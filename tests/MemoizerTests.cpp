@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+#include <cmath>
+#include <stdexcept>
+
+TEST(MemoizerTest, MakesNaiveRecursionLinear) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    double result = interpretInput(R"(
+        function fib(n) {
+            if (n < 2) {
+                return n;
+            }
+            return fib(n - 1) + fib(n - 2);
+        }
+        fib(70);
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 190392490709135.0);
+
+    MemoStats stats = interpreter.getMemoStats();
+    EXPECT_EQ(stats.misses, 71u);
+    EXPECT_EQ(stats.hits, 68u);
+    EXPECT_EQ(stats.entries, 71u);
+    EXPECT_GT(stats.bytes, 0u);
+    EXPECT_GT(stats.hitRate(), 0.45);
+}
+
+TEST(MemoizerTest, IsOffByDefault) {
+    Interpreter interpreter;
+    interpretInput("function sq(x) { return x * x; } sq(3); sq(3);", interpreter);
+    EXPECT_EQ(interpreter.getMemoStats().hits + interpreter.getMemoStats().misses, 0u);
+}
+
+TEST(MemoizerTest, DoesNotCacheFunctionsThatReadGlobals) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    double result = interpretInput(R"(
+        scale = 2;
+        function f(x) { return x * scale; }
+        a = f(5);
+        scale = 3;
+        b = f(5);
+        a + b;
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 25.0);
+    EXPECT_EQ(interpreter.getMemoStats().entries, 0u);
+}
+
+TEST(MemoizerTest, MutualRecursionDoesNotHideImpurity) {
+    // b is analysed while a is still in progress and looks pure; a then reads a global
+    std::string input = R"(
+        g = 1;
+        function a(n) { x = b(n); return x + g; }
+        function b(n) {
+            if (n <= 0) {
+                return 0;
+            }
+            return a(n - 1);
+        }
+        r0 = a(0);
+        r1 = b(1);
+        g = 100;
+        r2 = b(1);
+        r2;
+    )";
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    EXPECT_DOUBLE_EQ(interpretInput(input, interpreter), 100.0);
+    EXPECT_DOUBLE_EQ(interpretInput<Interpreter>(input), 100.0);
+    EXPECT_EQ(interpreter.getMemoStats().entries, 0u);
+}
+
+TEST(MemoizerTest, DoesNotCacheLocalReadsThatFallBackToGlobals) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    double result = interpretInput(R"(
+        y = 5;
+        function f(x) {
+            if (x > 0) {
+                y = 1;
+            }
+            return y;
+        }
+        a = f(0);
+        y = 7;
+        b = f(0);
+        a * 10 + b;
+    )", interpreter);
+    EXPECT_DOUBLE_EQ(result, 57.0);
+    EXPECT_EQ(interpreter.getMemoStats().entries, 0u);
+}
+
+TEST(MemoizerTest, RedefinitionInvalidatesCallers) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    // Function definitions are referenced by later programs, so keep the trees alive
+    ASTPtr program = parseInput(R"(
+        function g(x) { return x + 1; }
+        function f(x) { return g(x) * 2; }
+        a = f(1);
+        function g(x) { return x + 10; }
+        b = f(1);
+        a * 100 + b;
+    )");
+    EXPECT_DOUBLE_EQ(interpreter.interpret(program), 422.0);
+
+    ASTPtr redefinition = parseInput("function g(x) { return x + 100; }");
+    interpreter.interpret(redefinition);
+    EXPECT_DOUBLE_EQ(interpretInput("f(1);", interpreter), 202.0);
+}
+
+TEST(MemoizerTest, CachesAreBounded) {
+    Interpreter interpreter;
+    interpreter.enableMemoization(8);
+    std::string input = "function sq(x) { return x * x; }\n";
+    for (int i = 0; i < 100; ++i) {
+        input += "sq(" + std::to_string(i) + ");\n";
+    }
+    EXPECT_DOUBLE_EQ(interpretInput(input, interpreter), 99.0 * 99.0);
+    EXPECT_LE(interpreter.getMemoStats().entries, 8u);
+}
+
+TEST(MemoizerTest, ErrorsAreNotCached) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    ASTPtr definition = parseInput("function inv(x) { return 1 / x; }");
+    interpreter.interpret(definition);
+    EXPECT_THROW(interpretInput("inv(0);", interpreter), std::runtime_error);
+    EXPECT_THROW(interpretInput("inv(0);", interpreter), std::runtime_error);
+    EXPECT_THROW(interpretInput("inv(1, 2);", interpreter), std::runtime_error);
+    EXPECT_DOUBLE_EQ(interpretInput("inv(4);", interpreter), 0.25);
+}
+
+TEST(MemoizerTest, DistinguishesSignedZeroArguments) {
+    Interpreter interpreter;
+    interpreter.enableMemoization();
+    double result = interpretInput(R"(
+        function inverse(x) { return x ^ (0 - 1); }
+        a = inverse(0);
+        b = inverse(-0);
+        a + b;
+    )", interpreter);
+    EXPECT_TRUE(std::isnan(result)); // inf + -inf
+}
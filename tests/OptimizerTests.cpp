@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "../include/optimizer.h"
+#include "TestUtils.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Parses and optimizes a program, returning the right-hand side of its first assignment
+struct Optimized {
+    ASTPtr tree;
+    size_t folded;
+
+    AST* firstValue() const {
+        auto compound = static_cast<Compound*>(tree.get());
+        return static_cast<Assign*>(compound->children[0].get())->right.get();
+    }
+};
+
+Optimized optimizeInput(const std::string& input) {
+    ASTPtr tree = parseInput(input);
+    Optimizer optimizer;
+    optimizer.optimize(tree);
+    return {std::move(tree), optimizer.getFoldedCount()};
+}
+
+double runOptimized(const std::string& input) {
+    ASTPtr tree = parseInput(input);
+    Optimizer optimizer;
+    optimizer.optimize(tree);
+    Interpreter interpreter;
+    return interpreter.interpret(tree);
+}
+
+} // namespace
+
+TEST(OptimizerTest, FoldsConstantArithmetic) {
+    Optimized result = optimizeInput("a = 2 * 3.5 + 4 ^ 2 % 5;");
+    ASSERT_EQ(result.firstValue()->type, NodeType::NUM);
+    EXPECT_DOUBLE_EQ(static_cast<Num*>(result.firstValue())->value, 8.0);
+}
+
+TEST(OptimizerTest, FoldsComparisonsAndNegation) {
+    Optimized result = optimizeInput("if (-(1 + 2) < -2) { a = 1; }");
+    auto ifNode = static_cast<IfStatement*>(static_cast<Compound*>(result.tree.get())->children[0].get());
+    ASSERT_EQ(ifNode->condition->type, NodeType::NUM);
+    EXPECT_DOUBLE_EQ(static_cast<Num*>(ifNode->condition.get())->value, 1.0);
+}
+
+TEST(OptimizerTest, SimplifiesIdentities) {
+    Optimized result = optimizeInput("a = 2 * 3.5 + x * 1 - 0;");
+    auto sum = static_cast<BinOp*>(result.firstValue());
+    ASSERT_EQ(sum->type, NodeType::BIN_OP);
+    EXPECT_EQ(sum->op.type, TokenType::PLUS);
+    ASSERT_EQ(sum->left->type, NodeType::NUM);
+    EXPECT_DOUBLE_EQ(static_cast<Num*>(sum->left.get())->value, 7.0);
+    ASSERT_EQ(sum->right->type, NodeType::VAR);
+    EXPECT_EQ(static_cast<Var*>(sum->right.get())->value, "x");
+}
+
+TEST(OptimizerTest, RemovesDoubleNegationAndUnaryPlus) {
+    Optimized result = optimizeInput("a = -(-(+x)) / 1;");
+    ASSERT_EQ(result.firstValue()->type, NodeType::VAR);
+}
+
+TEST(OptimizerTest, KeepsAddingPositiveZero) {
+    // -0 + 0 is +0, so x + 0 cannot be replaced by x
+    Optimized result = optimizeInput("a = x + 0;");
+    EXPECT_EQ(result.firstValue()->type, NodeType::BIN_OP);
+    EXPECT_EQ(result.folded, 0u);
+}
+
+TEST(OptimizerTest, KeepsDivisionByConstantZero) {
+    Optimized result = optimizeInput("a = 1 / (2 - 2);");
+    auto division = static_cast<BinOp*>(result.firstValue());
+    ASSERT_EQ(division->type, NodeType::BIN_OP);
+    EXPECT_EQ(division->op.type, TokenType::DIVIDE);
+}
+
+TEST(OptimizerTest, DivisionByZeroStillFailsAtRunTime) {
+    EXPECT_THROW(runOptimized("a = 1 / (2 - 2);"), std::runtime_error);
+    // An untaken branch must not raise the error
+    EXPECT_DOUBLE_EQ(runOptimized("if (1 > 2) { a = 1 / 0; } else { a = 3; } a;"), 3.0);
+    EXPECT_DOUBLE_EQ(runOptimized("function f(x) { if (x > 0) { return 1 / 0; } return 2; } f(0);"), 2.0);
+    EXPECT_THROW(runOptimized("function f(x) { if (x > 0) { return 1 / 0; } return 2; } f(1);"), std::runtime_error);
+}
+
+TEST(OptimizerTest, PreservesNaNAndSignedZero) {
+    EXPECT_TRUE(std::isnan(runOptimized("a = 0 % 0 * 1;")));
+    EXPECT_TRUE(std::signbit(runOptimized("x = -0; a = x - 0;")));
+    EXPECT_FALSE(std::signbit(runOptimized("x = -0; a = x + 0;")));
+}
+
+TEST(OptimizerTest, OptimizesFunctionBodies) {
+    Optimized result = optimizeInput("function f(x) { return x * (3 - 2) + 2 * 2; }");
+    auto function = static_cast<FunctionDef*>(static_cast<Compound*>(result.tree.get())->children[0].get());
+    auto ret = static_cast<Return*>(static_cast<Compound*>(function->body.get())->children[0].get());
+    auto sum = static_cast<BinOp*>(ret->expr.get());
+    ASSERT_EQ(sum->type, NodeType::BIN_OP);
+    EXPECT_EQ(sum->left->type, NodeType::VAR);
+    EXPECT_EQ(sum->right->type, NodeType::NUM);
+}
+
+TEST(OptimizerTest, MatchesUnoptimizedResults) {
+    const char* programs[] = {
+        "a = 2 * 3.5 + 4; b = a * 1 - 0 + -(-a); b;",
+        "function f(n) { if (n <= 1 * 1) { return n; } return f(n - 1) + f(n - (4 / 2)); } f(12);",
+        "x = 5; y = (x + 2 * 3) ^ (1 + 1) % (10 - 3); y;",
+        "x = 3; if (x * 1 == 3 + 0) { y = 1; } else { y = 2; } y;",
+    };
+    for (const char* program : programs) {
+        EXPECT_DOUBLE_EQ(runOptimized(program), interpretInput(program)) << program;
+    }
+}
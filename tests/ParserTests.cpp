@@ -4,6 +4,7 @@
 #include "../include/ast.h"
 #include "TestUtils.h"
 #include <memory>
+#include <sstream>
 
 TEST(ParserTest, ParsesVariableAssignment) {
     std::string input = "a = 5;";
@@ -136,3 +137,108 @@ TEST(ParserTest, ParsesIfElseStatements) {
     ASSERT_NE(ifStmt, nullptr);
 }
 */
+
+TEST(ParserTest, ParsesWhileLoops) {
+    ASTPtr tree = parseInput("while (i < 10) { i = i + 1; }");
+    auto compound = static_cast<Compound*>(tree.get());
+    ASSERT_EQ(compound->children.size(), 1u);
+    auto loop = dynamic_cast<WhileStatement*>(compound->children[0].get());
+    ASSERT_NE(loop, nullptr);
+    EXPECT_EQ(loop->condition->type, NodeType::BIN_OP);
+    EXPECT_EQ(loop->body->type, NodeType::COMPOUND);
+}
+
+TEST(ParserTest, LowersForLoopsToWhileLoops) {
+    ASTPtr tree = parseInput("for (i = 0; i < 10; i = i + 1) { total = total + i; }");
+    auto compound = static_cast<Compound*>(tree.get());
+    ASSERT_EQ(compound->children.size(), 1u);
+    // init; while (condition) { body update }
+    auto lowered = dynamic_cast<Compound*>(compound->children[0].get());
+    ASSERT_NE(lowered, nullptr);
+    ASSERT_EQ(lowered->children.size(), 2u);
+    EXPECT_EQ(lowered->children[0]->type, NodeType::ASSIGN);
+    auto loop = dynamic_cast<WhileStatement*>(lowered->children[1].get());
+    ASSERT_NE(loop, nullptr);
+    auto body = static_cast<Compound*>(loop->body.get());
+    ASSERT_EQ(body->children.size(), 2u);
+    EXPECT_EQ(body->children[1]->type, NodeType::ASSIGN);
+
+    // Without init or update only the loop is left
+    ASTPtr bare = parseInput("for (; i < 10;) { i = i + 1; }");
+    auto bareLoop = dynamic_cast<WhileStatement*>(static_cast<Compound*>(bare.get())->children[0].get());
+    ASSERT_NE(bareLoop, nullptr);
+    EXPECT_EQ(static_cast<Compound*>(bareLoop->body.get())->children.size(), 1u);
+
+    EXPECT_THROW(parseInput("for (i = 0; i = 10; i = i + 1) { }"), std::runtime_error);
+    EXPECT_THROW(parseInput("while (i < 10) i = i + 1;"), std::runtime_error);
+}
+
+TEST(ParserTest, ParsesArrayLiteralsAndIndexing) {
+    ASTPtr tree = parseInput("[1, 2 + x, []][i][0];");
+    auto compound = static_cast<Compound*>(tree.get());
+    ASSERT_EQ(compound->children.size(), 1u);
+    // Indexes apply left to right
+    auto outer = dynamic_cast<Index*>(compound->children[0].get());
+    ASSERT_NE(outer, nullptr);
+    EXPECT_EQ(outer->index->type, NodeType::NUM);
+    auto inner = dynamic_cast<Index*>(outer->array.get());
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(inner->index->type, NodeType::VAR);
+    auto literal = dynamic_cast<ArrayLiteral*>(inner->array.get());
+    ASSERT_NE(literal, nullptr);
+    ASSERT_EQ(literal->elements.size(), 3u);
+    EXPECT_EQ(literal->elements[1]->type, NodeType::BIN_OP);
+    EXPECT_EQ(static_cast<ArrayLiteral*>(literal->elements[2].get())->elements.size(), 0u);
+
+    // An index binds tighter than a unary minus
+    ASTPtr negated = parseInput("-a[1];");
+    auto unary = dynamic_cast<UnaryOp*>(static_cast<Compound*>(negated.get())->children[0].get());
+    ASSERT_NE(unary, nullptr);
+    EXPECT_EQ(unary->expr->type, NodeType::INDEX);
+
+    EXPECT_THROW(parseInput("[1, 2;"), std::runtime_error);
+    EXPECT_THROW(parseInput("a[];"), std::runtime_error);
+}
+
+TEST(ParserTest, AllocatesTreeInOneArena) {
+    ASTPtr tree = parseInput("a = 1 + 2 * b;");
+
+    ASTArena* arena = tree.get_deleter().ownedArena;
+    ASSERT_NE(arena, nullptr) << "Root link does not own the tree's arena";
+    // Compound, Assign, Var, BinOp(+), Num, BinOp(*), Num, Var
+    EXPECT_EQ(arena->nodeCount(), 8);
+
+    Compound* compound = dynamic_cast<Compound*>(tree.get());
+    ASSERT_NE(compound, nullptr);
+    EXPECT_TRUE(compound->children[0].get_deleter().borrowed);
+}
+
+TEST(ParserTest, FreesVeryDeepTreesWithoutRecursion) {
+    // A left-deep chain of a million BinOps used to overflow the stack in the destructors
+    std::string input = "1";
+    for (int i = 0; i < 1000000; ++i) {
+        input += "+1";
+    }
+    input += ";";
+
+    ASTPtr tree = parseInput(input);
+    EXPECT_EQ(tree.get_deleter().ownedArena->nodeCount(), 2000002);
+    tree.reset();
+}
+
+TEST(ParserTest, ParsesOneStatementAtATime) {
+    std::istringstream in("a = 1; function f(x) { return x; } if (a > 0) { a = 2; } f(a)");
+    Lexer lexer(in, 4);
+    Parser parser(lexer);
+    std::vector<NodeType> types;
+    while (ASTPtr statement = parser.parseStatement()) {
+        // Every statement owns the arena its nodes were allocated from
+        EXPECT_NE(statement.get_deleter().ownedArena, nullptr);
+        types.push_back(statement->type);
+    }
+    std::vector<NodeType> expected = {
+        NodeType::ASSIGN, NodeType::FUNCTION_DEF, NodeType::IF_STATEMENT, NodeType::FUNCTION_CALL,
+    };
+    EXPECT_EQ(types, expected);
+    EXPECT_EQ(parser.parseStatement(), nullptr);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "../include/profiler.h"
+#include "../include/interpreter.h"
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "TestUtils.h"
+
+namespace {
+
+const std::string PROGRAM = R"(
+    function leaf(x) { return x * 2; }
+    function fib(n) {
+        if (n < 2) {
+            return leaf(n);
+        }
+        return fib(n - 1) + fib(n - 2);
+    }
+    function loop(n) {
+        if (n == 0) {
+            return 0;
+        }
+        return loop(n - 1);
+    }
+    fib(10);
+    loop(5);
+)";
+
+const FunctionProfile* findFunction(const std::vector<FunctionProfile>& profiles, const std::string& name) {
+    auto found = std::find_if(profiles.begin(), profiles.end(),
+                              [&name](const FunctionProfile& profile) { return profile.name == name; });
+    return found == profiles.end() ? nullptr : &*found;
+}
+
+} // namespace
+
+TEST(ProfilerTest, IsOffByDefault) {
+    Interpreter interpreter;
+    EXPECT_EQ(interpreter.getProfiler(), nullptr);
+}
+
+TEST(ProfilerTest, CountsCallsAndTimesPerFunction) {
+    ASTPtr tree = parseInput(PROGRAM);
+    Interpreter interpreter;
+    interpreter.enableProfiling();
+    interpreter.interpret(tree);
+
+    std::vector<FunctionProfile> profiles = interpreter.getProfiler()->getFunctionProfiles();
+    const FunctionProfile* fib = findFunction(profiles, "fib");
+    const FunctionProfile* leaf = findFunction(profiles, "leaf");
+    const FunctionProfile* loop = findFunction(profiles, "loop");
+    const FunctionProfile* topLevel = findFunction(profiles, Profiler::TOP_LEVEL);
+    ASSERT_TRUE(fib && leaf && loop && topLevel);
+    EXPECT_EQ(fib->calls, 177u);
+    EXPECT_EQ(leaf->calls, 89u);
+    // Tail calls count as calls although they reuse the frame
+    EXPECT_EQ(loop->calls, 6u);
+    EXPECT_EQ(topLevel->calls, 1u);
+
+    // A recursive function's inclusive time is its outermost call's
+    EXPECT_LE(fib->inclusiveSeconds, topLevel->inclusiveSeconds);
+    EXPECT_LE(fib->exclusiveSeconds, fib->inclusiveSeconds);
+    EXPECT_LE(leaf->inclusiveSeconds, fib->inclusiveSeconds);
+    double exclusive = 0.0;
+    for (const FunctionProfile& profile : profiles) {
+        exclusive += profile.exclusiveSeconds;
+    }
+    EXPECT_NEAR(exclusive, topLevel->inclusiveSeconds, 1e-6);
+}
+
+TEST(ProfilerTest, CountsNodeExecutions) {
+    ASTPtr tree = parseInput(PROGRAM);
+    Interpreter interpreter;
+    interpreter.enableProfiling();
+    interpreter.interpret(tree);
+
+    std::vector<NodeProfile> nodes = interpreter.getProfiler()->getNodeProfiles();
+    auto find = [&nodes](const std::string& description, const std::string& function) {
+        auto found = std::find_if(nodes.begin(), nodes.end(), [&](const NodeProfile& node) {
+            return node.description == description && node.function == function;
+        });
+        return found == nodes.end() ? 0 : found->count;
+    };
+    EXPECT_EQ(find("BinOp <", "fib"), 177u);
+    EXPECT_EQ(find("BinOp *", "leaf"), 89u);
+    EXPECT_EQ(find("FunctionCall fib", Profiler::TOP_LEVEL), 1u);
+    EXPECT_TRUE(std::is_sorted(nodes.begin(), nodes.end(),
+                               [](const NodeProfile& a, const NodeProfile& b) { return a.count > b.count; }));
+}
+
+TEST(ProfilerTest, KeepsCountsOfStatementTreesThatWereFreed) {
+    Interpreter interpreter;
+    interpreter.enableProfiling();
+    std::string input = "function twice(x) { return 2 * x; } a = 1 + 2; b = 3 * 4; c = 5 - 6; d = 7 / 8; "
+                        "t = twice(a); t = twice(b);";
+    Lexer lexer(input);
+    Parser parser(lexer);
+    // Each tree without a definition is freed once it has run, and later trees may reuse its addresses
+    while (ASTPtr statement = parser.parseStatement()) {
+        interpreter.interpretStatement(std::move(statement));
+    }
+
+    std::vector<NodeProfile> nodes = interpreter.getProfiler()->getNodeProfiles();
+    auto find = [&nodes](const std::string& description, const std::string& function) {
+        auto found = std::find_if(nodes.begin(), nodes.end(), [&](const NodeProfile& node) {
+            return node.description == description && node.function == function;
+        });
+        return found == nodes.end() ? 0 : found->count;
+    };
+    for (const char* assign : {"Assign a", "Assign b", "Assign c", "Assign d"}) {
+        EXPECT_EQ(find(assign, Profiler::TOP_LEVEL), 1u) << assign;
+    }
+    EXPECT_EQ(find("Assign t", Profiler::TOP_LEVEL), 2u);
+    // The function body lives on with its definition
+    EXPECT_EQ(find("BinOp *", "twice"), 2u);
+}
+
+TEST(ProfilerTest, WritesFoldedStacks) {
+    ASTPtr tree = parseInput(PROGRAM);
+    Interpreter interpreter;
+    interpreter.enableProfiling();
+    interpreter.interpret(tree);
+
+    std::ostringstream folded;
+    interpreter.getProfiler()->writeFoldedStacks(folded);
+    std::istringstream lines(folded.str());
+    std::string line;
+    bool sawLeaf = false;
+    while (std::getline(lines, line)) {
+        size_t space = line.rfind(' ');
+        ASSERT_NE(space, std::string::npos);
+        std::string stack = line.substr(0, space);
+        EXPECT_EQ(stack.rfind(Profiler::TOP_LEVEL, 0), 0u) << line;
+        EXPECT_GT(std::stoll(line.substr(space + 1)), 0) << line;
+        sawLeaf = sawLeaf || stack.find(";fib;fib;leaf") != std::string::npos;
+    }
+    EXPECT_TRUE(sawLeaf) << folded.str();
+}
+
+TEST(ProfilerTest, UnwindsOnErrors) {
+    ASTPtr tree = parseInput(R"(
+        function inner(x) { return 1 / x; }
+        function outer(x) { return inner(x) + 1; }
+    )");
+    Interpreter interpreter;
+    interpreter.enableProfiling();
+    interpreter.interpret(tree);
+    EXPECT_THROW(interpreter.call("outer", {0}), std::runtime_error);
+    EXPECT_DOUBLE_EQ(interpreter.call("outer", {2}), 1.5);
+
+    std::vector<FunctionProfile> profiles = interpreter.getProfiler()->getFunctionProfiles();
+    ASSERT_TRUE(findFunction(profiles, "inner"));
+    EXPECT_EQ(findFunction(profiles, "inner")->calls, 2u);
+    EXPECT_EQ(findFunction(profiles, "outer")->calls, 2u);
+
+    std::ostringstream report;
+    interpreter.getProfiler()->writeReport(report);
+    EXPECT_NE(report.str().find("outer"), std::string::npos);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "../include/programcache.h"
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string PROGRAM = R"(
+    class Shapes {
+        function area(w, h) { return w * h; }
+    }
+    function fib(n) {
+        if (n < 2) {
+            return n;
+        } else {
+            return fib(n - 1) + fib(n - 2);
+        }
+    }
+    total = 0;
+    if (fib(10) != 55) {
+        total = -1;
+    }
+    total = total + fib(12) % 7 - 2 ^ 3 / 4 + +1.5;
+    for (i = 0; i < 4; i = i + 1) {
+        total = total * 2;
+    }
+    while (total > 100) {
+        total = total - 30;
+    }
+    total = total + sum([1, total, 3] * 2) - [4, 5][1];
+    total;
+)";
+
+void writeFile(const fs::path& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(ProgramCacheTest, RoundTripsPrograms) {
+    ASTPtr tree = parseInput(PROGRAM);
+    std::string bytes = ProgramCache::serialize(tree.get(), PROGRAM, false);
+
+    ProgramCache::Status status;
+    ASTPtr loaded = ProgramCache::deserialize(bytes, PROGRAM, false, &status);
+    EXPECT_EQ(status, ProgramCache::Status::HIT);
+    EXPECT_EQ(ProgramCache::serialize(loaded.get(), PROGRAM, false), bytes);
+
+    Interpreter fromSource;
+    Interpreter fromCache;
+    EXPECT_DOUBLE_EQ(fromCache.interpret(loaded), fromSource.interpret(tree));
+}
+
+TEST(ProgramCacheTest, RejectsStaleCaches) {
+    ASTPtr tree = parseInput(PROGRAM);
+    std::string bytes = ProgramCache::serialize(tree.get(), PROGRAM, false);
+    ProgramCache::Status status;
+
+    EXPECT_THROW(ProgramCache::deserialize(bytes, PROGRAM + " ", false, &status), std::runtime_error);
+    EXPECT_EQ(status, ProgramCache::Status::STALE);
+    EXPECT_THROW(ProgramCache::deserialize(bytes, PROGRAM, true, &status), std::runtime_error);
+    EXPECT_EQ(status, ProgramCache::Status::STALE);
+}
+
+TEST(ProgramCacheTest, RejectsCorruptCaches) {
+    ASTPtr tree = parseInput(PROGRAM);
+    std::string bytes = ProgramCache::serialize(tree.get(), PROGRAM, false);
+    ProgramCache::Status status;
+
+    std::string flipped = bytes;
+    flipped[flipped.size() / 2] ^= 0x40;
+    EXPECT_THROW(ProgramCache::deserialize(flipped, PROGRAM, false, &status), std::runtime_error);
+    EXPECT_EQ(status, ProgramCache::Status::CORRUPT);
+
+    for (size_t size : {size_t(0), size_t(10), bytes.size() - 1}) {
+        EXPECT_THROW(ProgramCache::deserialize(bytes.substr(0, size), PROGRAM, false, &status), std::runtime_error);
+        EXPECT_EQ(status, ProgramCache::Status::CORRUPT) << size;
+    }
+}
+
+TEST(ProgramCacheTest, LoadRebuildsMissingStaleAndCorruptFiles) {
+    fs::path source = fs::temp_directory_path() / "programcache_test.txt";
+    fs::path cache = ProgramCache::cachePathFor(source.string());
+    fs::remove(cache);
+    writeFile(source, PROGRAM);
+
+    ProgramCache::Status status;
+    ASTPtr first = ProgramCache::load(source.string(), PROGRAM, true, &status);
+    EXPECT_EQ(status, ProgramCache::Status::MISSING);
+    ASSERT_TRUE(fs::exists(cache));
+    ASTPtr second = ProgramCache::load(source.string(), PROGRAM, true, &status);
+    EXPECT_EQ(status, ProgramCache::Status::HIT);
+    Interpreter interpreter;
+    EXPECT_DOUBLE_EQ(interpreter.interpret(second), interpretInput<Interpreter>(PROGRAM));
+
+    std::string edited = "x = 41; x + 1;";
+    ProgramCache::load(source.string(), edited, true, &status);
+    EXPECT_EQ(status, ProgramCache::Status::STALE);
+    ASTPtr reloaded = ProgramCache::load(source.string(), edited, true, &status);
+    EXPECT_EQ(status, ProgramCache::Status::HIT);
+    Interpreter editedInterpreter;
+    EXPECT_DOUBLE_EQ(editedInterpreter.interpret(reloaded), 42.0);
+
+    std::string bytes = readFile(cache);
+    bytes.back() ^= 0x01;
+    writeFile(cache, bytes);
+    ProgramCache::load(source.string(), edited, true, &status);
+    EXPECT_EQ(status, ProgramCache::Status::CORRUPT);
+    ProgramCache::load(source.string(), edited, true, &status);
+    EXPECT_EQ(status, ProgramCache::Status::HIT);
+
+    fs::remove(cache);
+    fs::remove(source);
+}
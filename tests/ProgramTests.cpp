@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/program.h"
+
+namespace {
+
+const char* const SOURCE = R"(
+    rate = 0.25;
+    function fib(n) {
+        if (n < 2) {
+            return n;
+        }
+        return fib(n - 1) + fib(n - 2);
+    }
+    function taxed(amount) {
+        return amount + amount * rate;
+    }
+    function install() {
+        function helper(x) {
+            return x * 3;
+        }
+        return 0;
+    }
+    fib(5);
+)";
+
+} // namespace
+
+TEST(ProgramTest, CallsFunctionsWithoutRerunningTopLevelCode) {
+    std::string source = SOURCE;
+    std::shared_ptr<const Program> program = Program::compile(source);
+    // The program keeps nothing of its source
+    source.assign(source.size(), ' ');
+
+    EXPECT_TRUE(program->hasFunction("fib"));
+    EXPECT_FALSE(program->hasFunction("rate"));
+    EXPECT_DOUBLE_EQ(program->getVariableValue("rate"), 0.25);
+
+    ExecutionContext context(program);
+    EXPECT_DOUBLE_EQ(context.call("fib", {20}), 6765.0);
+    EXPECT_DOUBLE_EQ(context.call("taxed", {100}), 125.0);
+    double amount = 8;
+    EXPECT_DOUBLE_EQ(context.call("taxed", &amount, 1), 10.0);
+}
+
+TEST(ProgramTest, ContextsDoNotShareDefinitions) {
+    std::shared_ptr<const Program> program = Program::compile(SOURCE);
+    ExecutionContext first(program);
+    ExecutionContext second(program);
+    first.call("install", {});
+    EXPECT_DOUBLE_EQ(first.call("helper", {5}), 15.0);
+    EXPECT_DOUBLE_EQ(first.call("fib", {10}), 55.0);
+    EXPECT_THROW(second.call("helper", {5}), std::runtime_error);
+    EXPECT_FALSE(program->hasFunction("helper"));
+}
+
+TEST(ProgramTest, ReportsErrors) {
+    EXPECT_THROW(Program::compile("function f( { }"), std::runtime_error);
+    EXPECT_THROW(Program::compile("x = 1 / 0;"), std::runtime_error);
+
+    std::shared_ptr<const Program> program = Program::compile(SOURCE);
+    ExecutionContext context(program);
+    EXPECT_THROW(context.call("missing", {}), std::runtime_error);
+    EXPECT_THROW(context.call("rate", {}), std::runtime_error);
+    EXPECT_THROW(context.call("fib", {1, 2}), std::runtime_error);
+    EXPECT_THROW(context.call("fib", {100000}), std::runtime_error);
+    // The context recovers from a failed call
+    EXPECT_DOUBLE_EQ(context.call("fib", {10}), 55.0);
+}
+
+TEST(ProgramTest, SharesOneProgramBetweenThreads) {
+    std::shared_ptr<const Program> program = Program::compile(SOURCE);
+    std::vector<double> results(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&program, &results, t]() {
+            ExecutionContext context(program);
+            double sum = 0;
+            for (int i = 0; i < 200; ++i) {
+                sum += context.call("taxed", {static_cast<double>(t)}) + context.call("fib", {12});
+            }
+            results[t] = sum;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t t = 0; t < results.size(); ++t) {
+        EXPECT_DOUBLE_EQ(results[t], 200 * (1.25 * static_cast<double>(t) + 144));
+    }
+}
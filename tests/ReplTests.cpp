@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include "../include/interpreter.h"
+#include "../include/repl.h"
+
+TEST(ReplTest, SnippetsEndWithBalancedStatements) {
+    EXPECT_TRUE(Repl::isComplete("a = 1;"));
+    EXPECT_TRUE(Repl::isComplete("function f(x) {\n return x;\n}\n"));
+    EXPECT_TRUE(Repl::isComplete("a = [1,\n 2];"));
+    EXPECT_FALSE(Repl::isComplete("a = 1"));
+    EXPECT_FALSE(Repl::isComplete("function f(x) {\n return x;\n"));
+    EXPECT_FALSE(Repl::isComplete("a = [1,\n"));
+    EXPECT_FALSE(Repl::isComplete("if (a < (1 + 2)"));
+    // Errors are reported rather than waited out
+    EXPECT_TRUE(Repl::isComplete("a = 1 $"));
+    EXPECT_TRUE(Repl::isComplete("a = 1);"));
+}
+
+TEST(ReplTest, IfBlocksWaitForAnElseOnTheNextLine) {
+    EXPECT_TRUE(Repl::awaitsElse("if (a) {\n b;\n}\n"));
+    EXPECT_FALSE(Repl::awaitsElse("if (a) { b; } else { c; }"));
+    EXPECT_FALSE(Repl::awaitsElse("if (a) { b; } c;"));
+    EXPECT_FALSE(Repl::awaitsElse("while (a) { if (b) { c; } }"));
+    EXPECT_FALSE(Repl::awaitsElse("if (a) { b; } function f() { return 1; }"));
+
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    std::istringstream in(
+        "if (1 == 0) { 1; }\n"
+        "else { 2; }\n"
+        "if (1 == 0) { 3; }\n"
+        "4;\n"
+        "if (1 == 1) { 5; }\n");
+    std::ostringstream out;
+    std::ostringstream err;
+    repl.loop(in, out, err);
+
+    EXPECT_EQ(out.str(), "> ... 2\n> ... 0\n4\n> ... 5\n\n");
+    EXPECT_EQ(err.str(), "");
+}
+
+TEST(ReplTest, DefinitionsOutliveTheirSnippets) {
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    EXPECT_FALSE(repl.run("function inc(x) { return x + 1; }").has_value());
+    EXPECT_FALSE(repl.run("base = 40;").has_value());
+    // Later snippets are parsed into trees of their own and freed after they run
+    for (int i = 0; i < 100; ++i) {
+        repl.run("t = " + std::to_string(i) + " * 2 + base; t + inc(t);");
+    }
+    EXPECT_EQ(repl.run("inc(base) + inc(1);"), 43.0);
+
+    // Redefinitions take effect for every later snippet
+    repl.run("function inc(x) { return x + 2; }");
+    EXPECT_EQ(repl.run("inc(base);"), 42.0);
+}
+
+TEST(ReplTest, StatementsBeforeAnErrorStayInEffect) {
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    EXPECT_THROW(repl.run("a = 1; function twice(x) { return 2 * x; } b = missing; c = 3;"), std::runtime_error);
+    EXPECT_EQ(repl.run("twice(a);"), 2.0);
+    EXPECT_THROW(repl.run("c;"), std::runtime_error);
+}
+
+TEST(ReplTest, TopLevelReturnEndsTheSnippet) {
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    EXPECT_EQ(repl.run("a = 1; return 7; 99; a = 2;"), 7.0);
+    // Only the rest of that snippet is skipped
+    EXPECT_EQ(repl.run("a;"), 1.0);
+    EXPECT_EQ(repl.run("a = 3; a;"), 3.0);
+}
+
+TEST(ReplTest, ProfilesSnippetsWhoseTreesWereFreed) {
+    Interpreter interpreter;
+    interpreter.enableProfiling();
+    Repl repl(interpreter);
+    repl.run("a = 1 + 2;");
+    repl.run("b = 3 * 4;");
+    repl.run("b = 3 * 4;");
+    repl.run("c = 5 - 6;");
+
+    std::vector<NodeProfile> nodes = interpreter.getProfiler()->getNodeProfiles();
+    auto count = [&nodes](const std::string& description) {
+        auto found = std::find_if(nodes.begin(), nodes.end(),
+                                  [&](const NodeProfile& node) { return node.description == description; });
+        return found == nodes.end() ? 0 : found->count;
+    };
+    EXPECT_EQ(count("Assign a"), 1u);
+    EXPECT_EQ(count("Assign b"), 2u);
+    EXPECT_EQ(count("Assign c"), 1u);
+}
+
+TEST(ReplTest, LoopPrintsValuesAndKeepsGoingAfterErrors) {
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    std::istringstream in(
+        "function sq(x) {\n"
+        "    return x * x;\n"
+        "}\n"
+        "\n"
+        "sq(4);\n"
+        "sq(missing);\n"
+        "xs = [0.5, 2];\n"
+        "xs * 2; sq(1.5)\n"
+        ";\n"
+        "sq(");
+    std::ostringstream out;
+    std::ostringstream err;
+    repl.loop(in, out, err);
+
+    std::string expectedOut = std::string("> ... ... > > 16\n> > > ... 2.25\n> ... \n");
+    EXPECT_EQ(out.str(), expectedOut);
+    EXPECT_EQ(err.str(), "Undefined variable: missing\nSyntax error: Invalid factor\n");
+}
+
+TEST(ReplTest, FormatsNumbersExactlyAndArraysByElement) {
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    EXPECT_EQ(repl.format(0.1), "0.1");
+    EXPECT_EQ(repl.format(-3.0), "-3");
+    EXPECT_EQ(repl.format(1e300), "1e+300");
+    std::optional<double> array = repl.run("[1, 0.25] * 2;");
+    ASSERT_TRUE(array.has_value());
+    EXPECT_EQ(repl.format(*array), "[2, 0.5]");
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/resolver.h"
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+
+TEST(ResolverTest, AssignsFrameSlotsToParametersAndLocals) {
+    ASTPtr tree = parseInput(R"(
+        function f(a, b) {
+            c = a + b;
+            return c * g;
+        }
+    )");
+    SymbolTable symbolTable;
+    Resolver resolver(symbolTable);
+    resolver.resolve(tree.get());
+
+    auto compound = dynamic_cast<Compound*>(tree.get());
+    auto funcDef = dynamic_cast<FunctionDef*>(compound->children[0].get());
+    ASSERT_NE(funcDef, nullptr);
+    EXPECT_EQ(funcDef->numLocals, 3);
+
+    auto body = dynamic_cast<Compound*>(funcDef->body.get());
+    auto assign = dynamic_cast<Assign*>(body->children[0].get());
+    auto c = dynamic_cast<Var*>(assign->left.get());
+    EXPECT_EQ(c->depth, SymbolTable::LOCAL_DEPTH);
+    EXPECT_EQ(c->slot, 2);
+
+    auto sum = dynamic_cast<BinOp*>(assign->right.get());
+    auto b = dynamic_cast<Var*>(sum->right.get());
+    EXPECT_EQ(b->depth, SymbolTable::LOCAL_DEPTH);
+    EXPECT_EQ(b->slot, 1);
+
+    auto ret = dynamic_cast<Return*>(body->children[1].get());
+    auto product = dynamic_cast<BinOp*>(ret->expr.get());
+    auto g = dynamic_cast<Var*>(product->right.get());
+    EXPECT_EQ(g->depth, SymbolTable::GLOBAL_DEPTH);
+    EXPECT_EQ(g->slot, symbolTable.findGlobal(intern("g")));
+}
+
+TEST(ResolverTest, ReportsUndefinedTopLevelReadWhenItRuns) {
+    Interpreter interpreter;
+    try {
+        interpretInput("a = 1; b = missing + 1;", interpreter);
+        FAIL() << "Expected an undefined variable error";
+    } catch (const std::runtime_error& error) {
+        EXPECT_STREQ(error.what(), "Undefined variable: missing");
+    }
+    // The statements before the read ran
+    EXPECT_DOUBLE_EQ(interpreter.getVariableValue("a"), 1.0);
+    EXPECT_THROW(interpreter.getVariableValue("b"), std::runtime_error);
+}
+
+TEST(ResolverTest, ReportsReadOfGlobalAssignedLaterAtRunTime) {
+    Interpreter interpreter;
+    try {
+        interpretInput("b = a + 1; a = 2;", interpreter);
+        FAIL() << "Expected an undefined variable error";
+    } catch (const std::runtime_error& error) {
+        EXPECT_STREQ(error.what(), "Undefined variable: a");
+    }
+}
+
+TEST(ResolverTest, FunctionsReadGlobalsAssignedBeforeTheCall) {
+    std::string input = R"(
+        function scaled(n) {
+            return n * factor;
+        }
+        factor = 3;
+        scaled(5);
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<Interpreter>(input), 15.0);
+}
+
+TEST(ResolverTest, LocalReadBeforeAssignmentSeesGlobal) {
+    std::string input = R"(
+        y = 3;
+        function f() {
+            y = y + 1;
+            return y;
+        }
+        f() + y;
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<Interpreter>(input), 7.0);
+}
+
+TEST(ResolverTest, ScopingIsLexical) {
+    std::string input = R"(
+        x = 1;
+        function inner() {
+            return x;
+        }
+        function outer() {
+            x = 7;
+            return inner();
+        }
+        outer();
+    )";
+    EXPECT_DOUBLE_EQ(interpretInput<Interpreter>(input), 1.0);
+}
+
+TEST(ResolverTest, GlobalsKeepTheirSlotsAcrossPrograms) {
+    Interpreter interpreter;
+    ASTPtr definitions = parseInput("function addTotal(n) { return n + total; }");
+    interpreter.interpret(definitions);
+    interpretInput("total = 40;", interpreter);
+    EXPECT_DOUBLE_EQ(interpretInput("addTotal(2);", interpreter), 42.0);
+}
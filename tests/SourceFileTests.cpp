@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "../include/sourcefile.h"
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/interpreter.h"
+
+namespace {
+
+std::string writeTempFile(const std::string& name, const std::string& contents) {
+    std::ofstream out(name, std::ios::binary);
+    out << contents;
+    return name;
+}
+
+} // namespace
+
+TEST(SourceFileTest, MapsFileContents) {
+    std::string path = writeTempFile("sourcefile_test_input.txt", "a = 5; b = a * 2; b + 3;");
+    {
+        SourceFile source = SourceFile::map(path);
+        EXPECT_EQ(source.text(), "a = 5; b = a * 2; b + 3;");
+
+        Lexer lexer(source.text());
+        Parser parser(lexer);
+        ASTPtr tree = parser.parse();
+        Interpreter interpreter;
+        EXPECT_DOUBLE_EQ(interpreter.interpret(tree), 13.0);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(SourceFileTest, HandlesEmptyFile) {
+    std::string path = writeTempFile("sourcefile_test_empty.txt", "");
+    {
+        SourceFile source = SourceFile::map(path);
+        EXPECT_TRUE(source.text().empty());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(SourceFileTest, ThrowsOnMissingFile) {
+    EXPECT_THROW(SourceFile::map("does/not/exist.txt"), std::runtime_error);
+}
+
+TEST(SourceFileTest, ReadsStreams) {
+    std::istringstream in("x = 1;");
+    SourceFile source = SourceFile::read(in);
+    EXPECT_FALSE(source.isMapped());
+    SourceFile moved = std::move(source);
+    EXPECT_EQ(moved.text(), "x = 1;");
+}
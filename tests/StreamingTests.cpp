@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/interpreter.h"
+#include "TestUtils.h"
+#include <sstream>
+#include <stdexcept>
+
+// Runs the input one statement at a time, as main does with --stream
+static double interpretStreamed(const std::string& input, Interpreter& interpreter, size_t chunkSize = 8) {
+    std::istringstream in(input);
+    Lexer lexer(in, chunkSize);
+    Parser parser(lexer);
+    double result = 0.0;
+    while (ASTPtr statement = parser.parseStatement()) {
+        result = interpreter.interpretStatement(std::move(statement));
+        if (interpreter.returned()) {
+            break;
+        }
+    }
+    return result;
+}
+
+// The same for the backends that run each statement's tree with interpret()
+template <typename Backend>
+static double interpretStreamed(const std::string& input, Backend& backend) {
+    std::istringstream in(input);
+    Lexer lexer(in);
+    Parser parser(lexer);
+    double result = 0.0;
+    while (ASTPtr statement = parser.parseStatement()) {
+        result = backend.interpret(statement);
+        if (backend.returned()) {
+            break;
+        }
+    }
+    return result;
+}
+
+TEST(StreamingTest, MatchesWholeProgramExecution) {
+    std::string input = R"(
+        function fib(n) {
+            if (n < 2) {
+                return n;
+            }
+            return fib(n - 1) + fib(n - 2);
+        }
+        class Point {
+            function norm(x, y) { return (x * x + y * y) ^ 0.5; }
+        }
+        a = fib(15);
+        b = a * 2.5 - 1;
+        b % 7;
+    )";
+    Interpreter interpreter;
+    EXPECT_DOUBLE_EQ(interpretStreamed(input, interpreter), interpretInput<Interpreter>(input));
+    EXPECT_DOUBLE_EQ(interpreter.getVariableValue("a"), 610.0);
+}
+
+TEST(StreamingTest, RunsStatementsBeforeTheRestIsParsed) {
+    Interpreter interpreter;
+    try {
+        interpretStreamed("a = 1; b = a + 1; c = ) ;", interpreter);
+        FAIL() << "Expected a syntax error";
+    } catch (const std::runtime_error&) {
+    }
+    EXPECT_DOUBLE_EQ(interpreter.getVariableValue("b"), 2.0);
+}
+
+TEST(StreamingTest, DefinitionsOutliveTheirStatement) {
+    Interpreter interpreter;
+    double result = interpretStreamed(R"(
+        function square(x) { return x * x; }
+        flag = 1;
+        if (flag > 0) {
+            function cube(x) { return x * square(x); }
+        }
+        padding = 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10;
+        square(3) + cube(2);
+    )", interpreter, 1);
+    EXPECT_DOUBLE_EQ(result, 17.0);
+}
+
+TEST(StreamingTest, DefinitionsSurviveAnErrorInTheirStatement) {
+    Interpreter interpreter;
+    EXPECT_THROW(interpretStreamed("if (1 > 0) { function one() { return 1; } x = 1 / 0; }", interpreter),
+                 std::runtime_error);
+    EXPECT_DOUBLE_EQ(interpretStreamed("one() + 1;", interpreter), 2.0);
+}
+
+TEST(StreamingTest, StopsAtATopLevelReturn) {
+    std::string input = "a = 1; return a + 1; a = 1 / 0;";
+    Interpreter interpreter;
+    EXPECT_DOUBLE_EQ(interpretStreamed(input, interpreter), 2.0);
+    EXPECT_DOUBLE_EQ(interpreter.getVariableValue("a"), 1.0);
+
+    VirtualMachine vm;
+    EXPECT_DOUBLE_EQ(interpretStreamed(input, vm), 2.0);
+    ClosureCompiler closures;
+    EXPECT_DOUBLE_EQ(interpretStreamed(input, closures), 2.0);
+
+    // A return that ends a function call is not one of the program's
+    EXPECT_DOUBLE_EQ(interpretStreamed("function f() { return 1; } f(); 5;", interpreter), 5.0);
+    EXPECT_DOUBLE_EQ(interpretStreamed("function g() { return 1; } g(); 5;", vm), 5.0);
+    EXPECT_DOUBLE_EQ(interpretStreamed("function h() { return 1; } h(); 5;", closures), 5.0);
+}
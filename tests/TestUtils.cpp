@@ -16,14 +16,6 @@ double interpretInput(const std::string& input) {
     return interpreter.interpret(tree);
 }
 
-// Helper function to interpret an input string and return the result
-double interpretInput(const std::string& input, Interpreter& interpreter) {
-    Lexer lexer(input);
-    Parser parser(lexer);
-    ASTPtr tree = parser.parse();
-    return interpreter.interpret(tree);
-}
-
 // Helper function to tokenize an entire input string
 std::vector<Token> tokenize(const std::string& input) {
     Lexer lexer(input);
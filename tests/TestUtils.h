@@ -1,15 +1,73 @@
 #ifndef TEST_UTILS_H
 #define TEST_UTILS_H
 
+#include <gtest/gtest.h>
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/ast.h"
 #include "../include/interpreter.h"
+#include "../include/vm.h"
+#include "../include/closurecompiler.h"
 #include <memory>
+#include <string>
+#include <type_traits>
 
 ASTPtr parseInput(const std::string& input);
 double interpretInput(const std::string& input);
-double interpretInput(const std::string& input, Interpreter& interpreter);
 std::vector<Token> tokenize(const std::string& input);
 
+// Helper function to run an input string on an existing backend and return the result
+template <typename Backend>
+double interpretInput(const std::string& input, Backend& backend) {
+    Lexer lexer(input);
+    Parser parser(lexer);
+    ASTPtr tree = parser.parse();
+    return backend.interpret(tree);
+}
+
+// Helper function to run an input string on a fresh backend and return the result
+template <typename Backend>
+double interpretInput(const std::string& input) {
+    Backend backend;
+    return interpretInput(input, backend);
+}
+
+// Interpreter that compiles every function to native code on its first call
+class JitInterpreter : public Interpreter {
+public:
+    JitInterpreter() { enableJit(1); }
+};
+
+// Execution backends the interpreter and function suites run against
+using Backends = ::testing::Types<Interpreter, VirtualMachine, JitInterpreter, ClosureCompiler>;
+
+class BackendNames {
+public:
+    template <typename Backend>
+    static std::string GetName(int) {
+        if (std::is_same<Backend, VirtualMachine>::value) {
+            return "VirtualMachine";
+        }
+        if (std::is_same<Backend, ClosureCompiler>::value) {
+            return "ClosureCompiler";
+        }
+        return std::is_same<Backend, JitInterpreter>::value ? "JitInterpreter" : "Interpreter";
+    }
+};
+
+template <typename Backend>
+class InterpreterTest : public ::testing::Test {};
+
+template <typename Backend>
+class FunctionTest : public ::testing::Test {};
+
+template <typename Backend>
+class LoopTest : public ::testing::Test {};
+
+// Arrays run in the Interpreter, with and without native code for the numeric functions
+using ArrayBackends = ::testing::Types<Interpreter, JitInterpreter>;
+
+template <typename Backend>
+class ArrayTest : public ::testing::Test {};
+
 #endif // TEST_UTILS_H
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/interpreter.h"
+#include "../include/vm.h"
+#include "../include/bytecodecompiler.h"
+#include "TestUtils.h"
+
+// Runs the input on both backends and checks they agree on the program result
+static double interpretOnBothBackends(const std::string& input) {
+    double expected = interpretInput<Interpreter>(input);
+    double actual = interpretInput<VirtualMachine>(input);
+    EXPECT_EQ(actual, expected);
+    return actual;
+}
+
+TEST(VMTest, FunctionWithoutReturnYieldsLastStatement) {
+    std::string input = R"(
+        function f(a) {
+            b = a * 2;
+            b + 1;
+        }
+        f(4);
+    )";
+    EXPECT_DOUBLE_EQ(interpretOnBothBackends(input), 9.0);
+}
+
+TEST(VMTest, IfWithoutElseYieldsZero) {
+    std::string input = R"(
+        a = 1;
+        if (a > 2) {
+            a = 5;
+        }
+    )";
+    EXPECT_DOUBLE_EQ(interpretOnBothBackends(input), 0.0);
+}
+
+TEST(VMTest, CalleeDoesNotSeeCallerLocals) {
+    std::string input = R"(
+        x = 1;
+        function inner() {
+            return x;
+        }
+        function outer() {
+            x = 7;
+            return inner();
+        }
+        outer() * 10 + inner();
+    )";
+    EXPECT_DOUBLE_EQ(interpretOnBothBackends(input), 11.0);
+}
+
+TEST(VMTest, LocalReadBeforeAssignmentFallsBackToGlobal) {
+    std::string input = R"(
+        y = 3;
+        function f() {
+            y = y + 1;
+            return y;
+        }
+        f() + y;
+    )";
+    EXPECT_DOUBLE_EQ(interpretOnBothBackends(input), 7.0);
+}
+
+TEST(VMTest, RedefinitionAppliesToLaterCalls) {
+    std::string input = R"(
+        function f() {
+            return 1;
+        }
+        a = f();
+        function f() {
+            return 2;
+        }
+        a * 10 + f();
+    )";
+    EXPECT_DOUBLE_EQ(interpretOnBothBackends(input), 12.0);
+}
+
+TEST(VMTest, RecursionDepthLimitMatchesInterpreter) {
+    std::string function = R"(
+        function count(n) {
+            if (n == 0) {
+                return 0;
+            } else {
+                return 1 + count(n - 1);
+            }
+        }
+    )";
+    EXPECT_DOUBLE_EQ(interpretOnBothBackends(function + "count(999);"), 999.0);
+    EXPECT_THROW(interpretInput<Interpreter>(function + "count(1000);"), std::runtime_error);
+    EXPECT_THROW(interpretInput<VirtualMachine>(function + "count(1000);"), std::runtime_error);
+}
+
+TEST(VMTest, ReportsArgumentCountMismatch) {
+    std::string input = R"(
+        function f(a, b) {
+            return a + b;
+        }
+        f(1);
+    )";
+    EXPECT_THROW(interpretInput<VirtualMachine>(input), std::runtime_error);
+}
+
+TEST(VMTest, KeepsFunctionsAcrossPrograms) {
+    VirtualMachine vm;
+    interpretInput("function square(n) { return n * n; }", vm);
+    EXPECT_DOUBLE_EQ(interpretInput("square(9);", vm), 81.0);
+}
+
+TEST(VMTest, CompilesCallsAndLocalsToSlots) {
+    ASTPtr tree = parseInput(R"(
+        function add(a, b) {
+            c = a + b;
+            return c;
+        }
+    )");
+    std::vector<std::unique_ptr<FunctionProto>> functions;
+    SymbolSlots globalSlots;
+    SymbolSlots functionSlots;
+    BytecodeCompiler compiler(functions, globalSlots, functionSlots);
+    compiler.compile(tree.get());
+
+    ASSERT_EQ(functions.size(), 1);
+    EXPECT_EQ(functions[0]->arity, 2);
+    EXPECT_EQ(functions[0]->numLocals, 3);
+    std::string listing = disassemble(*functions[0]);
+    EXPECT_NE(listing.find("STORE_LOCAL 2 (c)"), std::string::npos) << listing;
+    EXPECT_EQ(listing.find("LOAD_GLOBAL"), std::string::npos) << listing;
+}
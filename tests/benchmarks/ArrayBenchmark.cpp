@@ -0,0 +1,62 @@
+// Dot products and element-wise arithmetic over arrays the host provides,
+// written as a loop over the elements and as whole-array operations. The loop
+// dispatches several nodes per element; the whole-array forms run one kernel.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "BenchUtils.h"
+#include "../../include/interpreter.h"
+
+namespace {
+
+const std::string LOOP_DOT = R"(
+    function loopDot(a, b) {
+        total = 0;
+        for (i = 0; i < len(a); i = i + 1) {
+            total = total + a[i] * b[i];
+        }
+        return total;
+    }
+    loopDot(xs, ys);
+)";
+
+const std::string ARRAY_DOT = "dot(xs, ys);";
+
+const std::string ARRAY_AXPY = "sum(xs * 2.5 + ys);";
+
+void runArrays(benchmark::State& state, const std::string& source) {
+    size_t n = static_cast<size_t>(state.range(0));
+    std::vector<double> xs(n);
+    std::vector<double> ys(n);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = static_cast<double>(i % 17) * 0.5;
+        ys[i] = static_cast<double>(i % 13) - 6.0;
+    }
+    ASTPtr tree = parseSource(source);
+    Interpreter interpreter;
+    interpreter.setArray("xs", xs);
+    interpreter.setArray("ys", ys);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(interpreter.interpret(tree));
+    }
+    state.counters["elements/s"] = benchmark::Counter(static_cast<double>(n) * state.iterations(),
+                                                      benchmark::Counter::kIsRate);
+}
+
+void BM_LoopDot(benchmark::State& state) {
+    runArrays(state, LOOP_DOT);
+}
+
+void BM_ArrayDot(benchmark::State& state) {
+    runArrays(state, ARRAY_DOT);
+}
+
+void BM_ArrayAxpy(benchmark::State& state) {
+    runArrays(state, ARRAY_AXPY);
+}
+
+} // namespace
+
+BENCHMARK(BM_LoopDot)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ArrayDot)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ArrayAxpy)->Arg(100000)->Unit(benchmark::kMicrosecond);
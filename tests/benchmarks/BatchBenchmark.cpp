@@ -0,0 +1,58 @@
+// Throughput of the batch runner by worker count. Scaling is measured in wall
+// time, so compare scripts/s across worker counts on an otherwise idle machine.
+//
+// Also the cost of one script in a process that has interned many names
+// before, as a long batch or REPL session does. It should not depend on them.
+
+#include <benchmark/benchmark.h>
+#include <thread>
+#include "BenchUtils.h"
+#include "../../include/batchrunner.h"
+#include "../../include/closurecompiler.h"
+#include "../../include/interner.h"
+#include "../../include/interpreter.h"
+#include "../../include/vm.h"
+
+namespace {
+
+void BM_Batch(benchmark::State& state) {
+    std::vector<std::pair<std::string, std::string>> scripts;
+    for (int i = 0; i < 256; ++i) {
+        scripts.emplace_back("script" + std::to_string(i), fibSource(12 + i % 4));
+    }
+    BatchRunner runner(static_cast<unsigned>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(runner.runSources(scripts));
+    }
+    state.counters["scripts/s"] = benchmark::Counter(static_cast<double>(scripts.size() * state.iterations()),
+                                                     benchmark::Counter::kIsRate);
+}
+
+template <typename Backend>
+void BM_ScriptAfterInterning(benchmark::State& state) {
+    std::string earlier = std::to_string(state.range(0));
+    for (int i = 0; i < state.range(0); ++i) {
+        intern("earlier" + std::to_string(i));
+    }
+    // Names interned after the earlier ones, so their symbols are the largest
+    std::string suffix = "_after_" + earlier;
+    ASTPtr tree = parseSource("function scale" + suffix + "(x) { return x * factor" + suffix + "; } factor" + suffix +
+                              " = 3; scale" + suffix + "(14);");
+    for (auto _ : state) {
+        Backend backend;
+        benchmark::DoNotOptimize(backend.interpret(tree));
+    }
+    state.counters["scripts/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                     benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+BENCHMARK(BM_Batch)
+    ->RangeMultiplier(2)
+    ->Range(1, std::max(4u, std::thread::hardware_concurrency()))
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ScriptAfterInterning, Interpreter)->Arg(0)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_ScriptAfterInterning, VirtualMachine)->Arg(0)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_ScriptAfterInterning, ClosureCompiler)->Arg(0)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
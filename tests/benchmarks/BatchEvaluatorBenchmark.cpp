@@ -0,0 +1,70 @@
+// Rows per second for one function over columns of arguments, called once per
+// row and evaluated as columns.
+
+#include <benchmark/benchmark.h>
+#include "BenchUtils.h"
+#include "../../include/interpreter.h"
+
+namespace {
+
+const char* const PROGRAM = R"(
+    function price(base, qty) {
+        total = base * qty;
+        if (qty >= 10) {
+            total = total * 0.9;
+        }
+        if (total > 500) {
+            return total - 25;
+        }
+        total + 4.5;
+    }
+)";
+
+constexpr size_t ROWS = 100000;
+
+struct PriceFixture {
+    ASTPtr tree;
+    Interpreter interpreter;
+    std::vector<double> base;
+    std::vector<double> qty;
+    std::vector<double> out;
+
+    PriceFixture() : base(ROWS), qty(ROWS), out(ROWS) {
+        Lexer lexer(PROGRAM);
+        Parser parser(lexer);
+        tree = parser.parse();
+        interpreter.interpret(tree);
+        for (size_t i = 0; i < ROWS; ++i) {
+            base[i] = 1.0 + static_cast<double>(i % 250) * 0.5;
+            qty[i] = static_cast<double>(i % 20);
+        }
+    }
+};
+
+void BM_EvaluatePerRow(benchmark::State& state) {
+    PriceFixture fixture;
+    for (auto _ : state) {
+        for (size_t i = 0; i < ROWS; ++i) {
+            fixture.out[i] = fixture.interpreter.call("price", {fixture.base[i], fixture.qty[i]});
+        }
+        benchmark::DoNotOptimize(fixture.out.data());
+    }
+    state.counters["rows/s"] =
+        benchmark::Counter(static_cast<double>(ROWS * state.iterations()), benchmark::Counter::kIsRate);
+}
+
+void BM_EvaluateBatch(benchmark::State& state) {
+    PriceFixture fixture;
+    for (auto _ : state) {
+        fixture.interpreter.evaluateBatch("price", {fixture.base.data(), fixture.qty.data()}, ROWS,
+                                          fixture.out.data());
+        benchmark::DoNotOptimize(fixture.out.data());
+    }
+    state.counters["rows/s"] =
+        benchmark::Counter(static_cast<double>(ROWS * state.iterations()), benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+BENCHMARK(BM_EvaluatePerRow)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EvaluateBatch)->Unit(benchmark::kMillisecond);
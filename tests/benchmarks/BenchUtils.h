@@ -0,0 +1,102 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <string>
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/ast.h"
+
+inline ASTPtr parseSource(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    return parser.parse();
+}
+
+// Nodes allocated for a tree returned by Parser::parse()
+inline size_t treeNodeCount(const ASTPtr& tree) {
+    const ASTArena* arena = tree.get_deleter().ownedArena;
+    return arena ? arena->nodeCount() : 0;
+}
+
+// Naive recursive fibonacci, the reference workload for call-heavy code
+inline std::string fibSource(int n) {
+    return R"(
+        function fib(n) {
+            if (n < 2) {
+                return n;
+            } else {
+                return fib(n - 1) + fib(n - 2);
+            }
+        }
+        fib()" + std::to_string(n) + ");";
+}
+
+// Number of fib() invocations performed by fib(n)
+inline long long fibCalls(int n) {
+    long long a = 1, b = 1;
+    for (int i = 1; i < n; ++i) {
+        long long next = a + b + 1;
+        a = b;
+        b = next;
+    }
+    return b;
+}
+
+// Statements that each combine `terms` operands with every arithmetic operator
+inline std::string wideExpressionSource(int statements, int terms) {
+    static const char* ops[] = {" + ", " * ", " - ", " / ", " % "};
+    std::string source = "x = 3; y = 7;\n";
+    for (int s = 0; s < statements; ++s) {
+        source += "z = x";
+        for (int t = 1; t < terms; ++t) {
+            source += ops[t % 5];
+            source += (t % 3 == 0) ? "y" : std::to_string(t % 9 + 1) + ".5";
+        }
+        source += ";\n";
+    }
+    return source;
+}
+
+// Statements whose expressions nest parentheses `depth` levels deep
+inline std::string deepNestingSource(int statements, int depth) {
+    std::string expression = "x";
+    for (int d = 0; d < depth; ++d) {
+        expression = "(" + expression + (d % 2 ? " * 1.5)" : " - 2)");
+    }
+    std::string source = "x = 1;\n";
+    for (int s = 0; s < statements; ++s) {
+        source += "y = " + expression + ";\n";
+    }
+    return source;
+}
+
+// `count` distinct function definitions, each called once afterwards
+inline std::string manyFunctionsSource(int count) {
+    std::string source;
+    for (int i = 0; i < count; ++i) {
+        std::string n = std::to_string(i);
+        source += "function f" + n + "(a, b) { c = a * b + " + n + "; if (c > 10) { return c - b; } return c; }\n";
+    }
+    for (int i = 0; i < count; ++i) {
+        source += "r = f" + std::to_string(i) + "(" + std::to_string(i % 7) + ", 3);\n";
+    }
+    return source;
+}
+
+// Chains of returns 900 frames deep, run `chains` times
+inline std::string countdownSource(int chains) {
+    std::string source = R"(
+        function down(n) {
+            if (n == 0) {
+                return 0;
+            }
+            return down(n - 1);
+        }
+    )";
+    for (int i = 0; i < chains; ++i) {
+        source += "down(900);\n";
+    }
+    return source;
+}
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,132 @@
+// Measures the cost of picking a visit method for an AST node.
+//
+// The legacy dispatcher below mirrors the dynamic_cast chain Interpreter::visit
+// used before nodes carried a NodeType tag, so both strategies can be compared
+// on the same node stream in one run.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "BenchUtils.h"
+
+namespace {
+
+void collectNodes(AST* node, std::vector<AST*>& out) {
+    if (!node) {
+        return;
+    }
+    out.push_back(node);
+    switch (node->type) {
+        case NodeType::BIN_OP: {
+            auto binOp = static_cast<BinOp*>(node);
+            collectNodes(binOp->left.get(), out);
+            collectNodes(binOp->right.get(), out);
+            break;
+        }
+        case NodeType::UNARY_OP:
+            collectNodes(static_cast<UnaryOp*>(node)->expr.get(), out);
+            break;
+        case NodeType::COMPOUND:
+            for (auto& child : static_cast<Compound*>(node)->children) {
+                collectNodes(child.get(), out);
+            }
+            break;
+        case NodeType::ASSIGN: {
+            auto assign = static_cast<Assign*>(node);
+            collectNodes(assign->left.get(), out);
+            collectNodes(assign->right.get(), out);
+            break;
+        }
+        case NodeType::FUNCTION_DEF:
+            collectNodes(static_cast<FunctionDef*>(node)->body.get(), out);
+            break;
+        case NodeType::FUNCTION_CALL:
+            for (auto& arg : static_cast<FunctionCall*>(node)->args) {
+                collectNodes(arg.get(), out);
+            }
+            break;
+        case NodeType::CLASS_DEF:
+            for (auto& method : static_cast<ClassDef*>(node)->methods) {
+                collectNodes(method.get(), out);
+            }
+            break;
+        case NodeType::RETURN:
+            collectNodes(static_cast<Return*>(node)->expr.get(), out);
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto ifNode = static_cast<IfStatement*>(node);
+            collectNodes(ifNode->condition.get(), out);
+            collectNodes(ifNode->thenBranch.get(), out);
+            collectNodes(ifNode->elseBranch.get(), out);
+            break;
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto whileNode = static_cast<WhileStatement*>(node);
+            collectNodes(whileNode->condition.get(), out);
+            collectNodes(whileNode->body.get(), out);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int legacyDispatch(AST* node) {
+    if (dynamic_cast<BinOp*>(node)) return 0;
+    if (dynamic_cast<Num*>(node)) return 1;
+    if (dynamic_cast<UnaryOp*>(node)) return 2;
+    if (dynamic_cast<Assign*>(node)) return 3;
+    if (dynamic_cast<Var*>(node)) return 4;
+    if (dynamic_cast<NoOp*>(node)) return 5;
+    if (dynamic_cast<Compound*>(node)) return 6;
+    if (dynamic_cast<FunctionDef*>(node)) return 7;
+    if (dynamic_cast<FunctionCall*>(node)) return 8;
+    if (dynamic_cast<ClassDef*>(node)) return 9;
+    if (dynamic_cast<Return*>(node)) return 10;
+    if (dynamic_cast<IfStatement*>(node)) return 11;
+    if (dynamic_cast<WhileStatement*>(node)) return 12;
+    if (dynamic_cast<ArrayLiteral*>(node)) return 13;
+    if (dynamic_cast<Index*>(node)) return 14;
+    return -1;
+}
+
+int taggedDispatch(AST* node) {
+    switch (node->type) {
+        case NodeType::BIN_OP: return 0;
+        case NodeType::NUM: return 1;
+        case NodeType::UNARY_OP: return 2;
+        case NodeType::ASSIGN: return 3;
+        case NodeType::VAR: return 4;
+        case NodeType::NO_OP: return 5;
+        case NodeType::COMPOUND: return 6;
+        case NodeType::FUNCTION_DEF: return 7;
+        case NodeType::FUNCTION_CALL: return 8;
+        case NodeType::CLASS_DEF: return 9;
+        case NodeType::RETURN: return 10;
+        case NodeType::IF_STATEMENT: return 11;
+        case NodeType::WHILE_STATEMENT: return 12;
+        case NodeType::ARRAY_LITERAL: return 13;
+        case NodeType::INDEX: return 14;
+    }
+    return -1;
+}
+
+template <int (*Dispatch)(AST*)>
+void BM_Dispatch(benchmark::State& state) {
+    ASTPtr tree = parseSource(fibSource(25));
+    std::vector<AST*> nodes;
+    collectNodes(tree.get(), nodes);
+
+    for (auto _ : state) {
+        long long total = 0;
+        for (AST* node : nodes) {
+            total += Dispatch(node);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * nodes.size()));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Dispatch, legacyDispatch)->Name("BM_Dispatch/dynamic_cast");
+BENCHMARK_TEMPLATE(BM_Dispatch, taggedDispatch)->Name("BM_Dispatch/NodeType");
@@ -0,0 +1,65 @@
+// Calling one function of an embedded program: running a whole program per
+// call, as interpret() requires, against calls through a compiled Program.
+//
+// Also a context created per call in a process that has interned many names,
+// as a host handing each request a fresh context does. It should not depend on
+// them.
+
+#include <benchmark/benchmark.h>
+#include "BenchUtils.h"
+#include "../../include/interner.h"
+#include "../../include/interpreter.h"
+#include "../../include/program.h"
+
+namespace {
+
+const char* const LIBRARY = R"(
+    function price(base, qty) {
+        total = base * qty;
+        if (qty >= 10) {
+            total = total * 0.9;
+        }
+        return total + 4.5;
+    }
+)";
+
+void BM_InterpretPerCall(benchmark::State& state) {
+    std::string source = std::string(LIBRARY) + "price(12.5, 14);";
+    for (auto _ : state) {
+        Interpreter interpreter;
+        ASTPtr tree = parseSource(source);
+        benchmark::DoNotOptimize(interpreter.interpret(tree));
+    }
+}
+
+void BM_ProgramCall(benchmark::State& state) {
+    std::shared_ptr<const Program> program = Program::compile(LIBRARY);
+    ExecutionContext context(program);
+    double args[] = {12.5, 14};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(context.call("price", args, 2));
+    }
+}
+
+void BM_ContextAfterInterning(benchmark::State& state) {
+    std::string earlier = std::to_string(state.range(0));
+    for (int i = 0; i < state.range(0); ++i) {
+        intern("earlier" + std::to_string(i));
+    }
+    // Names interned after the earlier ones, so their symbols are the largest
+    std::string suffix = "_after_" + earlier;
+    std::shared_ptr<const Program> program = Program::compile(
+        "factor" + suffix + " = 3; function scale" + suffix + "(x) { return x * factor" + suffix + "; }");
+    std::string function = "scale" + suffix;
+    double args[] = {14};
+    for (auto _ : state) {
+        ExecutionContext context(program);
+        benchmark::DoNotOptimize(context.call(function, args, 1));
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_InterpretPerCall);
+BENCHMARK(BM_ProgramCall);
+BENCHMARK(BM_ContextAfterInterning)->Arg(0)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
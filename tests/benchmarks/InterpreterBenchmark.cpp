@@ -0,0 +1,77 @@
+// End-to-end execution of parsed programs on each backend. Trees are parsed
+// once; every iteration runs them on a fresh backend.
+
+#include <benchmark/benchmark.h>
+#include "BenchUtils.h"
+#include "../../include/interpreter.h"
+#include "../../include/vm.h"
+#include "../../include/closurecompiler.h"
+
+namespace {
+
+// Interpreter with native compilation at the default hot threshold
+class JitInterpreter : public Interpreter {
+public:
+    JitInterpreter() { enableJit(); }
+};
+
+template <typename Backend>
+void runAll(benchmark::State& state, const std::string& source) {
+    ASTPtr tree = parseSource(source);
+    for (auto _ : state) {
+        Backend backend;
+        benchmark::DoNotOptimize(backend.interpret(tree));
+    }
+}
+
+template <typename Backend>
+void BM_Fib(benchmark::State& state) {
+    int n = static_cast<int>(state.range(0));
+    runAll<Backend>(state, fibSource(n));
+    state.counters["calls/s"] = benchmark::Counter(static_cast<double>(fibCalls(n) * state.iterations()),
+                                                   benchmark::Counter::kIsRate);
+}
+
+// Returns unwinding long call chains
+template <typename Backend>
+void BM_Countdown(benchmark::State& state) {
+    int chains = static_cast<int>(state.range(0));
+    runAll<Backend>(state, countdownSource(chains));
+    state.counters["calls/s"] = benchmark::Counter(static_cast<double>(chains * 901LL * state.iterations()),
+                                                   benchmark::Counter::kIsRate);
+}
+
+template <typename Backend>
+void BM_WideExpressions(benchmark::State& state) {
+    runAll<Backend>(state, wideExpressionSource(200, static_cast<int>(state.range(0))));
+}
+
+template <typename Backend>
+void BM_DeepNesting(benchmark::State& state) {
+    runAll<Backend>(state, deepNestingSource(20, static_cast<int>(state.range(0))));
+}
+
+template <typename Backend>
+void BM_ManyFunctions(benchmark::State& state) {
+    runAll<Backend>(state, manyFunctionsSource(static_cast<int>(state.range(0))));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Fib, Interpreter)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Fib, VirtualMachine)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Fib, JitInterpreter)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Fib, ClosureCompiler)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Countdown, Interpreter)->Arg(50)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Countdown, VirtualMachine)->Arg(50)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Countdown, JitInterpreter)->Arg(50)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Countdown, ClosureCompiler)->Arg(50)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WideExpressions, Interpreter)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(BM_WideExpressions, VirtualMachine)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(BM_WideExpressions, ClosureCompiler)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(BM_DeepNesting, Interpreter)->Arg(64)->Arg(512);
+BENCHMARK_TEMPLATE(BM_DeepNesting, VirtualMachine)->Arg(64)->Arg(512);
+BENCHMARK_TEMPLATE(BM_DeepNesting, ClosureCompiler)->Arg(64)->Arg(512);
+BENCHMARK_TEMPLATE(BM_ManyFunctions, Interpreter)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ManyFunctions, VirtualMachine)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ManyFunctions, ClosureCompiler)->Arg(1000);
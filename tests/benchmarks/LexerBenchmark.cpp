@@ -0,0 +1,63 @@
+// Lexer::getNextToken throughput, in tokens and bytes per second.
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "BenchUtils.h"
+#include "../../include/sourcefile.h"
+
+namespace {
+
+const char* STATEMENT =
+    "function compute_value(alpha, beta) { gamma = alpha * 2.5 + beta - 3; "
+    "if (gamma >= 4) { return gamma * (alpha - 1); } else { return -gamma; } }\n";
+
+void lexAll(benchmark::State& state, std::string_view text) {
+    size_t tokens = 0;
+    for (auto _ : state) {
+        Lexer lexer(text);
+        size_t count = 0;
+        while (lexer.getNextToken().type != TokenType::END_OF_FILE) {
+            ++count;
+        }
+        tokens += count;
+        benchmark::DoNotOptimize(count);
+    }
+    state.counters["tokens/s"] = benchmark::Counter(static_cast<double>(tokens), benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+
+void BM_LexFib(benchmark::State& state) {
+    lexAll(state, fibSource(25));
+}
+
+void BM_LexWideExpressions(benchmark::State& state) {
+    lexAll(state, wideExpressionSource(200, static_cast<int>(state.range(0))));
+}
+
+void BM_LexManyFunctions(benchmark::State& state) {
+    lexAll(state, manyFunctionsSource(static_cast<int>(state.range(0))));
+}
+
+// A generated script of state.range(0) MiB, mapped with SourceFile
+void BM_LexMappedFile(benchmark::State& state) {
+    std::string path = (std::filesystem::temp_directory_path() / "lexer_benchmark_input.txt").string();
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::string line = STATEMENT;
+        for (int64_t written = 0; written < (state.range(0) << 20); written += line.size()) {
+            out << line;
+        }
+    }
+    SourceFile source = SourceFile::map(path);
+    lexAll(state, source.text());
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+BENCHMARK(BM_LexFib);
+BENCHMARK(BM_LexWideExpressions)->Arg(16)->Arg(256);
+BENCHMARK(BM_LexManyFunctions)->Arg(1000);
+BENCHMARK(BM_LexMappedFile)->Arg(16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,89 @@
+// A one-million-iteration summation written as a while loop, a for loop and
+// the tail recursion scripts had to use before loops existed. Plain recursion
+// is not an option: it stops at the recursion limit of 1000 calls.
+
+#include <benchmark/benchmark.h>
+#include "BenchUtils.h"
+#include "../../include/interpreter.h"
+#include "../../include/vm.h"
+#include "../../include/closurecompiler.h"
+
+namespace {
+
+// Interpreter with native compilation at the default hot threshold
+class JitInterpreter : public Interpreter {
+public:
+    JitInterpreter() { enableJit(); }
+};
+
+constexpr int ITERATIONS = 1000000;
+
+const std::string WHILE_SUM = R"(
+    function sum(n) {
+        total = 0;
+        i = 0;
+        while (i < n) {
+            i = i + 1;
+            total = total + i;
+        }
+        return total;
+    }
+    sum()" + std::to_string(ITERATIONS) + ");";
+
+const std::string FOR_SUM = R"(
+    function sum(n) {
+        total = 0;
+        for (i = 1; i <= n; i = i + 1) {
+            total = total + i;
+        }
+        return total;
+    }
+    sum()" + std::to_string(ITERATIONS) + ");";
+
+const std::string RECURSIVE_SUM = R"(
+    function sum(n, total) {
+        if (n == 0) {
+            return total;
+        }
+        return sum(n - 1, total + n);
+    }
+    sum()" + std::to_string(ITERATIONS) + ", 0);";
+
+template <typename Backend>
+void runSum(benchmark::State& state, const std::string& source) {
+    ASTPtr tree = parseSource(source);
+    for (auto _ : state) {
+        Backend backend;
+        benchmark::DoNotOptimize(backend.interpret(tree));
+    }
+    state.counters["iterations/s"] = benchmark::Counter(static_cast<double>(ITERATIONS) * state.iterations(),
+                                                        benchmark::Counter::kIsRate);
+}
+
+template <typename Backend>
+void BM_WhileSum(benchmark::State& state) {
+    runSum<Backend>(state, WHILE_SUM);
+}
+
+template <typename Backend>
+void BM_ForSum(benchmark::State& state) {
+    runSum<Backend>(state, FOR_SUM);
+}
+
+template <typename Backend>
+void BM_RecursiveSum(benchmark::State& state) {
+    runSum<Backend>(state, RECURSIVE_SUM);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_WhileSum, Interpreter)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WhileSum, VirtualMachine)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WhileSum, JitInterpreter)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WhileSum, ClosureCompiler)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ForSum, Interpreter)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ForSum, ClosureCompiler)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RecursiveSum, Interpreter)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RecursiveSum, VirtualMachine)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RecursiveSum, JitInterpreter)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RecursiveSum, ClosureCompiler)->Unit(benchmark::kMillisecond);
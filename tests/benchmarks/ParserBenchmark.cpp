@@ -0,0 +1,41 @@
+// Parser::parse throughput, in AST nodes per second. Lexing is included, since
+// the parser pulls tokens on demand.
+
+#include <benchmark/benchmark.h>
+#include "BenchUtils.h"
+
+namespace {
+
+void parseAll(benchmark::State& state, const std::string& source) {
+    size_t nodes = 0;
+    for (auto _ : state) {
+        ASTPtr tree = parseSource(source);
+        nodes += treeNodeCount(tree);
+        benchmark::DoNotOptimize(tree.get());
+    }
+    state.counters["nodes/s"] = benchmark::Counter(static_cast<double>(nodes), benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * source.size()));
+}
+
+void BM_ParseFib(benchmark::State& state) {
+    parseAll(state, fibSource(25));
+}
+
+void BM_ParseWideExpressions(benchmark::State& state) {
+    parseAll(state, wideExpressionSource(200, static_cast<int>(state.range(0))));
+}
+
+void BM_ParseDeepNesting(benchmark::State& state) {
+    parseAll(state, deepNestingSource(20, static_cast<int>(state.range(0))));
+}
+
+void BM_ParseManyFunctions(benchmark::State& state) {
+    parseAll(state, manyFunctionsSource(static_cast<int>(state.range(0))));
+}
+
+} // namespace
+
+BENCHMARK(BM_ParseFib);
+BENCHMARK(BM_ParseWideExpressions)->Arg(16)->Arg(256);
+BENCHMARK(BM_ParseDeepNesting)->Arg(64)->Arg(512);
+BENCHMARK(BM_ParseManyFunctions)->Arg(1000);
@@ -0,0 +1,34 @@
+// Latency of one REPL snippet after sessions of different lengths. Each
+// earlier snippet defined a function and a global; the measured snippet calls
+// one of them and defines another, as an interactive session would. The time
+// per snippet should not grow with the history.
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include "../../include/interpreter.h"
+#include "../../include/repl.h"
+
+namespace {
+
+std::string historySnippet(int i) {
+    std::string n = std::to_string(i);
+    return "function step" + n + "(x) { return x * 2 + " + n + "; } value" + n + " = step" + n + "(" + n + ");";
+}
+
+void BM_SnippetAfterHistory(benchmark::State& state) {
+    int history = static_cast<int>(state.range(0));
+    Interpreter interpreter;
+    Repl repl(interpreter);
+    for (int i = 0; i < history; ++i) {
+        repl.run(historySnippet(i));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(repl.run("function latest(x) { return step0(x) + 1; } latest(value0);"));
+    }
+    state.counters["snippets/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                      benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+BENCHMARK(BM_SnippetAfterHistory)->Arg(10)->Arg(10000)->Unit(benchmark::kMicrosecond);
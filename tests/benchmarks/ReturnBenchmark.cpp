@@ -0,0 +1,184 @@
+// Measures script calls per second on functions that return on every call.
+//
+// The Interpreter propagates a return as a completion state: visitReturn
+// records it, compounds stop at it and the receiving call clears it. Before
+// that, every return threw an exception the call caught. The walker below runs
+// the subset of the language these workloads use with either mechanism, so the
+// two can be compared on the same trees in one run, next to the Interpreter.
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "BenchUtils.h"
+#include "../../include/interpreter.h"
+
+namespace {
+
+enum class ReturnMechanism {
+    EXCEPTION,
+    COMPLETION,
+};
+
+template <ReturnMechanism mechanism>
+class ReturnWalker {
+public:
+    double interpret(ASTPtr& tree) {
+        double result = visit(tree.get());
+        completion = Completion::NORMAL;
+        return result;
+    }
+
+private:
+    struct ReturnException {
+        double value;
+    };
+
+    enum class Completion {
+        NORMAL,
+        RETURN,
+    };
+
+    struct Frame {
+        const FunctionDef* function;
+        std::vector<double> args;
+    };
+
+    std::unordered_map<Symbol, const FunctionDef*> functions;
+    std::vector<Frame> frames;
+    Completion completion = Completion::NORMAL;
+
+    double visit(const AST* node) {
+        switch (node->type) {
+            case NodeType::NUM:
+                return static_cast<const Num*>(node)->value;
+            case NodeType::VAR:
+                return variable(static_cast<const Var*>(node));
+            case NodeType::BIN_OP:
+                return binary(static_cast<const BinOp*>(node));
+            case NodeType::COMPOUND:
+                return compound(static_cast<const Compound*>(node));
+            case NodeType::IF_STATEMENT:
+                return ifStatement(static_cast<const IfStatement*>(node));
+            case NodeType::RETURN:
+                return returnStatement(static_cast<const Return*>(node));
+            case NodeType::FUNCTION_DEF: {
+                auto function = static_cast<const FunctionDef*>(node);
+                functions[function->symbol] = function;
+                return 0.0;
+            }
+            case NodeType::FUNCTION_CALL:
+                return call(static_cast<const FunctionCall*>(node));
+            default:
+                throw std::runtime_error("Not used by the return workloads");
+        }
+    }
+
+    // Only parameters are read, so every variable is one of the innermost frame
+    double variable(const Var* node) {
+        if (frames.empty()) {
+            throw std::runtime_error("Not used by the return workloads");
+        }
+        const Frame& frame = frames.back();
+        const std::vector<Symbol>& params = frame.function->params;
+        auto param = std::find(params.begin(), params.end(), node->symbol);
+        return frame.args[static_cast<size_t>(param - params.begin())];
+    }
+
+    double binary(const BinOp* node) {
+        double left = visit(node->left.get());
+        double right = visit(node->right.get());
+        switch (node->op.type) {
+            case TokenType::PLUS: return left + right;
+            case TokenType::MINUS: return left - right;
+            case TokenType::LESS_THAN: return left < right ? 1.0 : 0.0;
+            case TokenType::EQUALS: return left == right ? 1.0 : 0.0;
+            default: throw std::runtime_error("Not used by the return workloads");
+        }
+    }
+
+    double compound(const Compound* node) {
+        double result = 0.0;
+        for (const auto& child : node->children) {
+            result = visit(child.get());
+            if (mechanism == ReturnMechanism::COMPLETION && completion != Completion::NORMAL) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    double ifStatement(const IfStatement* node) {
+        if (visit(node->condition.get()) != 0.0) {
+            return visit(node->thenBranch.get());
+        }
+        return node->elseBranch ? visit(node->elseBranch.get()) : 0.0;
+    }
+
+    double returnStatement(const Return* node) {
+        double value = visit(node->expr.get());
+        if (mechanism == ReturnMechanism::EXCEPTION) {
+            throw ReturnException{value};
+        }
+        completion = Completion::RETURN;
+        return value;
+    }
+
+    double call(const FunctionCall* node) {
+        Frame frame{functions.at(node->symbol), {}};
+        for (const auto& arg : node->args) {
+            frame.args.push_back(visit(arg.get()));
+        }
+        frames.push_back(std::move(frame));
+        double result;
+        if (mechanism == ReturnMechanism::EXCEPTION) {
+            try {
+                result = visit(frames.back().function->body.get());
+            } catch (const ReturnException& ret) {
+                result = ret.value;
+            }
+        } else {
+            result = visit(frames.back().function->body.get());
+            completion = Completion::NORMAL;
+        }
+        frames.pop_back();
+        return result;
+    }
+};
+
+using ExceptionReturns = ReturnWalker<ReturnMechanism::EXCEPTION>;
+using CompletionReturns = ReturnWalker<ReturnMechanism::COMPLETION>;
+
+template <typename Backend>
+void runCalls(benchmark::State& state, const std::string& source, long long calls) {
+    ASTPtr tree = parseSource(source);
+    for (auto _ : state) {
+        Backend backend;
+        benchmark::DoNotOptimize(backend.interpret(tree));
+    }
+    state.counters["calls/s"] = benchmark::Counter(static_cast<double>(calls * state.iterations()),
+                                                   benchmark::Counter::kIsRate);
+}
+
+template <typename Backend>
+void BM_FibReturns(benchmark::State& state) {
+    int n = static_cast<int>(state.range(0));
+    runCalls<Backend>(state, fibSource(n), fibCalls(n));
+}
+
+// Chains of returns 900 frames deep
+template <typename Backend>
+void BM_CountdownReturns(benchmark::State& state) {
+    int chains = static_cast<int>(state.range(0));
+    runCalls<Backend>(state, countdownSource(chains), chains * 901LL);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_FibReturns, ExceptionReturns)->Arg(22)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FibReturns, CompletionReturns)->Arg(22)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FibReturns, Interpreter)->Arg(22)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CountdownReturns, ExceptionReturns)->Arg(200)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CountdownReturns, CompletionReturns)->Arg(200)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CountdownReturns, Interpreter)->Arg(200)->Unit(benchmark::kMillisecond);
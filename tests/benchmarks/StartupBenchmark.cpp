@@ -0,0 +1,62 @@
+// Time from program text to an executable tree: lexing, parsing and optimizing
+// the source, against loading the program cache written for it. Both read the
+// source from a file, since checking the cache means hashing the source.
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include "BenchUtils.h"
+#include "../../include/optimizer.h"
+#include "../../include/programcache.h"
+#include "../../include/sourcefile.h"
+
+namespace {
+
+const char* STARTUP_SOURCE_PATH = "startup_benchmark_source.txt";
+
+// Large enough that per-run fixed costs do not dominate
+std::string startupSource() {
+    return manyFunctionsSource(2000) + wideExpressionSource(200, 64);
+}
+
+void writeSource(const std::string& source) {
+    std::ofstream(STARTUP_SOURCE_PATH, std::ios::binary | std::ios::trunc) << source;
+}
+
+void BM_StartupFromSource(benchmark::State& state) {
+    writeSource(startupSource());
+    for (auto _ : state) {
+        SourceFile source = SourceFile::map(STARTUP_SOURCE_PATH);
+        ASTPtr tree = parseSource(std::string(source.text()));
+        Optimizer optimizer;
+        optimizer.optimize(tree);
+        benchmark::DoNotOptimize(tree.get());
+    }
+    std::remove(STARTUP_SOURCE_PATH);
+}
+
+void BM_StartupFromCache(benchmark::State& state) {
+    writeSource(startupSource());
+    std::string cachePath = ProgramCache::cachePathFor(STARTUP_SOURCE_PATH);
+    {
+        SourceFile source = SourceFile::map(STARTUP_SOURCE_PATH);
+        ProgramCache::load(STARTUP_SOURCE_PATH, source.text(), true);
+    }
+    for (auto _ : state) {
+        SourceFile source = SourceFile::map(STARTUP_SOURCE_PATH);
+        ProgramCache::Status status;
+        ASTPtr tree = ProgramCache::load(STARTUP_SOURCE_PATH, source.text(), true, &status);
+        if (status != ProgramCache::Status::HIT) {
+            state.SkipWithError("Program cache missed");
+            break;
+        }
+        benchmark::DoNotOptimize(tree.get());
+    }
+    std::remove(cachePath.c_str());
+    std::remove(STARTUP_SOURCE_PATH);
+}
+
+} // namespace
+
+BENCHMARK(BM_StartupFromSource)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StartupFromCache)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,164 @@
+// Cost of script function calls: calls per second and heap allocations per
+// call on the recursion workloads of FunctionTests. Allocations are counted by
+// replacing the global allocation functions, every form of them, so this file
+// builds into an executable of its own, callframe_benchmarks, and the other
+// benchmarks run with the standard ones. Only allocations made while a run
+// is being measured are counted.
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "../BenchUtils.h"
+#include "../../../include/interpreter.h"
+#include "../../../include/closurecompiler.h"
+
+namespace {
+
+thread_local size_t allocations = 0;
+thread_local bool counting = false;
+
+void* allocate(std::size_t size, std::size_t alignment) {
+    if (counting) {
+        ++allocations;
+    }
+    size = size ? size : 1;
+    // aligned_alloc needs a size that is a multiple of the alignment
+    void* memory = alignment <= alignof(std::max_align_t)
+                       ? std::malloc(size)
+                       : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+// factorial(n) as in FunctionTests.HandlesRecursion, repeated so a run makes
+// `calls` calls in total
+std::string factorialSource(int n, int repeats) {
+    return R"(
+        function factorial(n) {
+            if (n == 0) {
+                return 1;
+            } else {
+                return n * factorial(n - 1);
+            }
+        }
+        function repeat(k, acc) {
+            if (k == 0) {
+                return acc;
+            }
+            return repeat(k - 1, acc + factorial()" + std::to_string(n) + R"());
+        }
+        repeat()" + std::to_string(repeats) + ", 0);";
+}
+
+template <typename Backend>
+void runCalls(benchmark::State& state, const std::string& source, long long calls) {
+    ASTPtr tree = parseSource(source);
+    size_t allocated = 0;
+    for (auto _ : state) {
+        Backend backend;
+        size_t before = allocations;
+        counting = true;
+        benchmark::DoNotOptimize(backend.interpret(tree));
+        counting = false;
+        allocated += allocations - before;
+    }
+    double total = static_cast<double>(calls) * static_cast<double>(state.iterations());
+    state.counters["calls/s"] = benchmark::Counter(total, benchmark::Counter::kIsRate);
+    state.counters["allocs/call"] = static_cast<double>(allocated) / total;
+}
+
+template <typename Backend>
+void BM_FactorialCalls(benchmark::State& state) {
+    int n = static_cast<int>(state.range(0));
+    int repeats = 1000;
+    runCalls<Backend>(state, factorialSource(n, repeats), static_cast<long long>(repeats) * (n + 2));
+}
+
+template <typename Backend>
+void BM_FibCalls(benchmark::State& state) {
+    int n = static_cast<int>(state.range(0));
+    runCalls<Backend>(state, fibSource(n), fibCalls(n));
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size, alignof(std::max_align_t));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size, alignof(std::max_align_t));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+// Every form of delete pairs with one of the forms of new above, which all allocate with malloc
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+BENCHMARK_TEMPLATE(BM_FactorialCalls, Interpreter)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FactorialCalls, ClosureCompiler)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FibCalls, Interpreter)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FibCalls, ClosureCompiler)->Arg(20)->Unit(benchmark::kMillisecond);